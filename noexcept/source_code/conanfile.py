@@ -7,13 +7,35 @@ required_conan_version = ">=2.0.14"
 
 class noexcept_application(ConanFile):
     settings = "compiler", "build_type", "os", "arch", "libc"
+    options = {
+        # "build_type" keeps the optimization flags of the CMake build type
+        "optimization": ["build_type", "Os", "O2", "O3"],
+        "lto": [True, False],
+        "gc_sections": [True, False],
+        # app.elf writes its results over semihosting, for QEMU runs
+        "semihosting": [True, False],
+        # Functions generated for workload.elf, 0 leaves it out
+        "workload_functions": ["ANY"],
+        # Further tools/generate_workload.py arguments
+        "workload_options": ["ANY"],
+    }
+    default_options = {
+        "optimization": "build_type",
+        "lto": False,
+        "gc_sections": False,
+        "semihosting": False,
+        "workload_functions": 0,
+        "workload_options": "",
+    }
 
     def build_requirements(self):
         self.tool_requires("cmake/3.27.1")
         self.tool_requires("libhal-cmake-util/[^4.0.0]")
 
     def requirements(self):
-        self.requires("prebuilt-picolibc/12.3")
+        # picolibc is built per GCC release, see profiles/ for the versions
+        compiler_version = str(self.settings.compiler.version)
+        self.requires(f"prebuilt-picolibc/{compiler_version}")
 
     def generate(self):
         virt = VirtualBuildEnv(self)
@@ -22,6 +44,17 @@ class noexcept_application(ConanFile):
         cmake.generate()
         tc = CMakeToolchain(self)
         tc.cache_variables["CONAN_LIBC"] = str(self.settings.libc)
+        tc.cache_variables["NOEXCEPT_OPTIMIZATION"] = str(
+            self.options.optimization)
+        tc.cache_variables["NOEXCEPT_LTO"] = bool(self.options.lto)
+        tc.cache_variables["NOEXCEPT_GC_SECTIONS"] = bool(
+            self.options.gc_sections)
+        tc.cache_variables["NOEXCEPT_SEMIHOSTING"] = bool(
+            self.options.semihosting)
+        tc.cache_variables["NOEXCEPT_WORKLOAD_FUNCTIONS"] = str(
+            self.options.workload_functions)
+        tc.cache_variables["NOEXCEPT_WORKLOAD_OPTIONS"] = str(
+            self.options.workload_options)
         tc.generate()
 
     def layout(self):
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+
+/**
+ * Atomically replace p_value with p_update(p_value)
+ *
+ * @return std::uint32_t - the value before the update
+ */
+template<typename Update>
+std::uint32_t
+atomic_update(std::atomic<std::uint32_t>& p_value, Update&& p_update) noexcept
+{
+#if defined(__ARM_ARCH_6M__)
+  // ARMv6-M has no exclusive load/store, so mask interrupts for the few
+  // instructions it takes to update the value instead.
+  std::uint32_t primask = 0;
+  asm volatile("mrs %0, primask\n\tcpsid i" : "=r"(primask) : : "memory");
+  const auto previous = p_value.load(std::memory_order_relaxed);
+  p_value.store(p_update(previous), std::memory_order_relaxed);
+  asm volatile("msr primask, %0" : : "r"(primask) : "memory");
+  return previous;
+#else
+  auto previous = p_value.load(std::memory_order_relaxed);
+  while (not p_value.compare_exchange_weak(previous,
+                                           p_update(previous),
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_relaxed)) {
+    continue;
+  }
+  return previous;
+#endif
+}
@@ -0,0 +1,25 @@
+/**
+ * @file baseline_main.cpp
+ * @brief Smallest image linked like app.elf, see README.md
+ *
+ * Built with -fno-exceptions, so it only holds the startup code, the parts of
+ * picolibc every image links and the linker script's own bytes.
+ * tools/footprint_report.py compares app.elf with it to find the library code
+ * that is only linked for the exception runtime.
+ */
+
+extern "C"
+{
+  void _exit([[maybe_unused]] int rc) // NOLINT
+  {
+    while (true) {
+      continue;
+    }
+  }
+}
+
+int
+main()
+{
+  return 0;
+}
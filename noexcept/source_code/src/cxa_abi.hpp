@@ -0,0 +1,70 @@
+#pragma once
+
+#include <exception>
+
+#include <unwind.h>
+
+// Layout of the headers libsupc++ places in front of every exception object.
+// The real definitions live in libsupc++'s private unwind-cxx.h, which is not
+// installed with the toolchain, so they are mirrored here field for field.
+// Only the layout matters, none of these are used to call into the runtime.
+
+struct cxa_exception_header
+{
+  void* exception_type;
+  void (*exception_destructor)(void*);
+  std::terminate_handler unexpected_handler;
+  std::terminate_handler terminate_handler;
+  cxa_exception_header* next_exception;
+  int handler_count;
+#if defined(__ARM_EABI_UNWINDER__)
+  cxa_exception_header* next_propagating_exception;
+  int propagation_count;
+#else
+  int handler_switch_value;
+  const unsigned char* action_record;
+  const unsigned char* language_specific_data;
+  _Unwind_Ptr catch_temp;
+  void* adjusted_ptr;
+#endif
+  _Unwind_Exception unwind_header;
+};
+
+/// Header returned ahead of the object by __cxa_allocate_exception
+struct cxa_refcounted_exception_header
+{
+  int reference_count;
+  cxa_exception_header exception;
+};
+
+/// Object returned by __cxa_allocate_dependent_exception
+struct cxa_dependent_exception_header
+{
+  void* primary_exception;
+  void (*exception_destructor)(void*);
+  std::terminate_handler unexpected_handler;
+  std::terminate_handler terminate_handler;
+  cxa_exception_header* next_exception;
+  int handler_count;
+#if defined(__ARM_EABI_UNWINDER__)
+  cxa_exception_header* next_propagating_exception;
+  int propagation_count;
+#else
+  int handler_switch_value;
+  const unsigned char* action_record;
+  const unsigned char* language_specific_data;
+  _Unwind_Ptr catch_temp;
+  void* adjusted_ptr;
+#endif
+  _Unwind_Exception unwind_header;
+};
+
+/**
+ * @param p_unwind_header - the unwinder's view of a C++ exception
+ * @return cxa_exception_header* - the C++ header that contains p_unwind_header
+ */
+inline cxa_exception_header*
+to_cxa_exception(_Unwind_Exception* p_unwind_header)
+{
+  return reinterpret_cast<cxa_exception_header*>(p_unwind_header + 1) - 1;
+}
@@ -0,0 +1,99 @@
+#include "cycle_counter.hpp"
+
+namespace cycle_counter {
+namespace {
+struct systick_t
+{
+  std::uint32_t control;
+  std::uint32_t reload;
+  std::uint32_t current;
+};
+
+struct dwt_t
+{
+  std::uint32_t control;
+  std::uint32_t cycle_count;
+};
+
+auto* const systick = reinterpret_cast<volatile systick_t*>(0xE000'E010);
+auto* const dwt = reinterpret_cast<volatile dwt_t*>(0xE000'1000);
+auto* const debug_exception_monitor_control =
+  reinterpret_cast<volatile std::uint32_t*>(0xE000'EDFC);
+
+constexpr std::uint32_t trace_enable = 1 << 24;
+constexpr std::uint32_t cycle_count_enable = 1 << 0;
+constexpr std::uint32_t systick_enable = 1 << 0;
+constexpr std::uint32_t systick_processor_clock = 1 << 2;
+constexpr std::uint32_t systick_mask = 0x00FF'FFFF;
+
+source active_source = source::systick;
+
+bool
+start_dwt() noexcept
+{
+  // Unimplemented debug registers read as zero, so a cycle counter that
+  // does not move means there is no DWT to use.
+  *debug_exception_monitor_control = *debug_exception_monitor_control |
+                                     trace_enable;
+  dwt->cycle_count = 0;
+  dwt->control = dwt->control | cycle_count_enable;
+
+  const std::uint32_t first = dwt->cycle_count;
+  for (int i = 0; i < 4; i++) {
+    asm volatile("nop");
+  }
+  return dwt->cycle_count != first;
+}
+
+void
+start_systick() noexcept
+{
+  systick->control = 0;
+  systick->reload = systick_mask;
+  systick->current = 0;
+  systick->control = systick_enable | systick_processor_clock;
+}
+} // namespace
+
+source
+enable() noexcept
+{
+  if (start_dwt()) {
+    active_source = source::dwt_cycles;
+  } else {
+    start_systick();
+    active_source = source::systick;
+  }
+  return active_source;
+}
+
+std::uint32_t
+now() noexcept
+{
+  if (active_source == source::dwt_cycles) {
+    return dwt->cycle_count;
+  }
+  // SysTick counts down, invert it so that every source counts up
+  return systick_mask - systick->current;
+}
+
+std::uint32_t
+elapsed(std::uint32_t p_start, std::uint32_t p_end) noexcept
+{
+  if (active_source == source::dwt_cycles) {
+    return p_end - p_start;
+  }
+  return (p_end - p_start) & systick_mask;
+}
+
+std::uint32_t
+to_instructions(std::uint32_t p_ticks,
+                std::uint32_t p_cpu_hz,
+                std::uint32_t p_icount_shift) noexcept
+{
+  constexpr std::uint64_t nanoseconds_per_second = 1'000'000'000;
+  const std::uint64_t nanoseconds =
+    (p_ticks * nanoseconds_per_second) / p_cpu_hz;
+  return static_cast<std::uint32_t>(nanoseconds >> p_icount_shift);
+}
+} // namespace cycle_counter
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+// Free running counter for timing short code paths on Cortex-M.
+//
+// The DWT cycle counter is used when the core implements it. QEMU does not
+// model the DWT, so there the SysTick timer is used instead. Under
+// `qemu-system-arm -icount shift=N` the virtual clock advances 2^N ns per
+// instruction, which turns SysTick ticks into a count of instructions retired.
+
+namespace cycle_counter {
+enum class source : std::uint8_t
+{
+  dwt_cycles,
+  systick,
+};
+
+/**
+ * Start the counter, must be called before now()
+ *
+ * @return source - the hardware selected to count
+ */
+source
+enable() noexcept;
+
+/**
+ * @return std::uint32_t - current count, only meaningful as an argument to
+ * elapsed()
+ */
+std::uint32_t
+now() noexcept;
+
+/**
+ * @param p_start - value returned by now() at the start of the interval
+ * @param p_end - value returned by now() at the end of the interval
+ * @return std::uint32_t - counts between p_start and p_end, SysTick intervals
+ * must be shorter than 2^24 ticks
+ */
+std::uint32_t
+elapsed(std::uint32_t p_start, std::uint32_t p_end) noexcept;
+
+/**
+ * Convert a SysTick interval measured under `-icount shift=p_icount_shift` to
+ * instructions retired
+ *
+ * @param p_ticks - interval returned by elapsed()
+ * @param p_cpu_hz - SysTick (core) clock of the emulated machine
+ * @param p_icount_shift - shift passed to -icount
+ * @return std::uint32_t - instructions executed during the interval
+ */
+std::uint32_t
+to_instructions(std::uint32_t p_ticks,
+                std::uint32_t p_cpu_hz,
+                std::uint32_t p_icount_shift) noexcept;
+} // namespace cycle_counter
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dtor_paths.hpp"
+#include "external.hpp"
+
+// Call chains of a chosen depth for deep_stack_benchmark.cpp. Every frame holds
+// Dtors dtor::non_trivial_dtor locals and ends in a call that can throw, so an
+// exception thrown by bar() at the bottom runs one cleanup pad of Dtors
+// destructors per frame.
+//
+//   - recursive_frame<Dtors>(depth): a single function calling itself, one
+//     exception index entry for every frame
+//   - templated_frame<Depth, Dtors>(): a distinct function for every frame,
+//     like a call chain through different functions
+//   - noexcept_frame<Dtors>(depth): a recursive chain entered through a
+//     noexcept frame, the exception ends in std::terminate
+
+namespace deep_stack {
+// side_effect counter written after every call, so no frame ends in a tail
+// call that would take it off the stack before the throw
+inline constexpr std::size_t after_call_counter = 11;
+
+/**
+ * Construct Count non_trivial_dtor locals in the frame of the caller, then
+ * call Next(p_args...). Inlined all the way, so the locals share the caller's
+ * cleanup pad, which destroys all of them.
+ */
+template<std::size_t Count, auto Next, typename... Args>
+[[gnu::always_inline]] inline void
+with_objects(Args... p_args)
+{
+  if constexpr (Count == 0) {
+    Next(p_args...);
+    side_effect[after_call_counter] = side_effect[after_call_counter] + 1;
+  } else {
+    dtor::non_trivial_dtor object;
+    object.noexcept_action();
+    with_objects<Count - 1, Next>(p_args...);
+  }
+}
+
+template<std::size_t Dtors>
+[[gnu::noinline]] void
+recursive_frame(std::uint32_t p_depth);
+
+template<std::size_t Dtors>
+[[gnu::always_inline]] inline void
+recursive_next(std::uint32_t p_depth)
+{
+  if (p_depth <= 1) {
+    bar();
+  } else {
+    recursive_frame<Dtors>(p_depth - 1);
+  }
+}
+
+template<std::size_t Dtors>
+[[gnu::noinline]] void
+recursive_frame(std::uint32_t p_depth)
+{
+  with_objects<Dtors, recursive_next<Dtors>>(p_depth);
+}
+
+template<std::uint32_t Depth, std::size_t Dtors>
+[[gnu::noinline]] void
+templated_frame();
+
+template<std::uint32_t Depth, std::size_t Dtors>
+[[gnu::always_inline]] inline void
+templated_next()
+{
+  if constexpr (Depth <= 1) {
+    bar();
+  } else {
+    templated_frame<Depth - 1, Dtors>();
+  }
+}
+
+template<std::uint32_t Depth, std::size_t Dtors>
+[[gnu::noinline]] void
+templated_frame()
+{
+  with_objects<Dtors, templated_next<Depth, Dtors>>();
+}
+
+template<std::size_t Dtors>
+[[gnu::noinline]] void
+noexcept_frame(std::uint32_t p_depth) noexcept
+{
+  with_objects<Dtors, recursive_next<Dtors>>(p_depth);
+}
+} // namespace deep_stack
@@ -0,0 +1,370 @@
+/**
+ * @file deep_stack_benchmark.cpp
+ * @brief Throw cost against unwind depth and destructors per frame
+ *
+ * Runs the call chains of deep_stack.hpp for every combination of depth and
+ * non_trivial_dtor locals per frame, with bar() at the bottom disarmed (happy
+ * path) and armed (throw path). Every run is timed and the stack used below
+ * the benchmark's frame is measured by painting. The cleanup pad of the
+ * repeated frame is located through its LSDA and measured to check the
+ * paper's size(n) = 4 + 6n bytes for n destructors.
+ *
+ * Results are written over semihosting to deep_stack.csv in the working
+ * directory of the emulator, one row per chain, destructor count and depth.
+ */
+#include <cinttypes>
+#include <csetjmp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include <cxxabi.h>
+
+#include "cycle_counter.hpp"
+#include "deep_stack.hpp"
+#include "exception_metadata.hpp"
+#include "exception_scan.hpp"
+#include "exhibits.hpp"
+#include "semihost.hpp"
+#include "stack_usage.hpp"
+#include "thumb2.hpp"
+
+#if not defined(NOEXCEPT_CPU_HZ)
+#define NOEXCEPT_CPU_HZ 120000000
+#endif
+
+#if not defined(NOEXCEPT_ICOUNT_SHIFT)
+#define NOEXCEPT_ICOUNT_SHIFT 4
+#endif
+
+extern "C"
+{
+  void _exit(int rc) // NOLINT
+  {
+    semihost::exit(rc);
+  }
+
+  void __cxa_end_cleanup(); // NOLINT
+}
+
+namespace {
+constexpr std::array<std::uint32_t, 8> depths{ 1, 2, 3, 4, 6, 8, 12, 16 };
+// Must start with 0, the cleanup cost is measured against the chain without
+// destructors
+constexpr std::array<std::size_t, 6> dtor_counts{ 0, 1, 2, 3, 4, 8 };
+
+using recursive_chain = void (*)(std::uint32_t);
+using templated_chain = void (*)();
+
+constexpr auto recursive_chains =
+  []<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array<recursive_chain, sizeof...(I)>{
+      &deep_stack::recursive_frame<dtor_counts[I]>...
+    };
+  }(std::make_index_sequence<dtor_counts.size()>{});
+
+constexpr auto noexcept_chains =
+  []<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array<recursive_chain, sizeof...(I)>{
+      &deep_stack::noexcept_frame<dtor_counts[I]>...
+    };
+  }(std::make_index_sequence<dtor_counts.size()>{});
+
+template<std::size_t Dtors>
+constexpr auto
+templated_chains_with()
+{
+  return []<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array<templated_chain, sizeof...(I)>{
+      &deep_stack::templated_frame<depths[I], Dtors>...
+    };
+  }(std::make_index_sequence<depths.size()>{});
+}
+
+/// templated_chains[dtor index][depth index]
+constexpr auto templated_chains =
+  []<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array{ templated_chains_with<dtor_counts[I]>()... };
+  }(std::make_index_sequence<dtor_counts.size()>{});
+
+enum class chain_kind : std::uint8_t
+{
+  recursive,
+  templated,
+  terminate,
+};
+
+constexpr std::array chain_kinds{
+  chain_kind::recursive,
+  chain_kind::templated,
+  chain_kind::terminate,
+};
+
+const char*
+to_string(chain_kind p_kind)
+{
+  switch (p_kind) {
+    case chain_kind::recursive:
+      return "recursive";
+    case chain_kind::templated:
+      return "templated";
+    case chain_kind::terminate:
+      return "terminate";
+  }
+  return "unknown";
+}
+
+struct chain_run
+{
+  recursive_chain recursive = nullptr;
+  templated_chain templated = nullptr;
+  std::uint32_t depth = 0;
+};
+
+struct measurement
+{
+  std::uint32_t count = std::numeric_limits<std::uint32_t>::max();
+  std::uint32_t stack_bytes = 0;
+  bool terminated = false;
+};
+
+// Deterministic under QEMU, repeated for hardware runs like throw_benchmark
+constexpr int repetitions = 4;
+
+std::jmp_buf terminate_jump{};
+volatile std::uint32_t terminate_time = 0;
+
+[[noreturn]] void
+return_from_terminate()
+{
+  terminate_time = cycle_counter::now();
+  std::longjmp(terminate_jump, 1);
+}
+
+[[gnu::noinline]] measurement
+measure_once(const chain_run& p_run)
+{
+  volatile std::uint32_t end = 0;
+  volatile bool terminated = false;
+  const auto stack_mark = stack_usage::paint();
+  const std::uint32_t start = cycle_counter::now();
+
+  if (setjmp(terminate_jump) == 0) {
+    try {
+      if (p_run.recursive != nullptr) {
+        p_run.recursive(p_run.depth);
+      } else {
+        p_run.templated();
+      }
+      end = cycle_counter::now();
+    } catch (...) {
+      end = cycle_counter::now();
+    }
+  } else {
+    end = terminate_time;
+    terminated = true;
+    __cxxabiv1::__cxa_end_catch();
+  }
+
+  return { .count = cycle_counter::elapsed(start, end),
+           .stack_bytes = stack_usage::peak_since(stack_mark),
+           .terminated = terminated };
+}
+
+measurement
+measure(const chain_run& p_run, throw_trigger p_trigger)
+{
+  measurement best{};
+  for (int i = 0; i < repetitions; i++) {
+    arm_trigger(p_trigger);
+    const auto result = measure_once(p_run);
+    best.count = std::min(best.count, result.count);
+    best.stack_bytes = std::max(best.stack_bytes, result.stack_bytes);
+    best.terminated = result.terminated;
+  }
+  disarm_triggers();
+  return best;
+}
+
+std::uint32_t
+to_report_units(std::uint32_t p_count, cycle_counter::source p_source)
+{
+  if (p_source == cycle_counter::source::dwt_cycles) {
+    return p_count;
+  }
+  return cycle_counter::to_instructions(
+    p_count, NOEXCEPT_CPU_HZ, NOEXCEPT_ICOUNT_SHIFT);
+}
+
+std::uintptr_t
+code_address(const void* p_function)
+{
+  // Clear the Thumb bit
+  return reinterpret_cast<std::uintptr_t>(p_function) & ~std::uintptr_t{ 1 };
+}
+
+/**
+ * Bytes of the largest cleanup pad of p_function: from the landing pad of a
+ * call site up to and including the call to __cxa_end_cleanup.
+ *
+ * @param p_function - function to inspect
+ * @return std::uint32_t - 0 if the function has no GCC LSDA or no landing pad
+ * ending in __cxa_end_cleanup
+ */
+std::uint32_t
+cleanup_pad_bytes(const void* p_function)
+{
+  // Longest pad searched, 8 destructors take 52 bytes
+  constexpr std::uint32_t scan_limit = 256;
+
+  const auto function = code_address(p_function);
+  const auto index = exception_index();
+  const auto entry = std::ranges::find_if(index, [&](const auto& p_entry) {
+    return reinterpret_cast<std::uintptr_t>(get_function(p_entry)) == function;
+  });
+  if (entry == index.end()) {
+    return 0;
+  }
+  const auto info = decode_exception_record(*entry).info;
+  if (info.rank != metadata_rank::table_gcc_lsda) {
+    return 0;
+  }
+
+  const auto end_cleanup = code_address(
+    reinterpret_cast<const void*>(&__cxa_end_cleanup));
+  std::uint32_t largest = 0;
+  for_each_call_site(generate_lsda_info(info), [&](const auto& p_site) {
+    if (p_site.landing_pad == 0) {
+      return;
+    }
+    const auto pad = function + p_site.landing_pad;
+    for (std::uint32_t offset = 0; offset < scan_limit;) {
+      const auto* instruction =
+        reinterpret_cast<const std::uint16_t*>(pad + offset);
+      const auto found = decode_branch(static_cast<std::uint32_t>(pad + offset),
+                                       instruction[0],
+                                       instruction[1]);
+      if (found && found->kind == branch_kind::call &&
+          found->target == end_cleanup) {
+        largest = std::max(largest, offset + 4);
+        return;
+      }
+      offset += is_wide_instruction(instruction[0]) ? 4 : 2;
+    }
+  });
+  return largest;
+}
+
+/**
+ * @return chain_run - p_kind chain of depths[p_depth] frames with
+ * dtor_counts[p_dtor] locals each
+ */
+chain_run
+make_run(chain_kind p_kind, std::size_t p_dtor, std::size_t p_depth)
+{
+  switch (p_kind) {
+    case chain_kind::recursive:
+      return { .recursive = recursive_chains[p_dtor],
+               .depth = depths[p_depth] };
+    case chain_kind::templated:
+      return { .templated = templated_chains[p_dtor][p_depth] };
+    case chain_kind::terminate:
+      return { .recursive = noexcept_chains[p_dtor],
+               .depth = depths[p_depth] };
+  }
+  return {};
+}
+
+/**
+ * @return const void* - the function the frames of p_run, other than the
+ * first, belong to
+ */
+const void*
+repeated_frame(chain_kind p_kind, std::size_t p_dtor, const chain_run& p_run)
+{
+  if (p_kind == chain_kind::templated) {
+    return reinterpret_cast<const void*>(p_run.templated);
+  }
+  return reinterpret_cast<const void*>(recursive_chains[p_dtor]);
+}
+} // namespace
+
+int
+main()
+{
+  const auto source = cycle_counter::enable();
+  const char* unit =
+    (source == cycle_counter::source::dwt_cycles) ? "cycles" : "instructions";
+
+  std::set_terminate(return_from_terminate);
+
+  semihost::file csv("deep_stack.csv");
+  if (not csv.is_open()) {
+    semihost::write("deep_stack: unable to open deep_stack.csv\n");
+    return 1;
+  }
+
+  std::array<char, 192> row{};
+  constexpr std::string_view header =
+    "chain,frames,dtors_per_frame,happy_path,throw_path,throw_per_frame,"
+    "cleanup_per_frame,cleanup_pad_bytes,model_pad_bytes,happy_stack_bytes,"
+    "throw_stack_bytes,throw_outcome,unit\n";
+  csv.write(header);
+
+  for (const auto kind : chain_kinds) {
+    // Throw path of the chain without destructors, per depth
+    std::array<std::uint32_t, depths.size()> bare_throw{};
+
+    for (std::size_t dtor = 0; dtor < dtor_counts.size(); dtor++) {
+      for (std::size_t depth = 0; depth < depths.size(); depth++) {
+        const auto run = make_run(kind, dtor, depth);
+        const auto happy = measure(run, throw_trigger::none);
+        const auto thrown = measure(run, throw_trigger::bar);
+
+        const auto happy_count = to_report_units(happy.count, source);
+        const auto throw_count = to_report_units(thrown.count, source);
+        if (dtor == 0) {
+          bare_throw[depth] = throw_count;
+        }
+        const auto frames = depths[depth];
+        const auto cleanup =
+          throw_count - std::min(throw_count, bare_throw[depth]);
+        const auto objects = static_cast<std::uint32_t>(dtor_counts[dtor]);
+        const std::uint32_t model_pad = objects == 0 ? 0 : 4 + 6 * objects;
+
+        const int length = std::snprintf(
+          row.data(),
+          row.size(),
+          "%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+          ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+          ",%s,%s\n",
+          to_string(kind),
+          frames,
+          objects,
+          happy_count,
+          throw_count,
+          (throw_count - std::min(throw_count, happy_count)) / frames,
+          cleanup / frames,
+          cleanup_pad_bytes(repeated_frame(kind, dtor, run)),
+          model_pad,
+          happy.stack_bytes,
+          thrown.stack_bytes,
+          thrown.terminated ? "terminate" : "caught",
+          unit);
+        csv.write(
+          std::span(row).first(std::min<std::size_t>(length, row.size())));
+      }
+    }
+  }
+
+  semihost::write("deep_stack: wrote deep_stack.csv\n");
+  return 0;
+}
@@ -0,0 +1,465 @@
+#include "exception_metadata.hpp"
+
+#include <cstdint>
+
+#include <algorithm>
+
+#include "unwind_instructions.hpp"
+
+void*
+to_absolute_address(volatile const void* p_address)
+{
+  auto address = reinterpret_cast<std::intptr_t>(p_address);
+  auto offset = *reinterpret_cast<volatile const std::int32_t*>(p_address);
+
+  // Sign extend the 31st bit
+  if (offset & (1 << 30)) {
+    offset |= 1 << 31;
+  }
+
+  std::intptr_t final_address = address + offset;
+  return reinterpret_cast<void*>(final_address);
+}
+
+[[gnu::noinline]] void*
+get_function(volatile const arm_index_entry& p_entry)
+{
+  return to_absolute_address(&p_entry.function);
+}
+
+exception_info::exception_info(const arm_index_entry& p_entry,
+                               const void* p_gcc_personality)
+{
+  function_address = get_function(p_entry);
+  index_entry = &p_entry;
+  if (p_entry.content == cannot_unwind_token) {
+    rank = metadata_rank::inlined_noexcept;
+  } else if (p_entry.content & is_personality_data) {
+    rank = metadata_rank::inlined_personality;
+  } else { // contains ptr to LSDA or ARM Personality
+    auto* table_data_ptr = to_absolute_address(&p_entry.content);
+    auto first_word = *reinterpret_cast<std::uint32_t*>(table_data_ptr);
+
+    if (first_word & is_personality_data) {
+      rank = metadata_rank::table_personality;
+      return;
+    }
+    // If this isn't personality data, then it has to be a pointer to a
+    // function that knowns how to understand the data in this section of the
+    // table.
+    void* data_handler = to_absolute_address(table_data_ptr);
+
+    if (data_handler == p_gcc_personality) {
+      // This is GCC LSDA data
+      rank = metadata_rank::table_gcc_lsda;
+      return;
+    }
+    // Unecessary code, but make it clear that the exception rank of this
+    // function is unknown at this point.
+    rank = metadata_rank::unknown;
+  }
+}
+
+std::uint32_t
+read_uleb128(const std::uint8_t** p_ptr)
+{
+  std::uint32_t result = 0;
+  std::uint8_t shift_amount = 0;
+
+  while (true) {
+    const std::uint8_t uleb128 = **p_ptr;
+
+    result |= (uleb128 & 0b0111'1111) << shift_amount;
+    shift_amount += 7;
+    (*p_ptr)++;
+
+    if (not(uleb128 & 0b1000'0000)) {
+      break;
+    }
+  }
+
+  return result;
+}
+
+std::int32_t
+read_leb128(const std::uint8_t** p_ptr)
+{
+  std::int32_t result = 0;
+  std::uint8_t shift_amount = 0;
+
+  while (true) {
+    const std::uint8_t leb128 = **p_ptr;
+
+    result |= (leb128 & 0b0111'1111) << shift_amount;
+    shift_amount += 7;
+    (*p_ptr)++;
+
+    if (not(leb128 & 0b1000'0000)) {
+      if (leb128 & 0b0100'0000) {
+        result |= (~0 << shift_amount);
+      }
+      break;
+    }
+  }
+
+  return result;
+}
+
+template<typename T>
+volatile const T*
+as(volatile const void* p_ptr)
+{
+  return reinterpret_cast<volatile const T*>(p_ptr);
+}
+
+personality_encoding
+operator&(const personality_encoding& p_encoding, const std::uint8_t& p_byte)
+{
+  return static_cast<personality_encoding>(
+    static_cast<std::uint8_t>(p_encoding) & p_byte);
+}
+personality_encoding
+operator&(const personality_encoding& p_encoding,
+          const personality_encoding& p_byte)
+{
+  return static_cast<personality_encoding>(
+    static_cast<std::uint8_t>(p_encoding) & static_cast<std::uint8_t>(p_byte));
+}
+
+std::uintptr_t
+read_encoded_data(const std::uint8_t** p_data, personality_encoding p_encoding)
+{
+  const std::uint8_t* ptr = *p_data;
+  std::uintptr_t result = 0;
+  const auto encoding = static_cast<personality_encoding>(p_encoding);
+
+  if (encoding == personality_encoding::omit) {
+    return 0;
+  }
+
+  // TODO: convert to hal::bit_extract w/ bit mask
+  const auto encoding_type = p_encoding & 0x0F;
+
+  switch (encoding_type) {
+    case personality_encoding::absptr:
+      // EHABI words are always 32-bits, even when decoding on a 64-bit host
+      result = *as<std::uint32_t>(ptr);
+      ptr += sizeof(std::uint32_t);
+      break;
+    case personality_encoding::uleb128:
+      result = read_uleb128(&ptr);
+      break;
+    case personality_encoding::udata2:
+      result = *as<std::uint16_t>(ptr);
+      ptr += sizeof(std::uint16_t);
+      break;
+    case personality_encoding::udata4:
+      result = *as<std::uint32_t>(ptr);
+      ptr += sizeof(std::uint32_t);
+      break;
+    case personality_encoding::sdata2:
+      result = *as<std::int16_t>(ptr);
+      ptr += sizeof(std::int16_t);
+      break;
+    case personality_encoding::sdata4:
+      result = *as<std::int32_t>(ptr);
+      ptr += sizeof(std::int32_t);
+      break;
+    case personality_encoding::sleb128:
+      result = read_leb128(&ptr);
+      break;
+    case personality_encoding::sdata8:
+      result = *as<std::int64_t>(ptr);
+      ptr += sizeof(std::int64_t);
+      break;
+    case personality_encoding::udata8:
+      result = *as<std::uint64_t>(ptr);
+      ptr += sizeof(std::uint64_t);
+      break;
+    default:
+      // Not a DWARF value format, decode_lsda() rejects LSDAs using one
+      return 0;
+  }
+
+  const auto encoding_offset = p_encoding & 0x70;
+
+  switch (encoding_offset) {
+    case personality_encoding::absptr:
+      // do nothing
+      break;
+    case personality_encoding::pcrel:
+      // Relative to the address of the field itself
+      result += reinterpret_cast<std::uintptr_t>(*p_data);
+      break;
+    case personality_encoding::textrel:
+    case personality_encoding::datarel:
+    case personality_encoding::funcrel:
+    case personality_encoding::aligned:
+    default:
+      break;
+  }
+
+  // Handle indirection GCC extension
+  if (static_cast<bool>(p_encoding & 0x80)) {
+    result = *reinterpret_cast<const std::uintptr_t*>(result);
+  }
+
+  *p_data = ptr;
+  return result;
+}
+
+namespace {
+/// @return bool - if read_encoded_data() can decode values of p_encoding
+bool
+is_readable_encoding(personality_encoding p_encoding)
+{
+  if (p_encoding == personality_encoding::omit) {
+    return true;
+  }
+  switch (p_encoding & 0x0F) {
+    case personality_encoding::absptr:
+    case personality_encoding::uleb128:
+    case personality_encoding::udata2:
+    case personality_encoding::udata4:
+    case personality_encoding::udata8:
+    case personality_encoding::sleb128:
+    case personality_encoding::sdata2:
+    case personality_encoding::sdata4:
+    case personality_encoding::sdata8:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @return std::uint32_t - bytes of a value stored with p_encoding, pointer size
+ * for absptr and the variable length encodings
+ */
+std::uint32_t
+encoded_size(personality_encoding p_encoding, std::uint32_t p_pointer_size)
+{
+  switch (p_encoding & 0x0F) {
+    case personality_encoding::udata2:
+    case personality_encoding::sdata2:
+      return 2;
+    case personality_encoding::udata4:
+    case personality_encoding::sdata4:
+      return 4;
+    case personality_encoding::udata8:
+    case personality_encoding::sdata8:
+      return 8;
+    default:
+      return p_pointer_size;
+  }
+}
+} // namespace
+
+lsda_info
+decode_lsda(const std::uint8_t* p_lsda,
+            const void* p_start,
+            std::uint32_t p_pointer_size)
+{
+  lsda_info info{};
+  const std::uint8_t* lsda_data = p_lsda;
+  const auto* const top_of_lsda_data = p_start;
+
+  // Check if DWARF info is include (return early if so, not supported
+  // currently).
+  if (personality_encoding{ *lsda_data } == personality_encoding::omit) {
+    lsda_data++; // skip omit flag
+  } else {
+    return info;
+  }
+
+  // type table encoding of 0x00 means absolute address
+  info.type_encoding = personality_encoding{ *lsda_data++ };
+  if (not is_readable_encoding(info.type_encoding)) {
+    return info;
+  }
+  const auto type_entry_size =
+    encoded_size(info.type_encoding, p_pointer_size);
+  if (info.type_encoding ==
+      personality_encoding::omit) { // omit code: type table
+    info.type_table.count = 0;
+    info.type_table.size = 0;
+  } else {
+    info.type_offset = read_uleb128(&lsda_data);
+    info.type_table_base = lsda_data + info.type_offset;
+  }
+
+  info.call_site_encoding = personality_encoding{ *lsda_data++ };
+  if (not is_readable_encoding(info.call_site_encoding)) {
+    return info;
+  }
+  info.call_site.size = read_uleb128(&lsda_data);
+  info.call_site_table = lsda_data;
+
+  const auto* call_site_end = lsda_data + info.call_site.size;
+  const std::uint8_t* end_of_lsda = lsda_data;
+
+  if (info.type_offset > 0) {
+    end_of_lsda += info.type_offset;
+  } else {
+    end_of_lsda += info.call_site.size;
+  }
+
+  info.total_size =
+    end_of_lsda - reinterpret_cast<const std::uint8_t*>(top_of_lsda_data);
+
+  if (info.call_site.size == 0) {
+    info.valid = true;
+    return info;
+  }
+
+  // The action table follows the call sites. Every record is
+  //
+  //       [sleb128:filter_number][sleb128:offset_to_next]
+  //
+  // where the offset is relative to its own position and 0 ends the chain.
+  // Each call site starts a chain at a 1-based byte offset into the table,
+  // the table ends after the furthest record any chain reaches. Padding that
+  // aligns the type table is not part of it.
+  const std::uint8_t* const action_table = call_site_end;
+  const std::uint8_t* action_table_end = action_table;
+  // Chains never revisit a record, so this bounds a malformed, cyclic one
+  const auto max_chain_length = static_cast<std::uint32_t>(
+    end_of_lsda > action_table ? end_of_lsda - action_table : 0);
+
+  // Scan call site
+  for_each_call_site(info, [&](const call_site_record& p_site) {
+    info.max_action = std::max(info.max_action, p_site.action);
+    info.call_site.count++;
+
+    if (p_site.action == 0) {
+      return; // cleanup only
+    }
+
+    const std::uint8_t* record = action_table + p_site.action - 1;
+    for (std::uint32_t i = 0; i < max_chain_length && record < end_of_lsda;
+         i++) {
+      const auto filter = read_leb128(&record);
+      const auto* next_field = record;
+      const auto next = read_leb128(&record);
+      action_table_end = std::max(action_table_end, record);
+
+      // Positive filters are 1-based indices into the type table, negative
+      // ones select exception specifications
+      if (filter > 0) {
+        info.type_table.count =
+          std::max(info.type_table.count, static_cast<std::uint32_t>(filter));
+      }
+      if (next == 0) {
+        break;
+      }
+      record = next_field + next;
+    }
+  });
+
+  // Records are contiguous, count them up to the end found above
+  for (const std::uint8_t* record = action_table; record < action_table_end;) {
+    read_leb128(&record); // filter number
+    read_leb128(&record); // offset to next
+    info.action_table.count++;
+  }
+  info.action_table.size = action_table_end - action_table;
+
+  // The size of the type table entries follows from their encoding
+  info.type_table.size = type_entry_size * info.type_table.count;
+
+  info.valid = true;
+
+  return info;
+}
+
+[[gnu::noinline]] lsda_info
+generate_lsda_info(const exception_info& p_info)
+{
+  if (p_info.rank != metadata_rank::table_gcc_lsda) {
+    lsda_info info{};
+    info.function = p_info.function_address;
+    return info;
+  }
+
+  const auto* const offset_address = &p_info.index_entry->content;
+  const auto* const top_of_lsda_data = to_absolute_address(offset_address);
+
+  // The generic model's unwind instructions follow the personality routine,
+  // the LSDA starts right after their last word.
+  const std::uint8_t* lsda_data = decode_unwind_instructions(p_info).data_end;
+
+  // Words in the exception table are 32-bits wide regardless of the machine
+  // doing the decoding.
+  auto info = decode_lsda(lsda_data, top_of_lsda_data, sizeof(std::uint32_t));
+  info.function = p_info.function_address;
+  return info;
+}
+
+const char*
+to_string(metadata_rank p_rank)
+{
+  switch (p_rank) {
+    case metadata_rank::no_entry:
+      return "no_entry";
+    case metadata_rank::inlined_noexcept:
+      return "inlined_noexcept";
+    case metadata_rank::inlined_personality:
+      return "inlined_personality";
+    case metadata_rank::table_personality:
+      return "table_personality";
+    case metadata_rank::table_gcc_lsda:
+      return "table_gcc_lsda";
+    case metadata_rank::unknown:
+    default:
+      return "unknown";
+  }
+}
+
+const char*
+to_string(personality_encoding p_encoding)
+{
+  // Only the plain encodings are named. Combined encodings such as
+  // `pcrel | sdata4` are reported by their offset type, which is the part that
+  // matters for the size of the tables.
+  if (p_encoding == personality_encoding::omit) {
+    return "omit";
+  }
+
+  switch (p_encoding & 0x70) {
+    case personality_encoding::pcrel:
+      return "pcrel";
+    case personality_encoding::textrel:
+      return "textrel";
+    case personality_encoding::datarel:
+      return "datarel";
+    case personality_encoding::funcrel:
+      return "funcrel";
+    case personality_encoding::aligned:
+      return "aligned";
+    default:
+      break;
+  }
+
+  switch (p_encoding & 0x0F) {
+    case personality_encoding::absptr:
+      return "absptr";
+    case personality_encoding::uleb128:
+      return "uleb128";
+    case personality_encoding::udata2:
+      return "udata2";
+    case personality_encoding::udata4:
+      return "udata4";
+    case personality_encoding::udata8:
+      return "udata8";
+    case personality_encoding::sleb128:
+      return "sleb128";
+    case personality_encoding::sdata2:
+      return "sdata2";
+    case personality_encoding::sdata4:
+      return "sdata4";
+    case personality_encoding::sdata8:
+      return "sdata8";
+    default:
+      return "unknown";
+  }
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+
+// ARM EHABI exception index and LSDA decoding shared by the on-target
+// analysis in main.cpp and the host tools. Everything here only follows
+// relative (prel31) offsets, so it works equally on the live flash image and on
+// an ELF file mapped into memory on the host, as long as the code, index and
+// table live at the same relative positions as they do on the device.
+
+void*
+to_absolute_address(volatile const void* p_address);
+
+struct arm_index_entry
+{
+  std::uint32_t function;
+  std::uint32_t content;
+};
+
+/// Content of an index entry whose function cannot be unwound,
+/// EXIDX_CANTUNWIND
+inline constexpr std::uint32_t cannot_unwind_token = 0x1;
+/// Set in the content of an index entry, or the first word of its exception
+/// table entry, holding compact personality data rather than a prel31 offset
+inline constexpr std::uint32_t is_personality_data = 1U << 31;
+
+void*
+get_function(volatile const arm_index_entry& p_entry);
+
+enum class metadata_rank : std::uint8_t
+{
+  unknown = 0,
+  no_entry,
+  inlined_noexcept,
+  inlined_personality,
+  table_personality,
+  table_gcc_lsda,
+};
+
+struct lsda_section_size
+{
+  std::uint32_t count = 0;
+  std::uint32_t size = 0;
+};
+
+struct exception_info
+{
+  exception_info() = default;
+
+  /**
+   * @param p_entry - exception index entry to classify
+   * @param p_gcc_personality - address of `__gxx_personality_v0` within the
+   * same address space as p_entry, used to recognize GCC LSDA data.
+   */
+  exception_info(const arm_index_entry& p_entry,
+                 const void* p_gcc_personality);
+
+  void* function_address = nullptr;
+  const arm_index_entry* index_entry = nullptr;
+  metadata_rank rank = metadata_rank::unknown;
+};
+
+enum class personality_encoding : std::uint8_t
+{
+  absptr = 0x00,
+  uleb128 = 0x01,
+  udata2 = 0x02,
+  udata4 = 0x03,
+  udata8 = 0x04,
+  sleb128 = 0x09,
+  sdata2 = 0x0A,
+  sdata4 = 0x0B,
+  sdata8 = 0x0C,
+
+  pcrel = 0x10,
+  textrel = 0x20,
+  datarel = 0x30,
+  funcrel = 0x40,
+  aligned = 0x50,
+
+  // no data follows
+  omit = 0xff,
+};
+
+struct lsda_info
+{
+  void* function = nullptr;
+  bool valid = false;
+  std::uint32_t total_size = 0;
+  std::uint32_t max_action = 0;
+  std::uint32_t type_offset = 0;
+  personality_encoding type_encoding = personality_encoding::omit;
+  personality_encoding call_site_encoding = personality_encoding::omit;
+  lsda_section_size call_site{};
+  lsda_section_size action_table{};
+  lsda_section_size type_table{};
+  /// First call site record, nullptr when the LSDA could not be decoded
+  const std::uint8_t* call_site_table = nullptr;
+  /// End of the type table, filter N selects the N-th entry before it.
+  /// nullptr when the LSDA has no type table.
+  const std::uint8_t* type_table_base = nullptr;
+};
+
+/// A call site record of the LSDA
+struct call_site_record
+{
+  /// Offsets from the landing pad base, the start of the function
+  std::uint32_t start = 0;
+  std::uint32_t length = 0;
+  /// 0 for call sites without a landing pad
+  std::uint32_t landing_pad = 0;
+  /// 1-based offset into the action table, 0 for cleanup only
+  std::uint32_t action = 0;
+};
+
+std::uint32_t
+read_uleb128(const std::uint8_t** p_ptr);
+
+std::int32_t
+read_leb128(const std::uint8_t** p_ptr);
+
+/**
+ * Read a DWARF encoded value and advance past it
+ *
+ * @param p_data - the value to read, left unchanged for unknown encodings
+ * @param p_encoding - format and base of the value
+ * @return std::uintptr_t - the value, 0 for omit and unknown encodings
+ */
+std::uintptr_t
+read_encoded_data(const std::uint8_t** p_data, personality_encoding p_encoding);
+
+/**
+ * Invoke `p_callback(const call_site_record&)` for every call site of a
+ * decoded LSDA, in table order
+ *
+ * @param p_info - LSDA returned by decode_lsda or generate_lsda_info
+ * @param p_callback - invoked with each call site record
+ */
+template<typename Callback>
+void
+for_each_call_site(const lsda_info& p_info, Callback&& p_callback)
+{
+  if (p_info.call_site_table == nullptr) {
+    return;
+  }
+  const std::uint8_t* record = p_info.call_site_table;
+  const std::uint8_t* const end = record + p_info.call_site.size;
+  while (record < end) {
+    call_site_record site{};
+    site.start = read_encoded_data(&record, p_info.call_site_encoding);
+    site.length = read_encoded_data(&record, p_info.call_site_encoding);
+    site.landing_pad = read_encoded_data(&record, p_info.call_site_encoding);
+    site.action = read_uleb128(&record);
+    p_callback(site);
+  }
+}
+
+/**
+ * Decode a GCC LSDA, the format of both the ARM exception table and the
+ * `.gcc_except_table` section of other targets.
+ *
+ * @param p_lsda - first byte of the LSDA, the landing pad base encoding
+ * @param p_start - where the metadata of the function starts, total_size is
+ * measured from here. The exception table entry on ARM, p_lsda elsewhere.
+ * @param p_pointer_size - size of an absolute pointer in the type table
+ * @return lsda_info - the sizes of each table, function is left empty
+ */
+lsda_info
+decode_lsda(const std::uint8_t* p_lsda,
+            const void* p_start,
+            std::uint32_t p_pointer_size);
+
+lsda_info
+generate_lsda_info(const exception_info& p_info);
+
+const char*
+to_string(metadata_rank p_rank);
+
+const char*
+to_string(personality_encoding p_encoding);
+
+/**
+ * Walk a sorted list of functions alongside the exception index and invoke
+ * `p_callback(const exception_info&)` once per function, in order.
+ *
+ * Functions that do not start an index entry of their own are reported with
+ * metadata_rank::no_entry.
+ *
+ * @param p_functions - function addresses sorted in ascending order
+ * @param p_index - the exception index, sorted by the linker
+ * @param p_gcc_personality - see exception_info
+ * @param p_callback - invoked with each function's exception_info
+ */
+template<typename Callback>
+void
+scan_exception_index(std::span<void* const> p_functions,
+                     std::span<const arm_index_entry> p_index,
+                     const void* p_gcc_personality,
+                     Callback&& p_callback)
+{
+  auto f_cursor = p_functions.begin();
+  auto e_cursor = p_index.begin();
+  while (f_cursor != p_functions.end() && e_cursor != p_index.end()) {
+    void* exception_function = get_function(*e_cursor);
+
+    if (*f_cursor == exception_function) {
+      p_callback(exception_info(*e_cursor, p_gcc_personality));
+      f_cursor++;
+      e_cursor++;
+    } else if (*f_cursor < exception_function) {
+      exception_info info{};
+      info.function_address = *f_cursor;
+      info.rank = metadata_rank::no_entry;
+      p_callback(info);
+      f_cursor++;
+    } else if (*f_cursor > exception_function) {
+      e_cursor++;
+    }
+  }
+
+  // Anything past the last index entry cannot have an entry either
+  for (; f_cursor != p_functions.end(); f_cursor++) {
+    exception_info info{};
+    info.function_address = *f_cursor;
+    info.rank = metadata_rank::no_entry;
+    p_callback(info);
+  }
+}
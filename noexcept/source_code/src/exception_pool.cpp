@@ -0,0 +1,215 @@
+#include "exception_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <exception>
+
+#include "atomic_update.hpp"
+#include "cxa_abi.hpp"
+
+namespace exception_pool {
+namespace {
+// Every slot starts with the header libsupc++ expects in front of the thrown
+// object. Take its size from the ABI layout rather than guessing.
+constexpr std::size_t header_size = sizeof(cxa_refcounted_exception_header);
+constexpr std::size_t slot_alignment = alignof(cxa_refcounted_exception_header);
+
+// Size classes: the largest object each class accepts (excluding the header)
+// and the number of slots in the class. Tune these using the high water marks
+// from read_statistics().
+constexpr std::array<std::uint32_t, size_class_count> object_sizes{ 32,
+                                                                    128,
+                                                                    512 };
+constexpr std::array<std::uint32_t, size_class_count> slot_counts{ 4, 2, 1 };
+
+static_assert(std::ranges::is_sorted(object_sizes),
+              "size classes must be ordered from smallest to largest");
+static_assert(std::ranges::all_of(slot_counts,
+                                  [](auto p_count) {
+                                    return 0 < p_count && p_count < 32;
+                                  }),
+              "each size class must have between 1 and 31 slots");
+static_assert(sizeof(cxa_dependent_exception_header) <=
+                header_size + object_sizes[0],
+              "dependent exceptions must fit in the smallest slot");
+
+constexpr std::size_t
+slot_size(std::size_t p_class)
+{
+  const std::size_t size = header_size + object_sizes[p_class];
+  return (size + slot_alignment - 1) & ~(slot_alignment - 1);
+}
+
+constexpr std::size_t
+storage_offset(std::size_t p_class)
+{
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < p_class; i++) {
+    offset += slot_size(i) * slot_counts[i];
+  }
+  return offset;
+}
+
+constexpr std::size_t
+first_slot(std::size_t p_class)
+{
+  std::size_t slot = 0;
+  for (std::size_t i = 0; i < p_class; i++) {
+    slot += slot_counts[i];
+  }
+  return slot;
+}
+
+struct slot_location
+{
+  std::size_t size_class = 0;
+  std::size_t index = 0;
+};
+
+alignas(slot_alignment) std::array<std::uint8_t,
+                                   storage_offset(size_class_count)> storage{};
+/// Size requested for the object in each slot, by first_slot() + index
+std::array<std::uint16_t, first_slot(size_class_count)> requested_sizes{};
+std::array<std::atomic<std::uint32_t>, size_class_count> used_slots{};
+std::array<std::atomic<std::uint32_t>, size_class_count> high_water_marks{};
+std::atomic<std::uint32_t> failed_allocation_count{ 0 };
+std::atomic<std::uint32_t> largest_request_size{ 0 };
+
+void
+record_max(std::atomic<std::uint32_t>& p_value, std::uint32_t p_candidate)
+{
+  atomic_update(p_value, [p_candidate](std::uint32_t p_current) {
+    return std::max(p_current, p_candidate);
+  });
+}
+
+void*
+allocate(std::size_t p_object_size) noexcept
+{
+  record_max(largest_request_size, p_object_size);
+
+  for (std::size_t size_class = 0; size_class < size_class_count;
+       size_class++) {
+    if (p_object_size > object_sizes[size_class]) {
+      continue;
+    }
+
+    const std::uint32_t all_used = (1U << slot_counts[size_class]) - 1;
+    std::uint32_t claimed = 0;
+    const auto previous =
+      atomic_update(used_slots[size_class], [&claimed, all_used](auto p_used) {
+        claimed = (p_used == all_used) ? 0 : ~p_used & (p_used + 1);
+        return p_used | claimed;
+      });
+
+    if (claimed == 0) {
+      continue; // class is full, a larger one may still have room
+    }
+
+    record_max(high_water_marks[size_class],
+               std::popcount(previous | claimed));
+
+    const auto index = std::countr_zero(claimed);
+    requested_sizes[first_slot(size_class) + index] =
+      static_cast<std::uint16_t>(p_object_size);
+    return storage.data() + storage_offset(size_class) +
+           (index * slot_size(size_class));
+  }
+
+  atomic_update(failed_allocation_count,
+                [](std::uint32_t p_count) { return p_count + 1; });
+  return nullptr;
+}
+
+slot_location
+locate(const void* p_slot) noexcept
+{
+  const auto offset = static_cast<std::size_t>(
+    static_cast<const std::uint8_t*>(p_slot) - storage.data());
+
+  std::size_t size_class = 0;
+  while (size_class < size_class_count - 1 &&
+         offset >= storage_offset(size_class + 1)) {
+    size_class++;
+  }
+  return { .size_class = size_class,
+           .index = (offset - storage_offset(size_class)) /
+                    slot_size(size_class) };
+}
+
+void
+release(void* p_slot) noexcept
+{
+  const auto slot = locate(p_slot);
+  atomic_update(used_slots[slot.size_class], [&slot](std::uint32_t p_used) {
+    return p_used & ~(1U << slot.index);
+  });
+}
+} // namespace
+
+statistics
+read_statistics() noexcept
+{
+  statistics result{};
+  for (std::size_t i = 0; i < size_class_count; i++) {
+    auto& usage = result.size_class[i];
+    usage.object_size = object_sizes[i];
+    usage.slots = slot_counts[i];
+    usage.in_use = std::popcount(used_slots[i].load(std::memory_order_relaxed));
+    usage.high_water_mark = high_water_marks[i].load(std::memory_order_relaxed);
+  }
+  result.failed_allocations =
+    failed_allocation_count.load(std::memory_order_relaxed);
+  result.largest_request = largest_request_size.load(std::memory_order_relaxed);
+  return result;
+}
+
+std::uint32_t
+object_size(const void* p_object) noexcept
+{
+  const auto slot =
+    locate(static_cast<const std::uint8_t*>(p_object) - header_size);
+  return requested_sizes[first_slot(slot.size_class) + slot.index];
+}
+} // namespace exception_pool
+
+extern "C"
+{
+  void* __wrap___cxa_allocate_exception(std::size_t p_size) noexcept // NOLINT
+  {
+    auto* slot = static_cast<std::uint8_t*>(exception_pool::allocate(p_size));
+    if (slot == nullptr) {
+      std::terminate();
+    }
+    // libsupc++ expects a zeroed header, just like its own allocator provides
+    std::memset(slot, 0, exception_pool::header_size);
+    return slot + exception_pool::header_size;
+  }
+
+  void __wrap___cxa_free_exception(void* p_object) noexcept // NOLINT
+  {
+    exception_pool::release(static_cast<std::uint8_t*>(p_object) -
+                            exception_pool::header_size);
+  }
+
+  void* __wrap___cxa_allocate_dependent_exception() noexcept // NOLINT
+  {
+    void* slot = exception_pool::allocate(0);
+    if (slot == nullptr) {
+      std::terminate();
+    }
+    std::memset(slot, 0, sizeof(cxa_dependent_exception_header));
+    return slot;
+  }
+
+  void __wrap___cxa_free_dependent_exception(void* p_exception) noexcept // NOLINT
+  {
+    exception_pool::release(p_exception);
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+
+// Fixed capacity storage for exception objects, installed in place of
+// __cxa_allocate_exception/__cxa_free_exception (and their dependent exception
+// counterparts used by std::rethrow_exception) with -Wl,--wrap.
+//
+// Exceptions are placed in the smallest size class that fits. Allocation and
+// release never block and may be used from interrupt context. If no slot is
+// available, the failure is counted and std::terminate() is called, as the ABI
+// requires when an exception cannot be allocated.
+
+namespace exception_pool {
+/// Number of size classes, see exception_pool.cpp for their configuration
+inline constexpr std::size_t size_class_count = 3;
+
+struct size_class_usage
+{
+  /// Largest exception object, excluding the ABI header, that fits a slot
+  std::uint32_t object_size = 0;
+  std::uint32_t slots = 0;
+  std::uint32_t in_use = 0;
+  /// Most slots that have been in use at the same time
+  std::uint32_t high_water_mark = 0;
+};
+
+struct statistics
+{
+  std::array<size_class_usage, size_class_count> size_class{};
+  /// Allocations that did not fit any free slot
+  std::uint32_t failed_allocations = 0;
+  /// Largest exception object requested so far, excluding the ABI header
+  std::uint32_t largest_request = 0;
+};
+
+/**
+ * @return statistics - snapshot of the pool's usage counters
+ */
+statistics
+read_statistics() noexcept;
+
+/**
+ * @param p_object - exception object returned by __cxa_allocate_exception
+ * @return std::uint32_t - the size that was requested for it, excluding the
+ * ABI header
+ */
+std::uint32_t
+object_size(const void* p_object) noexcept;
+} // namespace exception_pool
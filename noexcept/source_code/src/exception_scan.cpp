@@ -0,0 +1,11 @@
+#include "exception_scan.hpp"
+
+[[gnu::noinline]] exception_record
+decode_exception_record(const arm_index_entry& p_entry)
+{
+  exception_record record{};
+  record.info = exception_info(
+    p_entry, reinterpret_cast<const void*>(__gxx_personality_v0));
+  record.lsda = generate_lsda_info(record.info);
+  return record;
+}
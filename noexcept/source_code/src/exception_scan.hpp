@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <span>
+
+#include "exception_metadata.hpp"
+
+extern "C"
+{
+  extern const arm_index_entry __exidx_start;
+  extern const arm_index_entry __exidx_end;
+  extern void __gxx_personality_v0(...);
+}
+
+/**
+ * Number of index entries seen so far for each metadata_rank
+ */
+struct rank_histogram
+{
+  void add(metadata_rank p_rank)
+  {
+    count[static_cast<std::uint8_t>(p_rank)]++;
+  }
+
+  std::uint32_t operator[](metadata_rank p_rank) const
+  {
+    return count[static_cast<std::uint8_t>(p_rank)];
+  }
+
+  std::array<std::uint32_t, 6> count{};
+};
+
+/**
+ * Everything known about a single exception index entry
+ */
+struct exception_record
+{
+  std::uint32_t position = 0;
+  exception_info info{};
+  lsda_info lsda{};
+};
+
+/**
+ * @return std::span<const arm_index_entry> - the full exception index of the
+ * running image
+ */
+inline std::span<const arm_index_entry>
+exception_index()
+{
+  return { &__exidx_start, &__exidx_end };
+}
+
+/**
+ * Decode a single index entry of the running image
+ *
+ * @param p_entry - entry within exception_index()
+ * @return exception_record - rank and lsda information for the entry
+ */
+exception_record
+decode_exception_record(const arm_index_entry& p_entry);
+
+/**
+ * Walk __exidx_start..__exidx_end once, decoding each entry as it is reached.
+ *
+ * Unlike generate_meta_info/generate_lsda_info, nothing is collected. Each
+ * record is handed to `p_sink(const exception_record&, const rank_histogram&)`
+ * immediately along with the histogram so far, so the RAM used is the same
+ * whether the table holds 50 entries or 50,000.
+ *
+ * Because every entry is reported, functions merged into a neighbour's entry by
+ * the linker are not listed individually and functions without an entry do not
+ * appear at all. The record's function address identifies the start of the
+ * range each entry covers.
+ *
+ * @param p_sink - invoked for every entry in table order
+ * @return rank_histogram - the final histogram
+ */
+template<typename Sink>
+rank_histogram
+stream_exception_index(Sink&& p_sink)
+{
+  rank_histogram histogram{};
+  std::uint32_t position = 0;
+
+  for (const auto& entry : exception_index()) {
+    auto record = decode_exception_record(entry);
+    record.position = position++;
+    histogram.add(record.info.rank);
+    p_sink(record, histogram);
+  }
+
+  return histogram;
+}
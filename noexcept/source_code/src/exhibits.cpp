@@ -0,0 +1,253 @@
+#include "exhibits.hpp"
+
+#include <array>
+
+#include "dtor_paths.hpp"
+#include "except_vs_noexcept.hpp"
+#include "external.hpp"
+
+namespace {
+my_struct_t exhibit1_struct{};
+my_class exhibit8_object(my_class::state_t::ready);
+volatile my_class::state_t exhibit8_state{};
+
+// Indices into side_effect checked by each trigger, see external.cpp and
+// dtor_paths.cpp
+constexpr std::size_t action_counter = 1;
+constexpr std::size_t bar_counter = 3;
+constexpr std::size_t baz_counter = 4;
+constexpr std::size_t inner_side_effect_flag = 6;
+constexpr int throw_value = 0xFFFF;
+
+constexpr std::array exhibit_table{
+  exhibit{ 1,
+           "initialize",
+           false,
+           throw_trigger::none,
+           [] { initialize(exhibit1_struct); } },
+  exhibit{ 1,
+           "noexcept_initialize",
+           true,
+           throw_trigger::none,
+           [] { noexcept_initialize(exhibit1_struct); } },
+  exhibit{ 2,
+           "noexcept_calls_all_noexcept",
+           true,
+           throw_trigger::inner_side_effect,
+           noexcept_calls_all_noexcept },
+  exhibit{ 2,
+           "except_calls_all_noexcept",
+           false,
+           throw_trigger::inner_side_effect,
+           except_calls_all_noexcept },
+  exhibit{ 3,
+           "noexcept_calls_mixed",
+           true,
+           throw_trigger::baz,
+           noexcept_calls_mixed },
+  exhibit{ 3,
+           "except_calls_mixed",
+           false,
+           throw_trigger::baz,
+           except_calls_mixed },
+  exhibit{ 4,
+           "noexcept_calls_all_except",
+           true,
+           throw_trigger::bar,
+           noexcept_calls_all_except },
+  exhibit{ 4,
+           "except_calls_all_except",
+           false,
+           throw_trigger::bar,
+           except_calls_all_except },
+  exhibit{ 5,
+           "noexcept_calls_all_noexcept_in_try_catch",
+           true,
+           throw_trigger::inner_side_effect,
+           noexcept_calls_all_noexcept_in_try_catch },
+  exhibit{ 5,
+           "except_calls_all_noexcept_in_try_catch",
+           false,
+           throw_trigger::inner_side_effect,
+           except_calls_all_noexcept_in_try_catch },
+  exhibit{ 6,
+           "noexcept_calls_mixed_in_try_catch",
+           true,
+           throw_trigger::bar,
+           noexcept_calls_mixed_in_try_catch },
+  exhibit{ 6,
+           "except_calling_mixed_in_try_catch",
+           false,
+           throw_trigger::bar,
+           except_calling_mixed_in_try_catch },
+  exhibit{ 7,
+           "noexcept_calls_except_in_try_catch",
+           true,
+           throw_trigger::bar,
+           noexcept_calls_except_in_try_catch },
+  exhibit{ 7,
+           "except_calls_except_in_try_catch",
+           false,
+           throw_trigger::bar,
+           except_calls_except_in_try_catch },
+  exhibit{ 8,
+           "my_class::noexcept_state",
+           true,
+           throw_trigger::none,
+           [] { exhibit8_state = exhibit8_object.noexcept_state(); } },
+  exhibit{ 8,
+           "my_class::state",
+           false,
+           throw_trigger::none,
+           [] { exhibit8_state = exhibit8_object.state(); } },
+  exhibit{ 9,
+           "dtor::noexcept_calls_all_noexcept",
+           true,
+           throw_trigger::none,
+           dtor::noexcept_calls_all_noexcept },
+  exhibit{ 9,
+           "dtor::except_calls_all_noexcept",
+           false,
+           throw_trigger::none,
+           dtor::except_calls_all_noexcept },
+  exhibit{ 10,
+           "dtor::noexcept_calls_all_except",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_all_except },
+  exhibit{ 10,
+           "dtor::except_calls_all_except",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_all_except },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment1",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment1 },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment2",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment2 },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment3",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment3 },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment4",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment4 },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment5",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment5 },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment6",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment6 },
+  exhibit{ 11,
+           "dtor::noexcept_calls_experiment7",
+           true,
+           throw_trigger::action,
+           dtor::noexcept_calls_experiment7 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment1",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment1 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment2",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment2 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment3",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment3 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment4",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment4 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment5",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment5 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment6",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment6 },
+  exhibit{ 11,
+           "dtor::except_calls_experiment7",
+           false,
+           throw_trigger::action,
+           dtor::except_calls_experiment7 },
+};
+} // namespace
+
+std::span<const exhibit>
+exhibits()
+{
+  return exhibit_table;
+}
+
+void
+disarm_triggers()
+{
+  side_effect[action_counter] = 0;
+  side_effect[bar_counter] = 0;
+  side_effect[baz_counter] = 0;
+  side_effect[inner_side_effect_flag] = 0;
+}
+
+void
+arm_trigger(throw_trigger p_trigger)
+{
+  disarm_triggers();
+
+  switch (p_trigger) {
+    case throw_trigger::none:
+      break;
+    case throw_trigger::inner_side_effect:
+      side_effect[inner_side_effect_flag] = throw_value;
+      break;
+    case throw_trigger::bar:
+      // bar() increments its counter before comparing it
+      side_effect[bar_counter] = throw_value - 1;
+      break;
+    case throw_trigger::baz:
+      side_effect[baz_counter] = throw_value - 1;
+      break;
+    case throw_trigger::action:
+      // action() throws once its counter reaches 15, noexcept_action() calls
+      // made before it only move the counter further past the threshold
+      side_effect[action_counter] = 15;
+      break;
+  }
+}
+
+const char*
+to_string(throw_trigger p_trigger)
+{
+  switch (p_trigger) {
+    case throw_trigger::none:
+      return "none";
+    case throw_trigger::inner_side_effect:
+      return "inner_side_effect";
+    case throw_trigger::bar:
+      return "bar";
+    case throw_trigger::baz:
+      return "baz";
+    case throw_trigger::action:
+      return "action";
+  }
+  return "unknown";
+}
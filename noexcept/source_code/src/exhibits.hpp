@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+
+// Catalogue of the exhibit functions from except_vs_noexcept.cpp and
+// dtor_paths.cpp along with the side_effect trigger that makes each of them
+// throw. Benchmarks use it to drive every exhibit down its non-throwing and
+// throwing path.
+
+enum class throw_trigger : std::uint8_t
+{
+  /// Nothing the exhibit calls can throw
+  none,
+  /// inner_side_effect(), reached through every noexcept_bar/baz/qaz call
+  inner_side_effect,
+  /// bar()
+  bar,
+  /// baz()
+  baz,
+  /// dtor::non_trivial_dtor::action()
+  action,
+};
+
+struct exhibit
+{
+  std::uint8_t number;
+  const char* name;
+  bool is_noexcept;
+  throw_trigger trigger;
+  void (*run)();
+};
+
+/**
+ * @return std::span<const exhibit> - Exhibits 1 through 11, in paper order
+ */
+std::span<const exhibit>
+exhibits();
+
+/**
+ * Reset every side_effect counter used as a trigger so that no exhibit throws
+ */
+void
+disarm_triggers();
+
+/**
+ * Set the side_effect counter for p_trigger so the next call to the triggering
+ * function throws. Every other trigger is disarmed.
+ *
+ * @param p_trigger - function that should throw
+ */
+void
+arm_trigger(throw_trigger p_trigger);
+
+const char*
+to_string(throw_trigger p_trigger);
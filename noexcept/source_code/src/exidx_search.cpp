@@ -0,0 +1,44 @@
+#include "exidx_search.hpp"
+
+#include <cstdint>
+
+#include <unwind.h>
+
+#include "exception_scan.hpp"
+
+#if not defined(NOEXCEPT_EXIDX_SEARCH_CAPACITY)
+#define NOEXCEPT_EXIDX_SEARCH_CAPACITY 256
+#endif
+
+namespace {
+[[gnu::section(".bss.exidx_search")]] exidx_search_table<
+  NOEXCEPT_EXIDX_SEARCH_CAPACITY> search_table;
+
+// Runs with the other static constructors. Exceptions thrown before, or when
+// the index does not fit, use the unwinder's own search.
+[[gnu::constructor]] void
+build_search_table()
+{
+  search_table.build(exception_index());
+}
+} // namespace
+
+extern "C"
+{
+  /**
+   * libgcc's unwinder calls this weak hook, when it is defined, for the part of
+   * the exception index to bisect for p_return_address. Handing it the single
+   * matching entry leaves it nothing to search.
+   */
+  _Unwind_Ptr __gnu_Unwind_Find_exidx(_Unwind_Ptr p_return_address, // NOLINT
+                                      int* p_count)
+  {
+    if (const auto* entry = search_table.find(p_return_address)) {
+      *p_count = 1;
+      return reinterpret_cast<_Unwind_Ptr>(entry);
+    }
+    const auto index = exception_index();
+    *p_count = static_cast<int>(index.size());
+    return reinterpret_cast<_Unwind_Ptr>(index.data());
+  }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <bit>
+#include <span>
+#include <type_traits>
+
+#include "exception_metadata.hpp"
+
+// Search structure over the exception index, used in place of the unwinder's
+// binary search when NOEXCEPT_EXIDX_SEARCH is on.
+//
+// The unwinder bisects the index directly, decoding two prel31 offsets per
+// step. exidx_search_table decodes every function address once and stores the
+// absolute addresses in Eytzinger (breadth first) order: the children of node
+// k are 2k and 2k + 1, so a lookup walks down the array from the front without
+// decoding anything and the top levels of every search share the same few
+// words.
+
+/**
+ * @tparam Capacity - largest number of index entries the table can hold, the
+ * table takes (Capacity + 1) * (sizeof(std::uintptr_t) + 2) bytes for up to
+ * 65535 entries
+ */
+template<std::size_t Capacity>
+class exidx_search_table
+{
+public:
+  using position_type =
+    std::conditional_t<(Capacity < 0xFFFF), std::uint16_t, std::uint32_t>;
+
+  /**
+   * Build the table for p_index, which must be sorted by function the way the
+   * linker emits it.
+   *
+   * @param p_index - the exception index to search
+   * @return true - if p_index fits, otherwise the table stays empty
+   */
+  bool
+  build(std::span<const arm_index_entry> p_index) noexcept
+  {
+    m_index = {};
+    if (p_index.empty() || p_index.size() > Capacity) {
+      return false;
+    }
+    m_size = p_index.size();
+    std::size_t next = 0;
+    fill(p_index, 1, next);
+    m_index = p_index;
+    return true;
+  }
+
+  /// @return true - if build() succeeded
+  bool
+  is_built() const noexcept
+  {
+    return not m_index.empty();
+  }
+
+  /**
+   * @param p_address - address within a function, such as a return address
+   * @return const arm_index_entry* - the entry of the last function starting
+   * at or before p_address, nullptr if p_address lies before the first
+   * function or the table is not built
+   */
+  const arm_index_entry*
+  find(std::uintptr_t p_address) const noexcept
+  {
+    std::size_t node = 1;
+    while (node <= m_size) {
+      node = 2 * node + (m_keys[node] <= p_address ? 1 : 0);
+    }
+    // Undo the steps taken right of the last node passed on the left, that
+    // node holds the first function starting after p_address
+    node >>= std::countr_one(node) + 1;
+
+    const std::size_t following = node == 0 ? m_size : m_positions[node];
+    if (following == 0) {
+      return nullptr;
+    }
+    return &m_index[following - 1];
+  }
+
+private:
+  /// In order traversal of the implicit tree assigns the sorted entries
+  void
+  fill(std::span<const arm_index_entry> p_index,
+       std::size_t p_node,
+       std::size_t& p_next) noexcept
+  {
+    if (p_node > m_size) {
+      return;
+    }
+    fill(p_index, 2 * p_node, p_next);
+    m_keys[p_node] =
+      reinterpret_cast<std::uintptr_t>(get_function(p_index[p_next]));
+    m_positions[p_node] = static_cast<position_type>(p_next);
+    p_next++;
+    fill(p_index, 2 * p_node + 1, p_next);
+  }
+
+  std::span<const arm_index_entry> m_index{};
+  std::size_t m_size = 0;
+  // Element 0 is unused so the root is node 1
+  std::array<std::uintptr_t, Capacity + 1> m_keys{};
+  std::array<position_type, Capacity + 1> m_positions{};
+};
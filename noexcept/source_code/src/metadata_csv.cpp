@@ -0,0 +1,126 @@
+#include "metadata_csv.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include <algorithm>
+
+namespace {
+std::size_t
+clamp_written(std::span<char> p_buffer, int p_result)
+{
+  if (p_result < 0 || p_buffer.empty()) {
+    return 0;
+  }
+  const auto written = static_cast<std::size_t>(p_result);
+  return std::min(written, p_buffer.size() - 1);
+}
+} // namespace
+
+std::size_t
+format_exception_rank_row(std::span<char> p_buffer,
+                          const char* p_name,
+                          const char* p_demangled_name,
+                          std::uintptr_t p_index_entry,
+                          metadata_rank p_rank)
+{
+  const int result = std::snprintf(p_buffer.data(),
+                                   p_buffer.size(),
+                                   "%s,0x%" PRIxPTR ",%s,%s\n",
+                                   p_name,
+                                   p_index_entry,
+                                   to_string(p_rank),
+                                   p_demangled_name);
+  return clamp_written(p_buffer, result);
+}
+
+std::size_t
+format_lsda_info_row(std::span<char> p_buffer,
+                     const char* p_name,
+                     const char* p_demangled_name,
+                     const lsda_info& p_info)
+{
+  const int result =
+    std::snprintf(p_buffer.data(),
+                  p_buffer.size(),
+                  "%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%s,%s,%" PRIu32
+                  ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+                  ",%s\n",
+                  p_name,
+                  p_info.valid ? "True" : "False",
+                  p_info.total_size,
+                  p_info.max_action,
+                  p_info.type_offset,
+                  to_string(p_info.type_encoding),
+                  to_string(p_info.call_site_encoding),
+                  p_info.call_site.count,
+                  p_info.call_site.size,
+                  p_info.action_table.count,
+                  p_info.action_table.size,
+                  p_info.type_table.count,
+                  p_info.type_table.size,
+                  p_demangled_name);
+  return clamp_written(p_buffer, result);
+}
+
+std::size_t
+format_unwind_info_row(std::span<char> p_buffer,
+                       const char* p_name,
+                       const char* p_demangled_name,
+                       const unwind_info& p_info)
+{
+  const int result =
+    std::snprintf(p_buffer.data(),
+                  p_buffer.size(),
+                  "%s,%s,%u,%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32
+                  ",0x%04x,%" PRIu32 ",%" PRIu32 ",%" PRId32 ",%s,%s\n",
+                  p_name,
+                  to_string(p_info.model),
+                  static_cast<unsigned>(p_info.personality_index),
+                  p_info.valid ? "True" : "False",
+                  p_info.refuses_to_unwind ? "True" : "False",
+                  p_info.words,
+                  p_info.opcode_count,
+                  p_info.opcode_bytes,
+                  static_cast<unsigned>(p_info.core_registers),
+                  core_register_count(p_info),
+                  p_info.extension_registers,
+                  p_info.vsp_adjust,
+                  p_info.vsp_from_register ? "True" : "False",
+                  p_demangled_name);
+  return clamp_written(p_buffer, result);
+}
+
+std::size_t
+format_exception_index_row(std::span<char> p_buffer,
+                           std::uint32_t p_position,
+                           const exception_info& p_info,
+                           const lsda_info& p_lsda)
+{
+  const int result =
+    std::snprintf(p_buffer.data(),
+                  p_buffer.size(),
+                  "%" PRIu32 ",0x%" PRIxPTR ",0x%" PRIxPTR ",%s,%s,%" PRIu32
+                  ",%" PRIu32 "\n",
+                  p_position,
+                  reinterpret_cast<std::uintptr_t>(p_info.function_address),
+                  reinterpret_cast<std::uintptr_t>(p_info.index_entry),
+                  to_string(p_info.rank),
+                  p_lsda.valid ? "True" : "False",
+                  p_lsda.total_size,
+                  p_lsda.call_site.count);
+  return clamp_written(p_buffer, result);
+}
+
+std::size_t
+format_rank_histogram_row(std::span<char> p_buffer,
+                          metadata_rank p_rank,
+                          std::uint32_t p_count)
+{
+  const int result = std::snprintf(p_buffer.data(),
+                                   p_buffer.size(),
+                                   "%s,%" PRIu32 "\n",
+                                   to_string(p_rank),
+                                   p_count);
+  return clamp_written(p_buffer, result);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <span>
+
+#include "exception_metadata.hpp"
+#include "unwind_instructions.hpp"
+
+// Row formatters for the csv/v1 schema. They only use snprintf so the same
+// code produces the files on the host and over a debug channel on the device.
+// function_name is the demangled name without parameters, demangled_name the
+// full one with parameters and clone suffixes. The device has no symbols and
+// writes function_name into both.
+
+inline constexpr char exception_rank_csv_header[] =
+  "function_name,index_entry,rank,demangled_name\n";
+
+inline constexpr char lsda_info_csv_header[] =
+  "function_name,valid,total_size,max_action,type_offset,type_encoding,"
+  "call_site_encoding,call_site_count,call_site_size,action_table_count,"
+  "action_table_size,type_table_count,type_table_size,demangled_name\n";
+
+inline constexpr char unwind_info_csv_header[] =
+  "function_name,model,personality_index,valid,refuses_to_unwind,words,"
+  "opcode_count,opcode_bytes,core_registers,registers_restored,"
+  "extension_registers,vsp_adjust,vsp_from_register,demangled_name\n";
+
+inline constexpr char exception_index_csv_header[] =
+  "position,function_address,index_entry,rank,lsda_valid,lsda_total_size,"
+  "call_site_count\n";
+
+inline constexpr char rank_histogram_csv_header[] = "rank,count\n";
+
+/**
+ * @param p_buffer - destination, always null terminated when non-empty
+ * @param p_name - function name for the first column
+ * @param p_demangled_name - full name for the last column
+ * @param p_index_entry - address of the index entry in the target's address
+ * space, 0 for functions without an entry.
+ * @param p_rank - rank of the function
+ * @return std::size_t - number of characters written, excluding the null
+ * terminator
+ */
+std::size_t
+format_exception_rank_row(std::span<char> p_buffer,
+                          const char* p_name,
+                          const char* p_demangled_name,
+                          std::uintptr_t p_index_entry,
+                          metadata_rank p_rank);
+
+/**
+ * @param p_buffer - destination, always null terminated when non-empty
+ * @param p_name - function name for the first column
+ * @param p_demangled_name - full name for the last column
+ * @param p_info - lsda information for the function
+ * @return std::size_t - number of characters written, excluding the null
+ * terminator
+ */
+std::size_t
+format_lsda_info_row(std::span<char> p_buffer,
+                     const char* p_name,
+                     const char* p_demangled_name,
+                     const lsda_info& p_info);
+
+/**
+ * @param p_buffer - destination, always null terminated when non-empty
+ * @param p_name - function name for the first column
+ * @param p_demangled_name - full name for the last column
+ * @param p_info - decoded unwind instructions of the function
+ * @return std::size_t - number of characters written, excluding the null
+ * terminator
+ */
+std::size_t
+format_unwind_info_row(std::span<char> p_buffer,
+                       const char* p_name,
+                       const char* p_demangled_name,
+                       const unwind_info& p_info);
+
+/**
+ * @param p_buffer - destination, always null terminated when non-empty
+ * @param p_position - position of the entry within the exception index
+ * @param p_info - rank and addresses of the entry, in the target's address
+ * space
+ * @param p_lsda - lsda information of the entry
+ * @return std::size_t - number of characters written, excluding the null
+ * terminator
+ */
+std::size_t
+format_exception_index_row(std::span<char> p_buffer,
+                           std::uint32_t p_position,
+                           const exception_info& p_info,
+                           const lsda_info& p_lsda);
+
+/**
+ * @param p_buffer - destination, always null terminated when non-empty
+ * @param p_rank - rank counted
+ * @param p_count - index entries of that rank
+ * @return std::size_t - number of characters written, excluding the null
+ * terminator
+ */
+std::size_t
+format_rank_histogram_row(std::span<char> p_buffer,
+                          metadata_rank p_rank,
+                          std::uint32_t p_count);
@@ -0,0 +1,96 @@
+#include "personality_actions.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include <exception>
+
+#include <unwind.h>
+
+#include "cxa_abi.hpp"
+
+extern "C"
+{
+  // libsupc++, marks an exception as being cleaned up before a cleanup landing
+  // pad runs. Declared in its private unwind-cxx.h.
+  bool __cxa_begin_cleanup(_Unwind_Control_Block* p_exception) noexcept;
+}
+
+namespace personality_actions {
+std::uint32_t
+exception_type(_Unwind_Control_Block* p_exception) noexcept
+{
+  // "GNUCC++" followed by 0 for primary and 1 for dependent exceptions
+  constexpr char vendor_language[] = "GNUCC++";
+  const char* exception_class = p_exception->exception_class;
+  if (std::memcmp(exception_class, vendor_language, 7) != 0) {
+    return 0;
+  }
+
+  if (exception_class[7] == '\0') {
+    return reinterpret_cast<std::uintptr_t>(
+      to_cxa_exception(p_exception)->exception_type);
+  }
+  if (exception_class[7] == '\1') {
+    const auto* dependent =
+      reinterpret_cast<cxa_dependent_exception_header*>(p_exception + 1) - 1;
+    const auto* object = dependent->primary_exception;
+    const auto* primary = static_cast<const cxa_exception_header*>(object) - 1;
+    return reinterpret_cast<std::uintptr_t>(primary->exception_type);
+  }
+  return 0;
+}
+
+void*
+exception_object(_Unwind_Control_Block* p_exception) noexcept
+{
+  if (exception_type(p_exception) == 0) {
+    return nullptr;
+  }
+  // The object follows the headers of a primary exception, a dependent one
+  // points at the object of its primary exception
+  if (p_exception->exception_class[7] == '\0') {
+    return p_exception + 1;
+  }
+  const auto* dependent =
+    reinterpret_cast<cxa_dependent_exception_header*>(p_exception + 1) - 1;
+  return dependent->primary_exception;
+}
+
+bool
+is_handler_frame(_Unwind_State p_state,
+                 _Unwind_Control_Block* p_exception,
+                 _Unwind_Context* p_context) noexcept
+{
+  // In the cleanup phase the handler frame is recognized by the stack
+  // pointer the search phase recorded, libsupc++ takes it from there.
+  return (p_state & _US_ACTION_MASK) == _US_UNWIND_FRAME_STARTING &&
+         p_exception->barrier_cache.sp ==
+           _Unwind_GetGR(p_context, stack_pointer_register);
+}
+
+_Unwind_Reason_Code
+continue_unwinding(_Unwind_Control_Block* p_exception,
+                   _Unwind_Context* p_context) noexcept
+{
+  if (__gnu_unwind_frame(p_exception, p_context) != _URC_OK) {
+    return _URC_FAILURE;
+  }
+  return _URC_CONTINUE_UNWIND;
+}
+
+_Unwind_Reason_Code
+install_cleanup(_Unwind_Control_Block* p_exception,
+                _Unwind_Context* p_context,
+                std::uint32_t p_landing_pad) noexcept
+{
+  const auto exception = reinterpret_cast<std::uintptr_t>(p_exception);
+  _Unwind_SetGR(p_context, exception_register, exception);
+  _Unwind_SetGR(p_context, switch_value_register, 0);
+  _Unwind_SetGR(p_context, program_counter_register, p_landing_pad);
+  if (not __cxa_begin_cleanup(p_exception)) {
+    std::terminate();
+  }
+  return _URC_INSTALL_CONTEXT;
+}
+} // namespace personality_actions
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include <unwind.h>
+
+// The frame outcomes of __gxx_personality_v0 that do not depend on the LSDA
+// once the answer is known, shared by the wrappers that answer in its place,
+// personality_cache.cpp and unwind_plan.cpp, and by slim_personality.cpp.
+
+namespace personality_actions {
+// Registers the personality routine hands to the landing pads, they are
+// __builtin_eh_return_data_regno(0) and (1), and to the unwinder (r12)
+inline constexpr int exception_register = 0;
+inline constexpr int switch_value_register = 1;
+inline constexpr int unwind_pointer_register = 12;
+inline constexpr int stack_pointer_register = 13;
+inline constexpr int program_counter_register = 15;
+
+/**
+ * @return std::uint32_t - address of the std::type_info of a C++ exception
+ * thrown by this program, 0 for foreign exceptions
+ */
+std::uint32_t
+exception_type(_Unwind_Control_Block* p_exception) noexcept;
+
+/**
+ * @return void* - the thrown object of a C++ exception thrown by this program,
+ * that of the primary exception for dependent ones, nullptr for foreign
+ * exceptions
+ */
+void*
+exception_object(_Unwind_Control_Block* p_exception) noexcept;
+
+/**
+ * @return true - if the unwinder is in the cleanup phase at the frame the
+ * search phase stopped at, the one whose handler catches the exception
+ */
+bool
+is_handler_frame(_Unwind_State p_state,
+                 _Unwind_Control_Block* p_exception,
+                 _Unwind_Context* p_context) noexcept;
+
+/**
+ * What __gxx_personality_v0 does for a frame that does not handle the
+ * exception: unwind it and tell the unwinder to carry on
+ */
+_Unwind_Reason_Code
+continue_unwinding(_Unwind_Control_Block* p_exception,
+                   _Unwind_Context* p_context) noexcept;
+
+/**
+ * What __gxx_personality_v0 does to enter a cleanup landing pad
+ *
+ * @param p_landing_pad - value for the program counter, including the Thumb
+ * bit
+ */
+_Unwind_Reason_Code
+install_cleanup(_Unwind_Control_Block* p_exception,
+                _Unwind_Context* p_context,
+                std::uint32_t p_landing_pad) noexcept;
+} // namespace personality_actions
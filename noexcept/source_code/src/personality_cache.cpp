@@ -0,0 +1,226 @@
+#include "personality_cache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <bit>
+
+#include <unwind.h>
+
+#include "atomic_update.hpp"
+#include "personality_actions.hpp"
+
+extern "C"
+{
+  _Unwind_Reason_Code __real___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context);
+}
+
+namespace personality_cache {
+namespace {
+// Direct mapped, a power of two. A control loop has a handful of throw sites
+// with a few frames each between them and their handlers.
+constexpr std::size_t entry_count = 32;
+static_assert(std::has_single_bit(entry_count),
+              "entry_count must be a power of two");
+constexpr int index_bits = std::countr_zero(entry_count);
+
+enum class outcome : std::uint32_t
+{
+  /// The frame does not handle the exception, unwind through it
+  continue_unwind = 1,
+  /// Run the cleanup landing pad, then resume unwinding
+  cleanup = 2,
+};
+
+struct frame_key
+{
+  std::uint32_t address = 0;
+  std::uint32_t type = 0;
+  std::uint32_t phase = 0;
+};
+
+struct cached_frame
+{
+  outcome result = outcome::continue_unwind;
+  /// Value for the program counter, including the Thumb bit
+  std::uint32_t landing_pad = 0;
+};
+
+/**
+ * Every field is written under a sequence lock: the sequence is odd while a
+ * writer owns the entry and advances by two for every update, so readers can
+ * detect a torn read and treat it as a miss. 0 means the entry was never
+ * written.
+ */
+struct entry
+{
+  std::atomic<std::uint32_t> sequence{ 0 };
+  std::atomic<std::uint32_t> address{ 0 };
+  std::atomic<std::uint32_t> type{ 0 };
+  std::atomic<std::uint32_t> phase{ 0 };
+  std::atomic<std::uint32_t> result{ 0 };
+  std::atomic<std::uint32_t> landing_pad{ 0 };
+};
+
+std::array<entry, entry_count> entries{};
+std::atomic<std::uint32_t> hit_count{ 0 };
+std::atomic<std::uint32_t> miss_count{ 0 };
+std::atomic<std::uint32_t> eviction_count{ 0 };
+std::atomic<std::uint32_t> bypass_count{ 0 };
+
+void
+increment(std::atomic<std::uint32_t>& p_counter) noexcept
+{
+  atomic_update(p_counter, [](std::uint32_t p_count) { return p_count + 1; });
+}
+
+entry&
+slot_for(const frame_key& p_key) noexcept
+{
+  // Thumb instructions are 2 byte aligned and type_info objects word aligned
+  const std::uint32_t mixed = (p_key.address >> 1) ^ (p_key.type >> 2) ^
+                              (p_key.phase << 4);
+  return entries[(mixed * 0x9E37'79B1U) >> (32 - index_bits)];
+}
+
+bool
+lookup(const frame_key& p_key, cached_frame& p_frame) noexcept
+{
+  auto& slot = slot_for(p_key);
+  const auto sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence == 0 || (sequence & 1)) {
+    return false;
+  }
+
+  const frame_key stored{
+    .address = slot.address.load(std::memory_order_relaxed),
+    .type = slot.type.load(std::memory_order_relaxed),
+    .phase = slot.phase.load(std::memory_order_relaxed),
+  };
+  p_frame.result = outcome{ slot.result.load(std::memory_order_relaxed) };
+  p_frame.landing_pad = slot.landing_pad.load(std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+    return false;
+  }
+  return stored.address == p_key.address && stored.type == p_key.type &&
+         stored.phase == p_key.phase;
+}
+
+void
+insert(const frame_key& p_key, const cached_frame& p_frame) noexcept
+{
+  auto& slot = slot_for(p_key);
+  const auto previous = atomic_update(
+    slot.sequence, [](std::uint32_t p_sequence) { return p_sequence | 1; });
+  if (previous & 1) {
+    return; // another writer owns the entry, leave it to them
+  }
+
+  if (previous != 0 &&
+      (slot.address.load(std::memory_order_relaxed) != p_key.address ||
+       slot.type.load(std::memory_order_relaxed) != p_key.type ||
+       slot.phase.load(std::memory_order_relaxed) != p_key.phase)) {
+    increment(eviction_count);
+  }
+
+  slot.address.store(p_key.address, std::memory_order_relaxed);
+  slot.type.store(p_key.type, std::memory_order_relaxed);
+  slot.phase.store(p_key.phase, std::memory_order_relaxed);
+  slot.result.store(static_cast<std::uint32_t>(p_frame.result),
+                    std::memory_order_relaxed);
+  slot.landing_pad.store(p_frame.landing_pad, std::memory_order_relaxed);
+  slot.sequence.store(previous + 2, std::memory_order_release);
+}
+} // namespace
+
+statistics
+read_statistics() noexcept
+{
+  return {
+    .hits = hit_count.load(std::memory_order_relaxed),
+    .misses = miss_count.load(std::memory_order_relaxed),
+    .evictions = eviction_count.load(std::memory_order_relaxed),
+    .bypassed = bypass_count.load(std::memory_order_relaxed),
+  };
+}
+
+void
+clear() noexcept
+{
+  for (auto& slot : entries) {
+    slot.sequence.store(0, std::memory_order_relaxed);
+  }
+  hit_count.store(0, std::memory_order_relaxed);
+  miss_count.store(0, std::memory_order_relaxed);
+  eviction_count.store(0, std::memory_order_relaxed);
+  bypass_count.store(0, std::memory_order_relaxed);
+}
+} // namespace personality_cache
+
+extern "C"
+{
+  _Unwind_Reason_Code __wrap___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context)
+  {
+    using namespace personality_cache;
+    using namespace personality_actions;
+
+    const auto phase = p_state & _US_ACTION_MASK;
+    const auto type = exception_type(p_exception);
+    const bool handler_frame =
+      is_handler_frame(p_state, p_exception, p_context);
+    const bool cacheable =
+      not(p_state & _US_FORCE_UNWIND) && type != 0 && not handler_frame &&
+      (phase == _US_VIRTUAL_UNWIND_FRAME || phase == _US_UNWIND_FRAME_STARTING);
+
+    if (not cacheable) {
+      increment(bypass_count);
+      return __real___gxx_personality_v0(p_state, p_exception, p_context);
+    }
+
+    // Unwinding the frame replaces the program counter, take it first
+    const frame_key key{
+      .address = _Unwind_GetGR(p_context, program_counter_register),
+      .type = type,
+      .phase = static_cast<std::uint32_t>(phase),
+    };
+
+    cached_frame frame{};
+    if (lookup(key, frame)) {
+      increment(hit_count);
+      _Unwind_SetGR(p_context,
+                    unwind_pointer_register,
+                    reinterpret_cast<std::uintptr_t>(p_exception));
+      if (frame.result == outcome::cleanup) {
+        return install_cleanup(p_exception, p_context, frame.landing_pad);
+      }
+      return continue_unwinding(p_exception, p_context);
+    }
+
+    increment(miss_count);
+    const auto result =
+      __real___gxx_personality_v0(p_state, p_exception, p_context);
+
+    if (result == _URC_CONTINUE_UNWIND) {
+      insert(key, { .result = outcome::continue_unwind });
+    } else if (result == _URC_INSTALL_CONTEXT &&
+               phase == _US_UNWIND_FRAME_STARTING &&
+               _Unwind_GetGR(p_context, switch_value_register) == 0) {
+      // A switch value of 0 selects no handler, the landing pad is a cleanup
+      insert(key,
+             { .result = outcome::cleanup,
+               .landing_pad =
+                 _Unwind_GetGR(p_context, program_counter_register) });
+    }
+    return result;
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// Memoizes the decisions of __gxx_personality_v0, installed in front of it
+// with -Wl,--wrap=__gxx_personality_v0 when NOEXCEPT_PERSONALITY_CACHE is on.
+//
+// For every frame it is asked about, the personality routine decodes the LSDA
+// header and scans the call site table for the return address, once in the
+// search phase and again in the cleanup phase. When the same throw site fires
+// repeatedly, those answers do not change. The cache remembers, per
+// (return address, exception type, phase), the frames that the personality
+// routine let the exception pass through and the cleanup landing pads it
+// installed, and replays them without reading the tables.
+//
+// Frames that catch the exception or terminate are always handed to the real
+// personality routine, as are forced unwinds and foreign exceptions. The
+// handler frame does not need the cache: libsupc++ already carries its landing
+// pad from the search phase to the cleanup phase in the exception object.
+
+namespace personality_cache {
+struct statistics
+{
+  /// Frames answered from the cache
+  std::uint32_t hits = 0;
+  /// Cacheable frames that were handed to the real personality routine
+  std::uint32_t misses = 0;
+  /// Entries that replaced a different, valid entry
+  std::uint32_t evictions = 0;
+  /// Calls that could not use the cache, see the file comment
+  std::uint32_t bypassed = 0;
+};
+
+/**
+ * @return statistics - snapshot of the cache's counters
+ */
+statistics
+read_statistics() noexcept;
+
+/**
+ * Drop every entry and reset the counters
+ */
+void
+clear() noexcept;
+} // namespace personality_cache
@@ -0,0 +1,82 @@
+#include "semihost.hpp"
+
+#include <cstring>
+
+namespace semihost {
+namespace {
+enum class operation : int
+{
+  open = 0x01,
+  close = 0x02,
+  write0 = 0x04,
+  write = 0x05,
+  exit_extended = 0x20,
+};
+
+// SYS_OPEN modes for fopen(path, "w") and fopen(path, "wb")
+constexpr int open_mode_write = 4;
+constexpr int open_mode_write_binary = 5;
+// ADP_Stopped_ApplicationExit, lets SYS_EXIT_EXTENDED carry an exit code
+constexpr int application_exit = 0x20026;
+
+int
+call(operation p_operation, const void* p_argument) noexcept
+{
+  register int r0 asm("r0") = static_cast<int>(p_operation);
+  register const void* r1 asm("r1") = p_argument;
+  asm volatile("bkpt 0xAB" : "+r"(r0) : "r"(r1) : "memory");
+  return r0;
+}
+} // namespace
+
+void
+write(const char* p_message) noexcept
+{
+  call(operation::write0, p_message);
+}
+
+void
+exit(int p_status) noexcept
+{
+  const int arguments[] = { application_exit, p_status };
+  call(operation::exit_extended, arguments);
+  while (true) {
+    continue;
+  }
+}
+
+file::file(const char* p_path, file_mode p_mode) noexcept
+{
+  const std::uintptr_t arguments[] = {
+    reinterpret_cast<std::uintptr_t>(p_path),
+    static_cast<std::uintptr_t>(p_mode == file_mode::binary
+                                  ? open_mode_write_binary
+                                  : open_mode_write),
+    std::strlen(p_path),
+  };
+  m_handle = call(operation::open, arguments);
+}
+
+file::~file()
+{
+  if (is_open()) {
+    const int arguments[] = { m_handle };
+    call(operation::close, arguments);
+  }
+}
+
+bool
+file::write(std::span<const char> p_data) noexcept
+{
+  if (not is_open()) {
+    return false;
+  }
+  const std::uintptr_t arguments[] = {
+    static_cast<std::uintptr_t>(m_handle),
+    reinterpret_cast<std::uintptr_t>(p_data.data()),
+    p_data.size(),
+  };
+  // SYS_WRITE returns the number of bytes that were NOT written
+  return call(operation::write, arguments) == 0;
+}
+} // namespace semihost
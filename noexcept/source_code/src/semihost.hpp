@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+
+// Minimal ARM semihosting client, used to hand results to the host when the
+// firmware runs under QEMU (-semihosting-config enable=on) or a debug probe.
+// Every call executes `bkpt 0xAB`; without a debugger or emulator servicing the
+// breakpoint the core faults, so only call these from builds meant for one.
+
+namespace semihost {
+/**
+ * Write a null terminated string to the host's console
+ *
+ * @param p_message - string to print
+ */
+void
+write(const char* p_message) noexcept;
+
+/**
+ * Terminate the session, QEMU exits with p_status as its exit code
+ *
+ * @param p_status - exit code reported to the host
+ */
+[[noreturn]] void
+exit(int p_status) noexcept;
+
+enum class file_mode : std::uint8_t
+{
+  /// fopen(path, "w")
+  text,
+  /// fopen(path, "wb"), for hosts that translate line endings in text mode
+  binary,
+};
+
+/// File on the host, opened for writing and truncated
+class file
+{
+public:
+  /**
+   * @param p_path - path on the host, relative paths are relative to the
+   * working directory of the emulator or debugger
+   * @param p_mode - how the host opens the file
+   */
+  explicit file(const char* p_path,
+                file_mode p_mode = file_mode::text) noexcept;
+  file(const file&) = delete;
+  file& operator=(const file&) = delete;
+  ~file();
+
+  /**
+   * @return true - the host opened the file
+   */
+  bool is_open() const noexcept
+  {
+    return m_handle != -1;
+  }
+
+  /**
+   * @param p_data - bytes to append to the file
+   * @return true - all of p_data was written
+   */
+  bool write(std::span<const char> p_data) noexcept;
+
+private:
+  int m_handle = -1;
+};
+} // namespace semihost
@@ -0,0 +1,328 @@
+#include <cstdint>
+#include <cstring>
+
+#include <exception>
+#include <typeinfo>
+
+#include <unwind.h>
+
+#include "personality_actions.hpp"
+
+// __gxx_personality_v0 for the LSDAs GCC emits for Cortex-M, linked in place
+// of the one in libsupc++ when NOEXCEPT_SLIM_PERSONALITY is on. Defining the
+// symbol keeps eh_personality.o out of the link.
+//
+// The stock routine decodes every pointer encoding, even though the ARM
+// EHABI fixes the type table to pc relative pointers on bare metal and GCC
+// writes call sites as uleb128 (see lsda_info.csv). This one reads exactly
+// that and fails the unwind on any other layout. Its call site search stops at
+// the first record starting after the call, the table is sorted. Catch
+// clauses compare the std::type_info addresses first, which settles the common
+// case of catching the thrown type itself in a statically linked image, and
+// only ask std::type_info::__do_catch for bases and pointer conversions.
+//
+// Exception specifications are not supported, since C++17 the only one left
+// is throw(), which GCC emits like noexcept. Their filters terminate.
+
+namespace {
+constexpr std::uint8_t encoding_omit = 0xFF;
+constexpr std::uint8_t encoding_uleb128 = 0x01;
+
+// Saved by the search phase for the handler frame, in the words of
+// barrier_cache where libsupc++ keeps them. __cxa_begin_catch reads the
+// adjusted object back from the first.
+constexpr int caught_object_word = 0;
+constexpr int switch_value_word = 1;
+constexpr int lsda_word = 2;
+constexpr int landing_pad_word = 3;
+
+enum class found : std::uint8_t
+{
+  nothing,
+  terminate,
+  cleanup,
+  handler,
+};
+
+struct frame_answer
+{
+  found type = found::terminate;
+  std::int32_t switch_value = 0;
+  /// Landing pad address without the Thumb bit
+  std::uint32_t landing_pad = 0;
+  /// Object handed to the catch clause, adjusted to the caught type
+  void* object = nullptr;
+};
+
+std::uint32_t
+read_uleb128(const std::uint8_t*& p_data) noexcept
+{
+  // Most values in an LSDA fit in the first byte
+  std::uint32_t value = *p_data++;
+  if (value < 0x80) {
+    return value;
+  }
+  value &= 0x7F;
+  for (unsigned shift = 7;; shift += 7) {
+    const std::uint8_t byte = *p_data++;
+    value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      return value;
+    }
+  }
+}
+
+std::int32_t
+read_sleb128(const std::uint8_t*& p_data) noexcept
+{
+  std::uint32_t value = 0;
+  unsigned shift = 0;
+  std::uint8_t byte = 0;
+  do {
+    byte = *p_data++;
+    value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  if (shift < 32 && (byte & 0x40)) {
+    value |= ~std::uint32_t{ 0 } << shift;
+  }
+  return static_cast<std::int32_t>(value);
+}
+
+/**
+ * @param p_type_table - end of the type table, filter N selects the N-th
+ * entry before it
+ * @return bool - if the catch clause of p_filter takes the exception, with
+ * p_answer.object adjusted to the caught type
+ */
+bool
+catches(const std::uint8_t* p_type_table,
+        std::int32_t p_filter,
+        _Unwind_Control_Block* p_exception,
+        frame_answer& p_answer) noexcept
+{
+  const auto* entry = p_type_table - (p_filter * 4);
+  std::uint32_t offset = 0;
+  std::memcpy(&offset, entry, sizeof(offset));
+  if (offset == 0) {
+    return true; // catch (...)
+  }
+  if (p_answer.object == nullptr) {
+    return false; // foreign exceptions are only caught by catch (...)
+  }
+
+  // pc relative, _Unwind_decode_typeinfo_ptr for bare metal targets
+  const auto* catch_type = reinterpret_cast<const std::type_info*>(
+    reinterpret_cast<std::uintptr_t>(entry) + offset);
+  const auto* thrown_type = reinterpret_cast<const std::type_info*>(
+    personality_actions::exception_type(p_exception));
+
+  void* object = p_answer.object;
+  if (thrown_type->__is_pointer_p()) {
+    object = *static_cast<void**>(object);
+  }
+  if (catch_type == thrown_type ||
+      catch_type->__do_catch(thrown_type, &object, 1)) {
+    p_answer.object = object;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Decide the frame of p_context like __gxx_personality_v0
+ *
+ * @return bool - false if the LSDA uses an encoding this routine does not read
+ */
+bool
+decide(const std::uint8_t* p_lsda,
+       _Unwind_Control_Block* p_exception,
+       _Unwind_Context* p_context,
+       frame_answer& p_answer) noexcept
+{
+  using namespace personality_actions;
+
+  // Landing pads are relative to the start of the function
+  if (*p_lsda++ != encoding_omit) {
+    return false;
+  }
+  const std::uint8_t* type_table = nullptr;
+  if (*p_lsda++ != encoding_omit) {
+    const auto offset = read_uleb128(p_lsda);
+    type_table = p_lsda + offset;
+  }
+  if (*p_lsda++ != encoding_uleb128) {
+    return false;
+  }
+  const auto call_site_size = read_uleb128(p_lsda);
+  const auto* action_table = p_lsda + call_site_size;
+
+  const auto start = _Unwind_GetRegionStart(p_context);
+  // The call instruction, the return address can belong to the next record
+  const auto call =
+    (_Unwind_GetGR(p_context, program_counter_register) & ~1U) - 1 - start;
+
+  std::uint32_t action = 0;
+  p_answer.type = found::terminate;
+  while (p_lsda < action_table) {
+    const auto site_start = read_uleb128(p_lsda);
+    const auto site_length = read_uleb128(p_lsda);
+    const auto landing_pad = read_uleb128(p_lsda);
+    action = read_uleb128(p_lsda);
+    if (call < site_start) {
+      break; // sorted, no later record covers the call either
+    }
+    if (call - site_start < site_length) {
+      p_answer.type = landing_pad == 0 ? found::nothing : found::cleanup;
+      p_answer.landing_pad = start + landing_pad;
+      break;
+    }
+  }
+  if (p_answer.type != found::cleanup || action == 0) {
+    return true;
+  }
+
+  bool cleanup = false;
+  const auto* record = action_table + action - 1;
+  while (true) {
+    const auto filter = read_sleb128(record);
+    const auto* next_field = record;
+    const auto next = read_sleb128(record);
+    if (filter == 0) {
+      cleanup = true;
+    } else if (filter < 0 || type_table == nullptr) {
+      p_answer.type = found::terminate;
+      p_answer.landing_pad = 0;
+      return true;
+    } else if (catches(type_table, filter, p_exception, p_answer)) {
+      p_answer.type = found::handler;
+      p_answer.switch_value = filter;
+      return true;
+    }
+    if (next == 0) {
+      break;
+    }
+    record = next_field + next;
+  }
+  p_answer.type = cleanup ? found::cleanup : found::nothing;
+  return true;
+}
+
+/// @return std::uint32_t - p_landing_pad with the Thumb bit of the frame, as
+/// _Unwind_SetIP would set it
+std::uint32_t
+with_thumb_bit(_Unwind_Context* p_context, std::uint32_t p_landing_pad) noexcept
+{
+  using namespace personality_actions;
+  return p_landing_pad |
+         (_Unwind_GetGR(p_context, program_counter_register) & 1U);
+}
+
+_Unwind_Reason_Code
+install_handler(_Unwind_Control_Block* p_exception,
+                _Unwind_Context* p_context,
+                std::int32_t p_switch_value,
+                std::uint32_t p_landing_pad) noexcept
+{
+  using namespace personality_actions;
+  _Unwind_SetGR(p_context,
+                exception_register,
+                reinterpret_cast<std::uintptr_t>(p_exception));
+  _Unwind_SetGR(p_context, switch_value_register, p_switch_value);
+  _Unwind_SetGR(p_context,
+                program_counter_register,
+                with_thumb_bit(p_context, p_landing_pad));
+  return _URC_INSTALL_CONTEXT;
+}
+} // namespace
+
+extern "C"
+{
+  // libsupc++, calls std::terminate with the exception caught
+  [[noreturn]] void __cxa_call_terminate(_Unwind_Control_Block*) noexcept;
+
+  _Unwind_Reason_Code __gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context)
+  {
+    using namespace personality_actions;
+
+    const auto phase = p_state & _US_ACTION_MASK;
+    const bool forced = p_state & _US_FORCE_UNWIND;
+    if (phase == _US_UNWIND_FRAME_RESUME ||
+        (phase == _US_VIRTUAL_UNWIND_FRAME && forced)) {
+      return continue_unwinding(p_exception, p_context);
+    }
+    if (phase != _US_VIRTUAL_UNWIND_FRAME &&
+        phase != _US_UNWIND_FRAME_STARTING) {
+      std::terminate();
+    }
+
+    // _Unwind_GetRegionStart and _Unwind_GetLanguageSpecificData read the
+    // exception through r12
+    _Unwind_SetGR(p_context,
+                  unwind_pointer_register,
+                  reinterpret_cast<std::uintptr_t>(p_exception));
+
+    frame_answer answer{ .object = exception_object(p_exception) };
+    const bool foreign = answer.object == nullptr;
+    auto& saved = p_exception->barrier_cache;
+
+    // The search phase already decided the handler frame
+    if (not forced && not foreign &&
+        is_handler_frame(p_state, p_exception, p_context)) {
+      const auto landing_pad = saved.bitpattern[landing_pad_word];
+      if (landing_pad == 0) {
+        __cxa_call_terminate(p_exception);
+      }
+      return install_handler(p_exception,
+                             p_context,
+                             saved.bitpattern[switch_value_word],
+                             landing_pad);
+    }
+
+    const auto* lsda = static_cast<const std::uint8_t*>(
+      _Unwind_GetLanguageSpecificData(p_context));
+    if (lsda == nullptr) {
+      return continue_unwinding(p_exception, p_context);
+    }
+    if (not decide(lsda, p_exception, p_context, answer)) {
+      return _URC_FAILURE;
+    }
+
+    if (answer.type == found::nothing) {
+      return continue_unwinding(p_exception, p_context);
+    }
+    if (phase == _US_VIRTUAL_UNWIND_FRAME) {
+      if (answer.type == found::cleanup) {
+        return continue_unwinding(p_exception, p_context);
+      }
+      if (not foreign) {
+        saved.sp = _Unwind_GetGR(p_context, stack_pointer_register);
+        saved.bitpattern[caught_object_word] =
+          reinterpret_cast<std::uintptr_t>(answer.object);
+        saved.bitpattern[switch_value_word] = answer.switch_value;
+        saved.bitpattern[lsda_word] = reinterpret_cast<std::uintptr_t>(lsda);
+        saved.bitpattern[landing_pad_word] =
+          answer.type == found::handler ? answer.landing_pad : 0;
+      }
+      return _URC_HANDLER_FOUND;
+    }
+
+    if (answer.type == found::cleanup) {
+      return install_cleanup(
+        p_exception, p_context, with_thumb_bit(p_context, answer.landing_pad));
+    }
+    if (answer.type == found::terminate) {
+      if (forced || foreign) {
+        std::terminate();
+      }
+      __cxa_call_terminate(p_exception);
+    }
+    // Forced unwinds and foreign exceptions are not recorded in the search
+    // phase, they find their handler again
+    return install_handler(
+      p_exception, p_context, answer.switch_value, answer.landing_pad);
+  }
+}
@@ -0,0 +1,30 @@
+#include "stack_usage.hpp"
+
+#include <cstdint>
+
+extern "C"
+{
+  // standard_arm.ld places the stack directly above the heap
+  extern std::uint32_t __heap_end[];
+}
+
+namespace stack_usage {
+std::uintptr_t
+stack_bottom() noexcept
+{
+  return reinterpret_cast<std::uintptr_t>(__heap_end);
+}
+
+std::uint32_t
+peak_since(std::uintptr_t p_mark) noexcept
+{
+  const auto* word =
+    reinterpret_cast<const volatile std::uint32_t*>(stack_bottom());
+  const auto* const end =
+    reinterpret_cast<const volatile std::uint32_t*>(p_mark);
+  while (word < end && *word == paint_pattern) {
+    word++;
+  }
+  return p_mark - reinterpret_cast<std::uintptr_t>(word);
+}
+} // namespace stack_usage
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+// Stack high water measurement by painting. paint() fills the unused part of
+// the stack, below the caller's frame, with a known pattern. Whatever runs
+// afterwards overwrites the pattern as deep as it goes, peak_since() finds the
+// deepest overwritten word. Words written with the pattern value itself are
+// missed, which at worst under reports by a few words.
+
+namespace stack_usage {
+inline constexpr std::uint32_t paint_pattern = 0xC5C5'C5C5;
+
+/**
+ * @return std::uintptr_t - lowest address of the stack, the end of the heap
+ * in standard_arm.ld
+ */
+std::uintptr_t
+stack_bottom() noexcept;
+
+/**
+ * Fill the stack from stack_bottom() up to the caller's stack pointer with
+ * paint_pattern. Inlined, so the stack pointer is that of the caller and not
+ * of a frame that goes away on return.
+ *
+ * @return std::uintptr_t - the stack pointer painted up to, pass it to
+ * peak_since()
+ */
+[[gnu::always_inline]] inline std::uintptr_t
+paint() noexcept
+{
+  std::uintptr_t stack_pointer = 0;
+  asm volatile("mov %0, sp" : "=r"(stack_pointer));
+  auto* word = reinterpret_cast<volatile std::uint32_t*>(stack_bottom());
+  auto* const end = reinterpret_cast<volatile std::uint32_t*>(stack_pointer);
+  while (word < end) {
+    *word++ = paint_pattern;
+  }
+  return stack_pointer;
+}
+
+/**
+ * @param p_mark - value returned by paint()
+ * @return std::uint32_t - bytes of stack below p_mark used since paint(). The
+ * whole painted region when the pattern is gone from the bottom, meaning the
+ * stack may have overflowed.
+ */
+std::uint32_t
+peak_since(std::uintptr_t p_mark) noexcept;
+} // namespace stack_usage
@@ -0,0 +1,521 @@
+/**
+ * @file throw_benchmark.cpp
+ * @brief Throw latency of every exhibit, see README.md for how to run it
+ *
+ * Each exhibit is called with its throw trigger disarmed (happy path) and
+ * armed (throw path). The throw path is timed from the call until control
+ * reaches whichever of these comes first:
+ *
+ *   - the exhibit returns, because it caught the exception itself
+ *   - the catch block in this file
+ *   - the terminate handler, for exceptions escaping a noexcept function
+ *
+ * Results are written over semihosting to throw_latency.csv in the working
+ * directory of the emulator.
+ *
+ * Built with NOEXCEPT_STACK_PAINTING, the stack is painted before every run
+ * and the peak stack use of each exhibit is written to stack_usage.csv. Chains
+ * of templated frames from deep_stack.hpp add the peak against the number of
+ * frames unwound to stack_depth.csv.
+ *
+ * Built with NOEXCEPT_UNWIND_TRACE, unwind_trace.csv breaks the throw path of
+ * every exhibit down into the phases of the unwinder, see unwind_trace.hpp.
+ * The tracing hooks add their own cost to throw_latency.csv.
+ *
+ * Built with NOEXCEPT_THROW_TELEMETRY, the records of throw_telemetry.hpp are
+ * drained after every exhibit to throw_telemetry.bin, for
+ * tools/telemetry_decoder. The recording hooks add their own cost to
+ * throw_latency.csv.
+ */
+#include <cinttypes>
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <limits>
+#include <span>
+#include <string_view>
+
+#include <cxxabi.h>
+
+#include "cycle_counter.hpp"
+#include "exhibits.hpp"
+#include "semihost.hpp"
+
+#if defined(NOEXCEPT_PERSONALITY_CACHE)
+#include "personality_cache.hpp"
+#endif
+
+#if defined(NOEXCEPT_UNWIND_PLAN)
+#include "unwind_plan.hpp"
+#endif
+
+#if defined(NOEXCEPT_STACK_PAINTING)
+#include <utility>
+
+#include "deep_stack.hpp"
+#include "stack_usage.hpp"
+#endif
+
+#if defined(NOEXCEPT_UNWIND_TRACE)
+#include "unwind_trace.hpp"
+#endif
+
+#if defined(NOEXCEPT_THROW_TELEMETRY)
+#include "throw_telemetry.hpp"
+#endif
+
+#if not defined(NOEXCEPT_CPU_HZ)
+#define NOEXCEPT_CPU_HZ 120000000
+#endif
+
+#if not defined(NOEXCEPT_ICOUNT_SHIFT)
+#define NOEXCEPT_ICOUNT_SHIFT 4
+#endif
+
+extern "C"
+{
+  void _exit(int rc) // NOLINT
+  {
+    semihost::exit(rc);
+  }
+}
+
+namespace {
+enum class throw_outcome : std::uint8_t
+{
+  /// The exhibit cannot throw, there is no throw path to measure
+  none,
+  /// The exception was handled inside of the exhibit, which then returned
+  returned,
+  /// The exception propagated out of the exhibit
+  caught,
+  /// The exception reached a noexcept boundary and std::terminate was called
+  terminated,
+};
+
+const char*
+to_string(throw_outcome p_outcome)
+{
+  switch (p_outcome) {
+    case throw_outcome::none:
+      return "none";
+    case throw_outcome::returned:
+      return "returned";
+    case throw_outcome::caught:
+      return "caught";
+    case throw_outcome::terminated:
+      return "terminate";
+  }
+  return "unknown";
+}
+
+struct measurement
+{
+  std::uint32_t count = 0;
+  throw_outcome outcome = throw_outcome::none;
+  /// Deepest stack use below measure_once(), with NOEXCEPT_STACK_PAINTING
+  std::uint32_t stack_bytes = 0;
+  /// Stack available below measure_once(), stack_bytes reaching it means the
+  /// stack overflowed
+  std::uint32_t stack_limit = 0;
+};
+
+// Every path is deterministic under QEMU, repeat it anyway so that hardware
+// runs can drop samples disturbed by interrupts.
+constexpr int repetitions = 4;
+
+std::jmp_buf terminate_jump{};
+volatile std::uint32_t terminate_time = 0;
+
+[[noreturn]] void
+return_from_terminate()
+{
+  terminate_time = cycle_counter::now();
+  std::longjmp(terminate_jump, 1);
+}
+
+[[gnu::noinline]] measurement
+measure_once(const exhibit& p_exhibit)
+{
+  volatile std::uint32_t end = 0;
+  volatile throw_outcome outcome = throw_outcome::returned;
+#if defined(NOEXCEPT_STACK_PAINTING)
+  // Painted before the clock starts, the timing is the same either way
+  const auto stack_mark = stack_usage::paint();
+#endif
+  const std::uint32_t start = cycle_counter::now();
+
+  if (setjmp(terminate_jump) == 0) {
+    try {
+      p_exhibit.run();
+      end = cycle_counter::now();
+    } catch (...) {
+      end = cycle_counter::now();
+      outcome = throw_outcome::caught;
+    }
+  } else {
+    end = terminate_time;
+    outcome = throw_outcome::terminated;
+    // libsupc++ begins catching the exception before calling terminate,
+    // finish catching it so the exception object is released.
+    __cxxabiv1::__cxa_end_catch();
+  }
+
+  measurement result{ .count = cycle_counter::elapsed(start, end),
+                      .outcome = outcome };
+#if defined(NOEXCEPT_STACK_PAINTING)
+  result.stack_bytes = stack_usage::peak_since(stack_mark);
+  result.stack_limit = stack_mark - stack_usage::stack_bottom();
+#endif
+  return result;
+}
+
+measurement
+measure(const exhibit& p_exhibit, throw_trigger p_trigger)
+{
+  measurement best{ .count = std::numeric_limits<std::uint32_t>::max() };
+  for (int i = 0; i < repetitions; i++) {
+    arm_trigger(p_trigger);
+    const auto result = measure_once(p_exhibit);
+    const auto stack_bytes = std::max(best.stack_bytes, result.stack_bytes);
+    if (result.count < best.count) {
+      best = result;
+    }
+    best.stack_bytes = stack_bytes;
+  }
+  disarm_triggers();
+  return best;
+}
+
+std::uint32_t
+measurement_overhead()
+{
+  std::uint32_t best = std::numeric_limits<std::uint32_t>::max();
+  const exhibit empty{
+    .number = 0, .name = "", .is_noexcept = true, .trigger = {}, .run = [] {}
+  };
+  for (int i = 0; i < repetitions; i++) {
+    best = std::min(best, measure_once(empty).count);
+  }
+  return best;
+}
+
+std::uint32_t
+to_report_units(std::uint32_t p_count,
+                std::uint32_t p_overhead,
+                cycle_counter::source p_source)
+{
+  const auto count = p_count - std::min(p_count, p_overhead);
+  if (p_source == cycle_counter::source::dwt_cycles) {
+    return count;
+  }
+  return cycle_counter::to_instructions(
+    count, NOEXCEPT_CPU_HZ, NOEXCEPT_ICOUNT_SHIFT);
+}
+
+void
+write_row(semihost::file& p_csv, std::span<char> p_row, int p_length)
+{
+  p_csv.write(p_row.first(std::min<std::size_t>(p_length, p_row.size())));
+}
+
+#if defined(NOEXCEPT_STACK_PAINTING)
+constexpr std::string_view stack_usage_header =
+  "exhibit,function,noexcept,trigger,happy_stack_bytes,throw_stack_bytes,"
+  "throw_outcome,stack_limit_bytes\n";
+
+/// Frames unwound by the chains measured for stack_depth.csv
+constexpr std::array<std::uint32_t, 6> stack_depths{ 1, 2, 3, 4, 6, 8 };
+/// non_trivial_dtor locals in every frame of those chains
+constexpr std::size_t stack_depth_dtors = 1;
+
+constexpr auto stack_depth_chains =
+  []<std::size_t... I>(std::index_sequence<I...>) {
+    return std::array<void (*)(), sizeof...(I)>{
+      &deep_stack::templated_frame<stack_depths[I], stack_depth_dtors>...
+    };
+  }(std::make_index_sequence<stack_depths.size()>{});
+
+/**
+ * Peak stack of a throw from bar() through each of stack_depth_chains, to
+ * stack_depth.csv
+ *
+ * @return bool - false if the file could not be opened
+ */
+bool
+write_stack_depths()
+{
+  semihost::file csv("stack_depth.csv");
+  if (not csv.is_open()) {
+    return false;
+  }
+
+  constexpr std::string_view header =
+    "frames,dtors_per_frame,happy_stack_bytes,throw_stack_bytes,"
+    "stack_limit_bytes\n";
+  csv.write(header);
+
+  std::array<char, 96> row{};
+  for (std::size_t i = 0; i < stack_depths.size(); i++) {
+    const exhibit chain{ .number = 0,
+                         .name = "templated_frame",
+                         .is_noexcept = false,
+                         .trigger = throw_trigger::bar,
+                         .run = stack_depth_chains[i] };
+    const auto happy = measure(chain, throw_trigger::none);
+    const auto thrown = measure(chain, throw_trigger::bar);
+    const int length = std::snprintf(row.data(),
+                                     row.size(),
+                                     "%" PRIu32 ",%zu,%" PRIu32 ",%" PRIu32
+                                     ",%" PRIu32 "\n",
+                                     stack_depths[i],
+                                     stack_depth_dtors,
+                                     happy.stack_bytes,
+                                     thrown.stack_bytes,
+                                     thrown.stack_limit);
+    write_row(csv, row, length);
+  }
+  return true;
+}
+#endif
+
+#if defined(NOEXCEPT_UNWIND_TRACE)
+constexpr std::string_view unwind_trace_header =
+  "exhibit,function,throw_outcome,search_frames,unwind_frames,"
+  "personality_calls,cleanup_pads,throw_setup,search,unwind,personality,"
+  "cleanup,catch_entry,handler,unit\n";
+
+/**
+ * Write the phases of the last throw, that of p_exhibit's throw path
+ */
+void
+write_trace_row(semihost::file& p_csv,
+                std::span<char> p_row,
+                const exhibit& p_exhibit,
+                throw_outcome p_outcome,
+                cycle_counter::source p_source,
+                const char* p_unit)
+{
+  const auto trace = unwind_trace::last_throw();
+  const auto units = [p_source](std::uint32_t p_count) {
+    return to_report_units(p_count, 0, p_source);
+  };
+  const int length = std::snprintf(
+    p_row.data(),
+    p_row.size(),
+    "%u,%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+    ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32
+    ",%s\n",
+    p_exhibit.number,
+    p_exhibit.name,
+    to_string(p_outcome),
+    trace.search_frames,
+    trace.unwind_frames,
+    trace.personality_calls,
+    trace.cleanup_pads,
+    units(trace.throw_setup),
+    units(trace.search),
+    units(trace.unwind),
+    units(trace.personality),
+    units(trace.cleanup),
+    units(trace.catch_entry),
+    units(trace.handler),
+    p_unit);
+  write_row(p_csv, p_row, length);
+}
+#endif
+
+#if defined(NOEXCEPT_THROW_TELEMETRY)
+/**
+ * Move every record in the telemetry ring to p_stream
+ */
+void
+drain_telemetry(semihost::file& p_stream)
+{
+  std::array<std::uint8_t, 8 * throw_telemetry::record_size> buffer{};
+  while (true) {
+    const auto length = throw_telemetry::drain(buffer);
+    if (length == 0) {
+      return;
+    }
+    p_stream.write(
+      std::span(reinterpret_cast<const char*>(buffer.data()), length));
+  }
+}
+#endif
+} // namespace
+
+int
+main()
+{
+  const auto source = cycle_counter::enable();
+  const char* unit =
+    (source == cycle_counter::source::dwt_cycles) ? "cycles" : "instructions";
+
+  std::set_terminate(return_from_terminate);
+  const auto overhead = measurement_overhead();
+
+  semihost::file csv("throw_latency.csv");
+  if (not csv.is_open()) {
+    semihost::write("throw_benchmark: unable to open throw_latency.csv\n");
+    return 1;
+  }
+
+  std::array<char, 256> row{};
+  constexpr std::string_view header =
+    "exhibit,function,noexcept,trigger,happy_path,throw_path,throw_outcome,"
+    "unit\n";
+  csv.write(header);
+
+#if defined(NOEXCEPT_STACK_PAINTING)
+  semihost::file stack_csv("stack_usage.csv");
+  if (not stack_csv.is_open()) {
+    semihost::write("throw_benchmark: unable to open stack_usage.csv\n");
+    return 1;
+  }
+  stack_csv.write(stack_usage_header);
+#endif
+
+#if defined(NOEXCEPT_UNWIND_TRACE)
+  semihost::file trace_csv("unwind_trace.csv");
+  if (not trace_csv.is_open()) {
+    semihost::write("throw_benchmark: unable to open unwind_trace.csv\n");
+    return 1;
+  }
+  trace_csv.write(unwind_trace_header);
+#endif
+
+#if defined(NOEXCEPT_THROW_TELEMETRY)
+  semihost::file telemetry("throw_telemetry.bin", semihost::file_mode::binary);
+  if (not telemetry.is_open()) {
+    semihost::write("throw_benchmark: unable to open throw_telemetry.bin\n");
+    return 1;
+  }
+  std::array<std::uint8_t, throw_telemetry::stream_header_size>
+    telemetry_header{};
+  throw_telemetry::write_stream_header(telemetry_header);
+  telemetry.write(std::span(
+    reinterpret_cast<const char*>(telemetry_header.data()),
+    telemetry_header.size()));
+#endif
+
+  for (const auto& entry : exhibits()) {
+    const auto happy = measure(entry, throw_trigger::none);
+    auto throw_path = measurement{};
+    if (entry.trigger != throw_trigger::none) {
+      throw_path = measure(entry, entry.trigger);
+#if defined(NOEXCEPT_UNWIND_TRACE)
+      write_trace_row(
+        trace_csv, row, entry, throw_path.outcome, source, unit);
+#endif
+    }
+
+    const auto happy_count = to_report_units(happy.count, overhead, source);
+    const auto throw_count =
+      to_report_units(throw_path.count, overhead, source);
+
+    std::array<char, 16> throw_column{};
+    if (throw_path.outcome != throw_outcome::none) {
+      std::snprintf(throw_column.data(),
+                    throw_column.size(),
+                    "%" PRIu32,
+                    throw_count);
+    }
+
+    const int length = std::snprintf(row.data(),
+                                     row.size(),
+                                     "%u,%s,%s,%s,%" PRIu32 ",%s,%s,%s\n",
+                                     entry.number,
+                                     entry.name,
+                                     entry.is_noexcept ? "True" : "False",
+                                     to_string(entry.trigger),
+                                     happy_count,
+                                     throw_column.data(),
+                                     to_string(throw_path.outcome),
+                                     unit);
+    write_row(csv, row, length);
+
+#if defined(NOEXCEPT_STACK_PAINTING)
+    std::array<char, 16> throw_stack{};
+    if (throw_path.outcome != throw_outcome::none) {
+      std::snprintf(throw_stack.data(),
+                    throw_stack.size(),
+                    "%" PRIu32,
+                    throw_path.stack_bytes);
+    }
+    const int stack_length = std::snprintf(row.data(),
+                                           row.size(),
+                                           "%u,%s,%s,%s,%" PRIu32
+                                           ",%s,%s,%" PRIu32 "\n",
+                                           entry.number,
+                                           entry.name,
+                                           entry.is_noexcept ? "True" : "False",
+                                           to_string(entry.trigger),
+                                           happy.stack_bytes,
+                                           throw_stack.data(),
+                                           to_string(throw_path.outcome),
+                                           happy.stack_limit);
+    write_row(stack_csv, row, stack_length);
+#endif
+
+#if defined(NOEXCEPT_THROW_TELEMETRY)
+    drain_telemetry(telemetry);
+#endif
+  }
+
+  semihost::write("throw_benchmark: wrote throw_latency.csv\n");
+
+#if defined(NOEXCEPT_STACK_PAINTING)
+  if (not write_stack_depths()) {
+    semihost::write("throw_benchmark: unable to open stack_depth.csv\n");
+    return 1;
+  }
+  semihost::write(
+    "throw_benchmark: wrote stack_usage.csv and stack_depth.csv\n");
+#endif
+
+#if defined(NOEXCEPT_PERSONALITY_CACHE)
+  const auto cache = personality_cache::read_statistics();
+  std::snprintf(row.data(),
+                row.size(),
+                "throw_benchmark: personality cache hits %" PRIu32
+                ", misses %" PRIu32 ", evictions %" PRIu32
+                ", bypassed %" PRIu32 "\n",
+                cache.hits,
+                cache.misses,
+                cache.evictions,
+                cache.bypassed);
+  semihost::write(row.data());
+#endif
+
+#if defined(NOEXCEPT_UNWIND_PLAN)
+  // An image that did not go through tools/unwind_planner misses every frame
+  const auto plan = unwind_plan::read_statistics();
+  std::snprintf(row.data(),
+                row.size(),
+                "throw_benchmark: unwind plan frames %" PRIu32 ", hits %" PRIu32
+                ", misses %" PRIu32 ", bypassed %" PRIu32 "\n",
+                unwind_plan::planned_frames(),
+                plan.hits,
+                plan.misses,
+                plan.bypassed);
+  semihost::write(row.data());
+#endif
+
+#if defined(NOEXCEPT_THROW_TELEMETRY)
+  const auto recorded = throw_telemetry::read_statistics();
+  std::snprintf(row.data(),
+                row.size(),
+                "throw_benchmark: wrote throw_telemetry.bin, recorded %" PRIu32
+                ", dropped %" PRIu32 ", untracked %" PRIu32 "\n",
+                recorded.recorded,
+                recorded.dropped,
+                recorded.untracked);
+  semihost::write(row.data());
+#endif
+  return 0;
+}
@@ -0,0 +1,282 @@
+#include "throw_telemetry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <span>
+
+#include <unwind.h>
+
+#include "atomic_update.hpp"
+#include "cxa_abi.hpp"
+#include "cycle_counter.hpp"
+#include "exception_pool.hpp"
+
+#if not defined(NOEXCEPT_THROW_TELEMETRY_CAPACITY)
+#define NOEXCEPT_THROW_TELEMETRY_CAPACITY 32
+#endif
+
+extern "C"
+{
+  [[noreturn]] void __real___cxa_throw(void* p_object, // NOLINT
+                                       void* p_type,
+                                       void (*p_destructor)(void*));
+  _Unwind_Reason_Code __real___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context);
+  void* __real___cxa_begin_catch(void* p_exception) noexcept; // NOLINT
+}
+
+namespace throw_telemetry {
+namespace {
+constexpr std::uint32_t capacity = NOEXCEPT_THROW_TELEMETRY_CAPACITY;
+static_assert(std::has_single_bit(capacity),
+              "NOEXCEPT_THROW_TELEMETRY_CAPACITY must be a power of two");
+static_assert(in_flight_limit <= 32, "in_flight_limit must fit the mask");
+
+struct cell
+{
+  /// Position + 1 once the record at position is complete
+  std::atomic<std::uint32_t> sequence{ 0 };
+  record value{};
+};
+
+/// A throw between __cxa_throw and __cxa_begin_catch
+struct in_flight
+{
+  /// Unwinder control block of the exception, nullptr while the entry is
+  /// being claimed or released
+  const void* exception = nullptr;
+  std::uint32_t throw_address = 0;
+  std::uint32_t start = 0;
+  std::uint16_t frames = 0;
+  std::uint16_t object_size = 0;
+};
+
+std::array<cell, capacity> ring{};
+/// Next position producers reserve
+std::atomic<std::uint32_t> head{ 0 };
+/// Next position drain() reads, written only by drain()
+std::atomic<std::uint32_t> tail{ 0 };
+std::atomic<std::uint32_t> recorded_count{ 0 };
+std::atomic<std::uint32_t> dropped_count{ 0 };
+std::atomic<std::uint32_t> untracked_count{ 0 };
+/// dropped_count at the last drop record drain() wrote
+std::uint32_t reported_drops = 0;
+
+std::array<in_flight, in_flight_limit> throws{};
+std::atomic<std::uint32_t> claimed_throws{ 0 };
+
+const void*
+control_block(void* p_object)
+{
+  auto* header = static_cast<cxa_refcounted_exception_header*>(p_object) - 1;
+  return &header->exception.unwind_header;
+}
+
+/// Clear the Thumb bit, the address is looked up in the symbol table
+std::uint32_t
+return_address(void* p_address)
+{
+  return static_cast<std::uint32_t>(
+           reinterpret_cast<std::uintptr_t>(p_address)) &
+         ~1U;
+}
+
+in_flight*
+find(const void* p_exception)
+{
+  auto claimed = claimed_throws.load(std::memory_order_acquire);
+  while (claimed != 0) {
+    auto& entry = throws[std::countr_zero(claimed)];
+    if (entry.exception == p_exception) {
+      return &entry;
+    }
+    claimed &= claimed - 1;
+  }
+  return nullptr;
+}
+
+in_flight*
+claim()
+{
+  std::uint32_t bit = 0;
+  atomic_update(claimed_throws, [&bit](std::uint32_t p_claimed) {
+    constexpr std::uint32_t all = (1ULL << in_flight_limit) - 1;
+    bit = ~p_claimed & (p_claimed + 1) & all;
+    return p_claimed | bit;
+  });
+  if (bit == 0) {
+    return nullptr;
+  }
+  return &throws[std::countr_zero(bit)];
+}
+
+void
+release(in_flight& p_entry)
+{
+  p_entry.exception = nullptr;
+  const auto bit = 1U << (&p_entry - throws.data());
+  atomic_update(claimed_throws,
+                [bit](std::uint32_t p_claimed) { return p_claimed & ~bit; });
+}
+
+void
+push(const record& p_record)
+{
+  bool reserved = false;
+  const auto position =
+    atomic_update(head, [&reserved](std::uint32_t p_head) {
+      reserved = p_head - tail.load(std::memory_order_acquire) < capacity;
+      return reserved ? p_head + 1 : p_head;
+    });
+  if (not reserved) {
+    atomic_update(dropped_count,
+                  [](std::uint32_t p_count) { return p_count + 1; });
+    return;
+  }
+
+  auto& slot = ring[position & (capacity - 1)];
+  slot.value = p_record;
+  slot.sequence.store(position + 1, std::memory_order_release);
+  atomic_update(recorded_count,
+                [](std::uint32_t p_count) { return p_count + 1; });
+}
+
+template<typename Value>
+std::uint8_t*
+put(std::uint8_t* p_out, Value p_value)
+{
+  for (std::size_t i = 0; i < sizeof(Value); i++) {
+    *p_out++ = static_cast<std::uint8_t>(p_value >> (8 * i));
+  }
+  return p_out;
+}
+
+std::uint8_t*
+put(std::uint8_t* p_out, const record& p_record)
+{
+  p_out = put(p_out, p_record.throw_address);
+  p_out = put(p_out, p_record.catch_address);
+  p_out = put(p_out, p_record.cycles);
+  p_out = put(p_out, p_record.frames);
+  return put(p_out, p_record.object_size);
+}
+} // namespace
+
+std::size_t
+write_stream_header(std::span<std::uint8_t> p_buffer) noexcept
+{
+  if (p_buffer.size() < stream_header_size) {
+    return 0;
+  }
+  auto* out = p_buffer.data();
+  for (const char letter : { 'N', 'X', 'T', 'R' }) {
+    *out++ = static_cast<std::uint8_t>(letter);
+  }
+  out = put(out, stream_version);
+  put(out, static_cast<std::uint16_t>(record_size));
+  return stream_header_size;
+}
+
+std::size_t
+drain(std::span<std::uint8_t> p_buffer) noexcept
+{
+  auto* out = p_buffer.data();
+  auto space = p_buffer.size();
+
+  const auto dropped = dropped_count.load(std::memory_order_relaxed);
+  if (dropped != reported_drops && space >= record_size) {
+    out = put(out, record{ .cycles = dropped - reported_drops });
+    space -= record_size;
+    reported_drops = dropped;
+  }
+
+  auto position = tail.load(std::memory_order_relaxed);
+  while (space >= record_size) {
+    auto& slot = ring[position & (capacity - 1)];
+    // Not yet reserved, or reserved but still being written
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+      break;
+    }
+    out = put(out, slot.value);
+    space -= record_size;
+    position++;
+    tail.store(position, std::memory_order_release);
+  }
+  return p_buffer.size() - space;
+}
+
+statistics
+read_statistics() noexcept
+{
+  return {
+    .recorded = recorded_count.load(std::memory_order_relaxed),
+    .dropped = dropped_count.load(std::memory_order_relaxed),
+    .untracked = untracked_count.load(std::memory_order_relaxed),
+  };
+}
+} // namespace throw_telemetry
+
+extern "C"
+{
+  [[noreturn]] void __wrap___cxa_throw(void* p_object, // NOLINT
+                                       void* p_type,
+                                       void (*p_destructor)(void*))
+  {
+    using namespace throw_telemetry;
+    const auto start = cycle_counter::now();
+    auto* entry = claim();
+    if (entry == nullptr) {
+      atomic_update(untracked_count,
+                    [](std::uint32_t p_count) { return p_count + 1; });
+    } else {
+      entry->throw_address = return_address(__builtin_return_address(0));
+      entry->start = start;
+      entry->frames = 0;
+      entry->object_size =
+        static_cast<std::uint16_t>(exception_pool::object_size(p_object));
+      entry->exception = control_block(p_object);
+    }
+    __real___cxa_throw(p_object, p_type, p_destructor);
+  }
+
+  _Unwind_Reason_Code __wrap___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context)
+  {
+    using namespace throw_telemetry;
+    if ((p_state & _US_ACTION_MASK) == _US_UNWIND_FRAME_STARTING) {
+      if (auto* entry = find(p_exception); entry != nullptr) {
+        entry->frames++;
+      }
+    }
+    return __real___gxx_personality_v0(p_state, p_exception, p_context);
+  }
+
+  void* __wrap___cxa_begin_catch(void* p_exception) noexcept // NOLINT
+  {
+    using namespace throw_telemetry;
+    auto* object = __real___cxa_begin_catch(p_exception);
+    auto* entry = find(p_exception);
+    if (entry == nullptr) {
+      return object;
+    }
+
+    const auto end = cycle_counter::now();
+    push({
+      .throw_address = entry->throw_address,
+      .catch_address = return_address(__builtin_return_address(0)),
+      .cycles = cycle_counter::elapsed(entry->start, end),
+      .frames = entry->frames,
+      .object_size = entry->object_size,
+    });
+    release(*entry);
+    return object;
+  }
+}
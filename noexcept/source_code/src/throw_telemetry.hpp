@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <span>
+
+// Record of every throw kept on the target, installed with -Wl,--wrap in front
+// of __cxa_throw, __gxx_personality_v0 and __cxa_begin_catch when
+// NOEXCEPT_THROW_TELEMETRY is on.
+//
+// A throw is followed from __cxa_throw until __cxa_begin_catch, when one record
+// goes into a fixed ring. Producers never wait: a full ring drops the record
+// and counts it. A single low priority consumer calls drain() to move records
+// out in the stream format below, which tools/telemetry_decoder turns into CSV
+// with the symbols of the ELF file. Code that does not throw runs none of it.
+//
+// Stream format, little endian:
+//
+//   header   "NXTR", u16 version, u16 record size
+//   record   u32 throw address, u32 catch address, u32 cycles,
+//            u16 frames, u16 object size
+//
+// A record with a throw address of 0 reports records dropped since the
+// previous drain(), their count is in cycles. Rethrows are not followed, and
+// at most in_flight_limit throws can be followed at once.
+
+namespace throw_telemetry {
+struct record
+{
+  /// Return address of the call to __cxa_throw
+  std::uint32_t throw_address = 0;
+  /// Return address of the call to __cxa_begin_catch, in the handler
+  std::uint32_t catch_address = 0;
+  /// cycle_counter counts from __cxa_throw to __cxa_begin_catch
+  std::uint32_t cycles = 0;
+  /// Frames unwound on the way to the handler
+  std::uint16_t frames = 0;
+  /// Size of the exception object, without the ABI header
+  std::uint16_t object_size = 0;
+};
+
+inline constexpr std::uint16_t stream_version = 1;
+inline constexpr std::size_t stream_header_size = 8;
+inline constexpr std::size_t record_size = 16;
+/// Throws followed at once, a throw from a destructor during unwinding is a
+/// second one
+inline constexpr std::size_t in_flight_limit = 4;
+
+struct statistics
+{
+  /// Records that went into the ring
+  std::uint32_t recorded = 0;
+  /// Records lost to a full ring
+  std::uint32_t dropped = 0;
+  /// Throws not followed, because in_flight_limit throws already were
+  std::uint32_t untracked = 0;
+};
+
+/**
+ * Write the header that starts every stream
+ *
+ * @param p_buffer - at least stream_header_size bytes
+ * @return std::size_t - bytes written, 0 if p_buffer is too small
+ */
+std::size_t
+write_stream_header(std::span<std::uint8_t> p_buffer) noexcept;
+
+/**
+ * Move records out of the ring, oldest first. Must not be called from more
+ * than one context at a time.
+ *
+ * @param p_buffer - receives whole records in the stream format
+ * @return std::size_t - bytes written, 0 once the ring is empty
+ */
+std::size_t
+drain(std::span<std::uint8_t> p_buffer) noexcept;
+
+/**
+ * @return statistics - snapshot of the telemetry counters
+ */
+statistics
+read_statistics() noexcept;
+} // namespace throw_telemetry
@@ -0,0 +1,192 @@
+#include "thumb2.hpp"
+
+#include <bit>
+
+namespace {
+constexpr std::uint32_t stack_pointer = 13;
+constexpr std::uint32_t link_register = 14;
+constexpr std::uint32_t program_counter = 15;
+
+/// Sign extend the lowest p_bits of p_value
+constexpr std::int32_t
+sign_extend(std::uint32_t p_value, unsigned p_bits)
+{
+  const auto shift = 32 - p_bits;
+  return static_cast<std::int32_t>(p_value << shift) >> shift;
+}
+
+/// Branch targets are relative to the instruction address plus 4
+constexpr std::uint32_t
+relative(std::uint32_t p_address, std::int32_t p_offset)
+{
+  return p_address + 4 + p_offset;
+}
+
+std::optional<branch>
+decode_narrow(std::uint32_t p_address, std::uint16_t p_instruction)
+{
+  // B<c> T1, condition codes 0b1110 and 0b1111 are UDF and SVC
+  if ((p_instruction & 0xF000) == 0xD000) {
+    const auto condition = (p_instruction >> 8) & 0xF;
+    if (condition >= 0b1110) {
+      return std::nullopt;
+    }
+    const auto offset = sign_extend((p_instruction & 0xFF) << 1, 9);
+    return branch{
+      p_address, relative(p_address, offset), branch_kind::jump, true
+    };
+  }
+
+  // CBZ and CBNZ, forward only
+  if ((p_instruction & 0xF500) == 0xB100) {
+    const auto offset =
+      static_cast<std::int32_t>(((p_instruction >> 3) & 0x40) |
+                                ((p_instruction >> 2) & 0x3E));
+    return branch{
+      p_address, relative(p_address, offset), branch_kind::jump, true
+    };
+  }
+
+  // B T2
+  if ((p_instruction & 0xF800) == 0xE000) {
+    const auto offset = sign_extend((p_instruction & 0x7FF) << 1, 12);
+    return branch{ p_address, relative(p_address, offset), branch_kind::jump };
+  }
+
+  const auto source_register = (p_instruction >> 3) & 0xF;
+
+  // BX, through lr it is a return
+  if ((p_instruction & 0xFF87) == 0x4700) {
+    if (source_register == link_register) {
+      return std::nullopt;
+    }
+    return branch{ p_address, 0, branch_kind::indirect_jump };
+  }
+
+  // BLX register
+  if ((p_instruction & 0xFF87) == 0x4780) {
+    return branch{ p_address, 0, branch_kind::indirect_call };
+  }
+
+  // MOV pc, register, through lr it is a return
+  if ((p_instruction & 0xFF87) == 0x4687) {
+    if (source_register == link_register) {
+      return std::nullopt;
+    }
+    return branch{ p_address, 0, branch_kind::indirect_jump };
+  }
+
+  return std::nullopt;
+}
+
+std::optional<branch>
+decode_wide(std::uint32_t p_address,
+            std::uint16_t p_first_halfword,
+            std::uint16_t p_second_halfword)
+{
+  // LDR pc, as used by long branch veneers. Loads from sp are returns.
+  if ((p_first_halfword & 0xFF70) == 0xF850 &&
+      (p_second_halfword >> 12) == program_counter) {
+    const auto base_register = p_first_halfword & 0xF;
+    if (base_register == stack_pointer) {
+      return std::nullopt;
+    }
+    return branch{ p_address, 0, branch_kind::indirect_jump };
+  }
+
+  // Every 32-bit branch starts with 0b11110 and has bit 15 of the second
+  // halfword set
+  if ((p_first_halfword & 0xF800) != 0xF000 ||
+      not(p_second_halfword & 0x8000)) {
+    return std::nullopt;
+  }
+
+  const std::uint32_t s = (p_first_halfword >> 10) & 1;
+  const std::uint32_t j1 = (p_second_halfword >> 13) & 1;
+  const std::uint32_t j2 = (p_second_halfword >> 11) & 1;
+  const std::uint32_t imm11 = p_second_halfword & 0x7FF;
+
+  switch (p_second_halfword & 0xD000) {
+    case 0xD000:   // BL
+    case 0x9000: { // B.W T4
+      const std::uint32_t i1 = not(j1 ^ s);
+      const std::uint32_t i2 = not(j2 ^ s);
+      const std::uint32_t imm10 = p_first_halfword & 0x3FF;
+      const auto offset = sign_extend(
+        (s << 24) | (i1 << 23) | (i2 << 22) | (imm10 << 12) | (imm11 << 1), 25);
+      const auto kind = (p_second_halfword & 0x4000) ? branch_kind::call
+                                                      : branch_kind::jump;
+      return branch{ p_address, relative(p_address, offset), kind };
+    }
+    case 0x8000: { // B<c>.W T3, the other conditions encode miscellaneous
+                   // control instructions such as msr and dsb
+      const auto condition = (p_first_halfword >> 6) & 0xF;
+      if (condition >= 0b1110) {
+        return std::nullopt;
+      }
+      const std::uint32_t imm6 = p_first_halfword & 0x3F;
+      const auto offset = sign_extend(
+        (s << 20) | (j2 << 19) | (j1 << 18) | (imm6 << 12) | (imm11 << 1), 21);
+      return branch{
+        p_address, relative(p_address, offset), branch_kind::jump, true
+      };
+    }
+    default:
+      return std::nullopt;
+  }
+}
+} // namespace
+
+std::optional<branch>
+decode_branch(std::uint32_t p_address,
+              std::uint16_t p_first_halfword,
+              std::uint16_t p_second_halfword)
+{
+  if (is_wide_instruction(p_first_halfword)) {
+    return decode_wide(p_address, p_first_halfword, p_second_halfword);
+  }
+  return decode_narrow(p_address, p_first_halfword);
+}
+
+bool
+is_return(std::uint16_t p_first_halfword, std::uint16_t p_second_halfword)
+{
+  if (not is_wide_instruction(p_first_halfword)) {
+    const auto source_register = (p_first_halfword >> 3) & 0xF;
+    // BX lr and MOV pc, lr
+    if ((p_first_halfword & 0xFF87) == 0x4700 ||
+        (p_first_halfword & 0xFF87) == 0x4687) {
+      return source_register == link_register;
+    }
+    // POP T1 with pc in the register list
+    return (p_first_halfword & 0xFF00) == 0xBD00;
+  }
+
+  // POP.W T2, ldmia sp! with pc in the register list
+  if (p_first_halfword == 0xE8BD) {
+    return (p_second_halfword & 0x8000) != 0;
+  }
+  // LDR pc from sp, POP.W T3 among them
+  return (p_first_halfword & 0xFF7F) == (0xF850 | stack_pointer) &&
+         (p_second_halfword >> 12) == program_counter;
+}
+
+bool
+is_table_branch(std::uint16_t p_first_halfword,
+                std::uint16_t p_second_halfword)
+{
+  return (p_first_halfword & 0xFFF0) == 0xE8D0 &&
+         (p_second_halfword & 0xFFE0) == 0xF000;
+}
+
+std::uint32_t
+it_block_length(std::uint16_t p_first_halfword)
+{
+  // The position of the lowest set bit of the mask gives the block's length,
+  // a mask of 0 encodes the hints nop, yield, wfe, wfi and sev instead
+  const std::uint32_t mask = p_first_halfword & 0xF;
+  if ((p_first_halfword & 0xFF00) != 0xBF00 || mask == 0) {
+    return 0;
+  }
+  return 4 - std::countr_zero(mask);
+}
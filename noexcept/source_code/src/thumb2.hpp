@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+#include <optional>
+#include <span>
+
+// Just enough of a Thumb-2 decoder to follow control flow between and within
+// functions. Every instruction is measured so the stream stays in sync, only
+// branches, returns and IT blocks are decoded further.
+
+enum class branch_kind : std::uint8_t
+{
+  /// bl, the target is known
+  call,
+  /// b, b.w, cbz, cbnz and their conditional forms, the target is known
+  jump,
+  /// blx to a register
+  indirect_call,
+  /// bx or mov pc to a register other than lr, ldr pc from anywhere but sp
+  indirect_jump,
+};
+
+struct branch
+{
+  /// Address of the branch instruction
+  std::uint32_t address = 0;
+  /// Destination of direct branches, 0 for indirect ones
+  std::uint32_t target = 0;
+  branch_kind kind = branch_kind::call;
+  /// Falls through when not taken, b<c>, b<c>.w, cbz and cbnz. Instructions
+  /// inside an IT block are conditional too, see it_block_length().
+  bool conditional = false;
+};
+
+/**
+ * @param p_first_halfword - first halfword of an instruction
+ * @return true - if the instruction is 32 bits wide, false if it is 16 bits
+ */
+constexpr bool
+is_wide_instruction(std::uint16_t p_first_halfword)
+{
+  // 0b11101, 0b11110 and 0b11111 in the top five bits start a 32-bit encoding
+  return (p_first_halfword >> 11) >= 0b11101;
+}
+
+/**
+ * @param p_address - address of the instruction
+ * @param p_first_halfword - first halfword of the instruction
+ * @param p_second_halfword - following halfword, ignored for 16-bit
+ * instructions
+ * @return std::optional<branch> - the branch, std::nullopt for every other
+ * instruction, including returns through lr or pc.
+ */
+std::optional<branch>
+decode_branch(std::uint32_t p_address,
+              std::uint16_t p_first_halfword,
+              std::uint16_t p_second_halfword);
+
+/**
+ * @param p_first_halfword - first halfword of an instruction
+ * @param p_second_halfword - following halfword, ignored for 16-bit
+ * instructions
+ * @return true - if the instruction returns from the function: bx lr,
+ * mov pc, lr, pop with pc and ldr pc from sp
+ */
+bool
+is_return(std::uint16_t p_first_halfword, std::uint16_t p_second_halfword);
+
+/**
+ * @param p_first_halfword - first halfword of an instruction
+ * @param p_second_halfword - following halfword, ignored for 16-bit
+ * instructions
+ * @return true - if the instruction is tbb or tbh, a jump through the table
+ * of offsets that follows it
+ */
+bool
+is_table_branch(std::uint16_t p_first_halfword,
+                std::uint16_t p_second_halfword);
+
+/**
+ * @param p_first_halfword - first halfword of an instruction
+ * @return std::uint32_t - instructions made conditional by an IT instruction,
+ * 0 for every other instruction
+ */
+std::uint32_t
+it_block_length(std::uint16_t p_first_halfword);
+
+/**
+ * Call p_callback with every branch in p_code, a run of Thumb instructions
+ * without embedded data.
+ *
+ * @param p_code - little endian instruction stream
+ * @param p_address - address of p_code[0]
+ * @param p_callback - invocable with `const branch&`
+ */
+template<typename Callback>
+void
+for_each_branch(std::span<const std::uint8_t> p_code,
+                std::uint32_t p_address,
+                Callback&& p_callback)
+{
+  auto halfword_at = [&p_code](std::size_t p_offset) -> std::uint16_t {
+    return p_code[p_offset] | (p_code[p_offset + 1] << 8);
+  };
+
+  std::size_t offset = 0;
+  while (offset + 2 <= p_code.size()) {
+    const auto first = halfword_at(offset);
+    const bool wide = is_wide_instruction(first);
+    if (wide && offset + 4 > p_code.size()) {
+      break;
+    }
+    const auto second = wide ? halfword_at(offset + 2) : std::uint16_t{ 0 };
+
+    if (auto found = decode_branch(p_address + offset, first, second)) {
+      p_callback(*found);
+    }
+    offset += wide ? 4 : 2;
+  }
+}
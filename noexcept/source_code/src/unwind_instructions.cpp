@@ -0,0 +1,267 @@
+#include "unwind_instructions.hpp"
+
+#include <cstdint>
+
+#include <bit>
+
+namespace {
+constexpr std::uint8_t finish = 0xB0;
+
+/// Unwind instructions are packed most significant byte first into words
+class instruction_stream
+{
+public:
+  instruction_stream(const std::uint32_t* p_words,
+                     std::uint32_t p_position,
+                     std::uint32_t p_length)
+    : m_words(p_words)
+    , m_position(p_position)
+    , m_end(p_length)
+  {
+  }
+
+  bool
+  next(std::uint8_t& p_byte)
+  {
+    if (m_position >= m_end) {
+      return false;
+    }
+    const auto word = m_words[m_position / 4];
+    p_byte = static_cast<std::uint8_t>(word >> (24 - 8 * (m_position % 4)));
+    m_position++;
+    return true;
+  }
+
+private:
+  const std::uint32_t* m_words;
+  std::uint32_t m_position;
+  std::uint32_t m_end;
+};
+
+/// Account for popping p_count registers of p_size bytes
+void
+pop_extension(unwind_info& p_info, std::uint32_t p_count, std::uint32_t p_size)
+{
+  p_info.extension_registers += p_count;
+  p_info.vsp_adjust += static_cast<std::int32_t>(p_count * p_size);
+}
+
+void
+pop_core(unwind_info& p_info, std::uint16_t p_mask)
+{
+  p_info.core_registers |= p_mask;
+  p_info.vsp_adjust += 4 * std::popcount(p_mask);
+}
+
+/**
+ * Decode the instructions of p_stream into p_info
+ *
+ * @return true - if every instruction was understood
+ */
+bool
+decode(instruction_stream& p_stream, unwind_info& p_info)
+{
+  std::uint8_t opcode = 0;
+  while (p_stream.next(opcode) && opcode != finish) {
+    std::uint8_t operand = 0;
+    std::uint32_t length = 1;
+    p_info.opcode_count++;
+
+    if ((opcode & 0xC0) == 0x00) {
+      // 00xxxxxx: vsp = vsp + (xxxxxx << 2) + 4
+      p_info.vsp_adjust += ((opcode & 0x3F) << 2) + 4;
+    } else if ((opcode & 0xC0) == 0x40) {
+      // 01xxxxxx: vsp = vsp - (xxxxxx << 2) - 4
+      p_info.vsp_adjust -= ((opcode & 0x3F) << 2) + 4;
+    } else if ((opcode & 0xF0) == 0x80) {
+      // 1000iiii iiiiiiii: pop r4-r15 under mask, all zeros refuses to unwind
+      if (not p_stream.next(operand)) {
+        return false;
+      }
+      length = 2;
+      const auto mask = static_cast<std::uint16_t>(
+        (((opcode & 0x0F) << 8) | operand) << 4);
+      if (mask == 0) {
+        p_info.refuses_to_unwind = true;
+      }
+      pop_core(p_info, mask);
+    } else if ((opcode & 0xF0) == 0x90) {
+      // 1001nnnn: vsp = r[nnnn], 13 and 15 are reserved
+      const auto source = opcode & 0x0F;
+      if (source == 13 || source == 15) {
+        return false;
+      }
+      p_info.vsp_from_register = true;
+      p_info.vsp_adjust = 0;
+    } else if ((opcode & 0xF0) == 0xA0) {
+      // 1010Lnnn: pop r4-r[4+nnn], and r14 if L is set
+      const auto count = (opcode & 0x07) + 1;
+      auto mask = static_cast<std::uint16_t>(((1 << count) - 1) << 4);
+      if (opcode & 0x08) {
+        mask |= 1 << 14;
+      }
+      pop_core(p_info, mask);
+    } else if (opcode == 0xB1) {
+      // 10110001 0000iiii: pop r0-r3 under mask
+      if (not p_stream.next(operand)) {
+        return false;
+      }
+      length = 2;
+      if (operand == 0 || (operand & 0xF0)) {
+        return false;
+      }
+      pop_core(p_info, operand);
+    } else if (opcode == 0xB2) {
+      // 10110010 uleb128: vsp = vsp + 0x204 + (uleb128 << 2)
+      std::uint32_t value = 0;
+      std::uint32_t shift = 0;
+      do {
+        if (not p_stream.next(operand) || shift > 28) {
+          return false;
+        }
+        length++;
+        value |= (operand & 0x7F) << shift;
+        shift += 7;
+      } while (operand & 0x80);
+      p_info.vsp_adjust += 0x204 + static_cast<std::int32_t>(value << 2);
+    } else if (opcode == 0xB3 || opcode == 0xC8 || opcode == 0xC9) {
+      // 10110011 sssscccc: pop D[ssss]-D[ssss+cccc] saved by FSTMFDX
+      // 11001000 sssscccc: pop D[16+ssss]-D[16+ssss+cccc] saved by VPUSH
+      // 11001001 sssscccc: pop D[ssss]-D[ssss+cccc] saved by VPUSH
+      if (not p_stream.next(operand)) {
+        return false;
+      }
+      length = 2;
+      pop_extension(p_info, (operand & 0x0F) + 1, 8);
+      if (opcode == 0xB3) {
+        p_info.vsp_adjust += 4; // FSTMFDX format word
+      }
+    } else if ((opcode & 0xF8) == 0xB8) {
+      // 10111nnn: pop D[8]-D[8+nnn] saved by FSTMFDX
+      pop_extension(p_info, (opcode & 0x07) + 1, 8);
+      p_info.vsp_adjust += 4;
+    } else if ((opcode & 0xF8) == 0xD0) {
+      // 11010nnn: pop D[8]-D[8+nnn] saved by VPUSH
+      pop_extension(p_info, (opcode & 0x07) + 1, 8);
+    } else if ((opcode & 0xF8) == 0xC0 && opcode != 0xC6 && opcode != 0xC7) {
+      // 11000nnn: pop iWMMXt wR[10]-wR[10+nnn]
+      pop_extension(p_info, (opcode & 0x07) + 1, 8);
+    } else if (opcode == 0xC6) {
+      // 11000110 sssscccc: pop iWMMXt wR[ssss]-wR[ssss+cccc]
+      if (not p_stream.next(operand)) {
+        return false;
+      }
+      length = 2;
+      pop_extension(p_info, (operand & 0x0F) + 1, 8);
+    } else if (opcode == 0xC7) {
+      // 11000111 0000iiii: pop iWMMXt wCGR registers under mask
+      if (not p_stream.next(operand)) {
+        return false;
+      }
+      length = 2;
+      if (operand == 0 || (operand & 0xF0)) {
+        return false;
+      }
+      pop_extension(p_info, std::popcount(operand), 4);
+    } else {
+      // 10011101, 10011111, 101101nn and the remaining 11xxxxxx are spare
+      return false;
+    }
+
+    p_info.opcode_bytes += length;
+  }
+
+  return true;
+}
+} // namespace
+
+unwind_info
+decode_unwind_instructions(const exception_info& p_info)
+{
+  constexpr std::uint32_t word_size = sizeof(std::uint32_t);
+
+  unwind_info info{};
+  if (p_info.index_entry == nullptr || p_info.rank == metadata_rank::no_entry) {
+    return info;
+  }
+
+  if (p_info.rank == metadata_rank::inlined_noexcept) {
+    info.model = unwind_model::cantunwind;
+    info.refuses_to_unwind = true;
+    info.valid = true;
+    return info;
+  }
+
+  const std::uint32_t* words = nullptr;
+  if (p_info.rank == metadata_rank::inlined_personality) {
+    info.model = unwind_model::compact_inline;
+    words = &p_info.index_entry->content;
+  } else {
+    words = static_cast<const std::uint32_t*>(
+      to_absolute_address(&p_info.index_entry->content));
+    info.model = p_info.rank == metadata_rank::table_personality
+                   ? unwind_model::compact_table
+                   : unwind_model::generic;
+  }
+
+  // Compact model: 1000pppp followed by the instructions. Personality routine
+  // 0 holds 3 bytes of instructions, routines 1 and 2 hold 2 bytes and the
+  // number of additional words in the second byte.
+  //
+  // Generic model: the personality routine's prel31 offset, then the number of
+  // additional words in the first byte followed by 3 bytes of instructions.
+  std::uint32_t additional_words = 0;
+  std::uint32_t first_instruction = 1;
+  if (info.model == unwind_model::generic) {
+    words++;
+    additional_words = words[0] >> 24;
+  } else {
+    info.personality_index = (words[0] >> 24) & 0x0F;
+    if (info.personality_index > 2) {
+      return info;
+    }
+    if (info.personality_index != 0) {
+      additional_words = (words[0] >> 16) & 0xFF;
+      first_instruction = 2;
+    }
+  }
+
+  info.words = additional_words + 1;
+  if (info.model == unwind_model::generic) {
+    info.words++; // personality routine
+  }
+  if (info.model != unwind_model::compact_inline) {
+    info.data_end =
+      reinterpret_cast<const std::uint8_t*>(words + additional_words + 1);
+  }
+
+  instruction_stream stream(
+    words, first_instruction, (additional_words + 1) * word_size);
+  info.valid = decode(stream, info);
+  return info;
+}
+
+std::uint32_t
+core_register_count(const unwind_info& p_info)
+{
+  return std::popcount(p_info.core_registers);
+}
+
+const char*
+to_string(unwind_model p_model)
+{
+  switch (p_model) {
+    case unwind_model::none:
+      return "none";
+    case unwind_model::cantunwind:
+      return "cantunwind";
+    case unwind_model::compact_inline:
+      return "compact_inline";
+    case unwind_model::compact_table:
+      return "compact_table";
+    case unwind_model::generic:
+      return "generic";
+    default:
+      return "unknown";
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "exception_metadata.hpp"
+
+// Decoder for the ARM EHABI unwind instructions (section 10.3 of the EHABI),
+// shared by the on-target analysis and the host tools. Nothing is executed,
+// the decoder only accounts for what the unwinder would do for one frame.
+
+enum class unwind_model : std::uint8_t
+{
+  /// The function has no index entry
+  none,
+  /// EXIDX_CANTUNWIND
+  cantunwind,
+  /// ARM compact model inlined in the index entry
+  compact_inline,
+  /// ARM compact model in the exception table
+  compact_table,
+  /// Generic model, a personality routine followed by its data
+  generic,
+};
+
+struct unwind_info
+{
+  unwind_model model = unwind_model::none;
+  /// Personality routine index of the compact model, 0 to 2
+  std::uint8_t personality_index = 0;
+  /// True if every instruction was understood up to finish or the end of data
+  bool valid = false;
+  /// True for EXIDX_CANTUNWIND and for the refuse to unwind instruction
+  bool refuses_to_unwind = false;
+  /// True if an instruction loads vsp from a register, vsp_adjust is relative
+  /// to that register afterwards
+  bool vsp_from_register = false;
+  /// Words of the index or table entry holding the header and instructions
+  std::uint32_t words = 0;
+  /// Instructions before finish
+  std::uint32_t opcode_count = 0;
+  /// Bytes of those instructions
+  std::uint32_t opcode_bytes = 0;
+  /// Bit n set if r[n] is restored
+  std::uint16_t core_registers = 0;
+  /// VFP and iWMMXt registers restored
+  std::uint32_t extension_registers = 0;
+  /// Net change of the virtual stack pointer, including every pop
+  std::int32_t vsp_adjust = 0;
+  /// First byte after the instructions in the exception table, where the
+  /// LSDA of the generic model or the descriptors of the compact model start.
+  /// nullptr for entries without table data.
+  const std::uint8_t* data_end = nullptr;
+};
+
+/**
+ * Decode the unwind instructions of the index entry described by p_info
+ *
+ * @param p_info - classified index entry
+ * @return unwind_info - the instructions' costs and where they end
+ */
+unwind_info
+decode_unwind_instructions(const exception_info& p_info);
+
+/**
+ * @return std::uint32_t - number of core registers restored by p_info
+ */
+std::uint32_t
+core_register_count(const unwind_info& p_info);
+
+const char*
+to_string(unwind_model p_model);
@@ -0,0 +1,155 @@
+#include "unwind_plan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <span>
+
+#include <unwind.h>
+
+#include "atomic_update.hpp"
+#include "personality_actions.hpp"
+
+#if not defined(NOEXCEPT_UNWIND_PLAN_CAPACITY)
+#define NOEXCEPT_UNWIND_PLAN_CAPACITY 128
+#endif
+
+namespace unwind_plan {
+constexpr std::size_t capacity = NOEXCEPT_UNWIND_PLAN_CAPACITY;
+
+// Outside of the anonymous namespace, the table needs external linkage
+struct plan_table
+{
+  table_header header;
+  std::array<entry, capacity> entries;
+};
+} // namespace unwind_plan
+
+extern "C"
+{
+  _Unwind_Reason_Code __real___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context);
+
+  /**
+   * Written by tools/unwind_planner into the image after the link. It stays in
+   * flash with the rest of .rodata, extern keeps the symbol the planner looks
+   * for global.
+   */
+  [[gnu::section(".rodata.unwind_plan"), gnu::used]] extern constinit const
+    unwind_plan::plan_table unwind_plan_table{
+      .header = { .magic = unwind_plan::table_magic,
+                  .capacity = unwind_plan::capacity,
+                  .count = 0 },
+      .entries = {},
+    };
+}
+
+namespace unwind_plan {
+namespace {
+std::atomic<std::uint32_t> hit_count{ 0 };
+std::atomic<std::uint32_t> miss_count{ 0 };
+std::atomic<std::uint32_t> bypass_count{ 0 };
+
+void
+increment(std::atomic<std::uint32_t>& p_counter) noexcept
+{
+  atomic_update(p_counter, [](std::uint32_t p_count) { return p_count + 1; });
+}
+
+const plan_table&
+table() noexcept
+{
+  // The compiler sees an empty table, hide its contents from the optimizer so
+  // the lookups read what the planner wrote
+  const plan_table* planned = &unwind_plan_table;
+  asm("" : "+r"(planned));
+  return *planned;
+}
+
+std::span<const entry>
+planned_entries() noexcept
+{
+  const auto& planned = table();
+  return std::span(planned.entries)
+    .first(std::min<std::size_t>(planned.header.count, capacity));
+}
+
+const entry*
+find(std::uint32_t p_return_address, std::uint32_t p_type) noexcept
+{
+  const auto entries = planned_entries();
+  auto match = std::ranges::lower_bound(
+    entries, p_return_address, {}, &entry::return_address);
+  for (; match != entries.end() && match->return_address == p_return_address;
+       match++) {
+    if (match->type == 0 || match->type == p_type) {
+      return &*match;
+    }
+  }
+  return nullptr;
+}
+} // namespace
+
+std::uint32_t
+planned_frames() noexcept
+{
+  return planned_entries().size();
+}
+
+statistics
+read_statistics() noexcept
+{
+  return {
+    .hits = hit_count.load(std::memory_order_relaxed),
+    .misses = miss_count.load(std::memory_order_relaxed),
+    .bypassed = bypass_count.load(std::memory_order_relaxed),
+  };
+}
+} // namespace unwind_plan
+
+extern "C"
+{
+  _Unwind_Reason_Code __wrap___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context)
+  {
+    using namespace unwind_plan;
+    using namespace personality_actions;
+
+    const auto phase = p_state & _US_ACTION_MASK;
+    const auto type = exception_type(p_exception);
+    const bool plannable =
+      not(p_state & _US_FORCE_UNWIND) && type != 0 &&
+      not is_handler_frame(p_state, p_exception, p_context) &&
+      (phase == _US_VIRTUAL_UNWIND_FRAME || phase == _US_UNWIND_FRAME_STARTING);
+
+    if (not plannable) {
+      increment(bypass_count);
+      return __real___gxx_personality_v0(p_state, p_exception, p_context);
+    }
+
+    const auto return_address =
+      _Unwind_GetGR(p_context, program_counter_register) & ~1U;
+    const auto* planned = find(return_address, type);
+    if (planned == nullptr) {
+      increment(miss_count);
+      return __real___gxx_personality_v0(p_state, p_exception, p_context);
+    }
+
+    increment(hit_count);
+    _Unwind_SetGR(p_context,
+                  unwind_pointer_register,
+                  reinterpret_cast<std::uintptr_t>(p_exception));
+    // The search phase only looks for a handler, cleanups run in the second
+    if (phase == _US_UNWIND_FRAME_STARTING && planned->landing_pad != 0) {
+      return install_cleanup(p_exception, p_context, planned->landing_pad);
+    }
+    return continue_unwinding(p_exception, p_context);
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+// Answers __gxx_personality_v0 from a table computed after the link, installed
+// in front of it with -Wl,--wrap=__gxx_personality_v0 when NOEXCEPT_UNWIND_PLAN
+// is on.
+//
+// tools/unwind_planner follows every direct throw in an image up the call
+// graph and decides, from the LSDA call site and action tables, what each
+// frame on the way to the handler does with the exception. Those decisions are
+// written into unwind_plan_table of a copy of the image. At runtime a frame
+// whose (return address, exception type) is in the table is unwound or has
+// its cleanup landing pad installed without decoding its LSDA.
+//
+// Frames missing from the table, reached through an indirect call or a throw
+// the planner could not type, fall back to the real personality routine, as do
+// handler frames, forced unwinds and foreign exceptions. The unwinder still
+// restores every frame from its exception index entry.
+
+namespace unwind_plan {
+/// unwind_plan_table::magic, "NXUP"
+inline constexpr std::uint32_t table_magic = 0x5055584e;
+
+/**
+ * Plan for one frame, sorted by return_address and then type
+ */
+struct entry
+{
+  /// Return address into the frame, Thumb bit cleared
+  std::uint32_t return_address;
+  /// Address of the thrown std::type_info, 0 for every type
+  std::uint32_t type;
+  /// Cleanup landing pad with the Thumb bit set, 0 to unwind through the frame
+  std::uint32_t landing_pad;
+};
+
+/**
+ * Header of unwind_plan_table, entries follow it. tools/unwind_planner finds
+ * the table by its symbol and checks magic and capacity before writing it.
+ */
+struct table_header
+{
+  std::uint32_t magic;
+  std::uint32_t capacity;
+  std::uint32_t count;
+};
+
+struct statistics
+{
+  /// Frames answered from the table
+  std::uint32_t hits = 0;
+  /// Frames not in the table, handed to the real personality routine
+  std::uint32_t misses = 0;
+  /// Calls that could not use the table, see the file comment
+  std::uint32_t bypassed = 0;
+};
+
+/**
+ * @return std::uint32_t - entries written into the table by the planner, 0 for
+ * an image that was not planned
+ */
+std::uint32_t
+planned_frames() noexcept;
+
+/**
+ * @return statistics - snapshot of the counters
+ */
+statistics
+read_statistics() noexcept;
+} // namespace unwind_plan
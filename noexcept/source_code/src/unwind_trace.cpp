@@ -0,0 +1,206 @@
+#include "unwind_trace.hpp"
+
+#include <cstdint>
+
+#include <unwind.h>
+
+#include "cycle_counter.hpp"
+
+extern "C"
+{
+  [[noreturn]] void __real___cxa_throw(void* p_object, // NOLINT
+                                       void* p_type,
+                                       void (*p_destructor)(void*));
+  _Unwind_Reason_Code __real__Unwind_RaiseException( // NOLINT
+    _Unwind_Control_Block* p_exception);
+  _Unwind_Reason_Code __real___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context);
+  void* __real___cxa_begin_catch(void* p_exception) noexcept; // NOLINT
+  void __real___cxa_end_catch(); // NOLINT
+}
+
+namespace unwind_trace {
+namespace {
+/// The throw being followed, between __cxa_throw and __cxa_begin_catch
+struct in_flight
+{
+  throw_record record{};
+  std::uint32_t throw_start = 0;
+  std::uint32_t raise_start = 0;
+  std::uint32_t unwind_start = 0;
+  /// Last return from the personality routine, a landing pad starts there
+  std::uint32_t last_return = 0;
+  bool active = false;
+  bool unwinding = false;
+};
+
+in_flight current{};
+throw_record last{};
+std::uint32_t catch_time = 0;
+std::uint32_t throws = 0;
+/// last.handler is waiting for __cxa_end_catch
+bool handler_open = false;
+
+void
+finish_throw(std::uint32_t p_now)
+{
+  auto& record = current.record;
+  if (current.unwinding) {
+    record.unwind = cycle_counter::elapsed(current.unwind_start, p_now);
+    record.catch_entry = cycle_counter::elapsed(current.last_return, p_now);
+  } else {
+    // The search found no handler, __cxa_throw is about to terminate
+    record.search = cycle_counter::elapsed(current.raise_start, p_now);
+  }
+  last = record;
+  catch_time = p_now;
+  handler_open = true;
+  current.active = false;
+}
+} // namespace
+
+throw_record
+last_throw() noexcept
+{
+  return last;
+}
+
+std::uint32_t
+throw_count() noexcept
+{
+  return throws;
+}
+
+void
+clear() noexcept
+{
+  last = {};
+  throws = 0;
+  handler_open = false;
+}
+} // namespace unwind_trace
+
+extern "C"
+{
+  [[noreturn]] void __wrap___cxa_throw(void* p_object, // NOLINT
+                                       void* p_type,
+                                       void (*p_destructor)(void*))
+  {
+    using namespace unwind_trace;
+    current = { .throw_start = cycle_counter::now(), .active = true };
+    throws++;
+    __real___cxa_throw(p_object, p_type, p_destructor);
+  }
+
+  _Unwind_Reason_Code __wrap__Unwind_RaiseException( // NOLINT
+    _Unwind_Control_Block* p_exception)
+  {
+    using namespace unwind_trace;
+    if (current.active) {
+      current.raise_start = cycle_counter::now();
+      current.record.throw_setup =
+        cycle_counter::elapsed(current.throw_start, current.raise_start);
+    }
+    return __real__Unwind_RaiseException(p_exception);
+  }
+
+  _Unwind_Reason_Code __wrap___gxx_personality_v0( // NOLINT
+    _Unwind_State p_state,
+    _Unwind_Control_Block* p_exception,
+    _Unwind_Context* p_context)
+  {
+    using namespace unwind_trace;
+    if (not current.active) {
+      return __real___gxx_personality_v0(p_state, p_exception, p_context);
+    }
+
+    const auto start = cycle_counter::now();
+    auto& record = current.record;
+    switch (p_state & _US_ACTION_MASK) {
+      case _US_VIRTUAL_UNWIND_FRAME:
+        record.search_frames++;
+        break;
+      case _US_UNWIND_FRAME_STARTING:
+        if (not current.unwinding) {
+          current.unwinding = true;
+          current.unwind_start = start;
+          record.search = cycle_counter::elapsed(current.raise_start, start);
+        }
+        record.unwind_frames++;
+        break;
+      default:
+        break;
+    }
+
+    const auto result =
+      __real___gxx_personality_v0(p_state, p_exception, p_context);
+    const auto end = cycle_counter::now();
+    record.personality_calls++;
+    record.personality += cycle_counter::elapsed(start, end);
+    current.last_return = end;
+    return result;
+  }
+
+  /// Called by __wrap___cxa_end_cleanup at the end of every cleanup pad
+  void unwind_trace_end_cleanup() noexcept // NOLINT
+  {
+    using namespace unwind_trace;
+    if (current.active) {
+      current.record.cleanup_pads++;
+      current.record.cleanup +=
+        cycle_counter::elapsed(current.last_return, cycle_counter::now());
+    }
+  }
+
+  /// Called by __wrap__Unwind_Resume
+  void unwind_trace_resume() noexcept // NOLINT
+  {
+    using namespace unwind_trace;
+    if (current.active) {
+      current.record.resumes++;
+    }
+  }
+
+  // Cleanup pads end by calling __cxa_end_cleanup, which must preserve r1-r4
+  // for the code it returns to. It never returns, lr is free.
+  [[gnu::naked]] void __wrap___cxa_end_cleanup() // NOLINT
+  {
+    asm("push {r1, r2, r3, r4}\n"
+        "bl unwind_trace_end_cleanup\n"
+        "pop {r1, r2, r3, r4}\n"
+        "bl __real___cxa_end_cleanup\n");
+  }
+
+  // _Unwind_Resume continues unwinding from the registers it is called with,
+  // so r4-r11 and sp must reach it unchanged. It never returns.
+  [[gnu::naked]] void __wrap__Unwind_Resume( // NOLINT
+    [[maybe_unused]] _Unwind_Control_Block* p_exception)
+  {
+    asm("push {r0, r1}\n"
+        "bl unwind_trace_resume\n"
+        "pop {r0, r1}\n"
+        "bl __real__Unwind_Resume\n");
+  }
+
+  void* __wrap___cxa_begin_catch(void* p_exception) noexcept // NOLINT
+  {
+    using namespace unwind_trace;
+    auto* object = __real___cxa_begin_catch(p_exception);
+    if (current.active) {
+      finish_throw(cycle_counter::now());
+    }
+    return object;
+  }
+
+  void __wrap___cxa_end_catch() // NOLINT
+  {
+    using namespace unwind_trace;
+    if (handler_open) {
+      last.handler = cycle_counter::elapsed(catch_time, cycle_counter::now());
+      handler_open = false;
+    }
+    __real___cxa_end_catch();
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+// Phase by phase timing of every throw, installed with -Wl,--wrap in front of
+// __cxa_throw, _Unwind_RaiseException, __gxx_personality_v0, _Unwind_Resume,
+// __cxa_end_cleanup, __cxa_begin_catch and __cxa_end_catch when
+// NOEXCEPT_UNWIND_TRACE is on.
+//
+// A throw is followed from __cxa_throw until its handler calls
+// __cxa_begin_catch, or until __cxa_throw gives up and calls
+// __cxa_begin_catch itself before std::terminate. The hooks read cycle_counter,
+// which must be enabled, and their own cost is part of the durations they
+// report. Rethrows are not followed.
+
+namespace unwind_trace {
+struct throw_record
+{
+  /// Frames the personality routine searched for a handler (phase 1)
+  std::uint32_t search_frames = 0;
+  /// Frames unwound on the way to the handler (phase 2)
+  std::uint32_t unwind_frames = 0;
+  /// Calls to the personality routine in both phases
+  std::uint32_t personality_calls = 0;
+  /// Cleanup landing pads run, each ends in __cxa_end_cleanup
+  std::uint32_t cleanup_pads = 0;
+  /// Calls to _Unwind_Resume, one after every cleanup pad
+  std::uint32_t resumes = 0;
+
+  // Durations in cycle_counter counts
+
+  /// __cxa_throw up to _Unwind_RaiseException
+  std::uint32_t throw_setup = 0;
+  /// Search phase, _Unwind_RaiseException up to the first frame unwound
+  std::uint32_t search = 0;
+  /// Cleanup phase, the first frame unwound up to __cxa_begin_catch
+  std::uint32_t unwind = 0;
+  /// Spent inside the personality routine, in both phases
+  std::uint32_t personality = 0;
+  /// Spent in cleanup landing pads, destructors included
+  std::uint32_t cleanup = 0;
+  /// The personality routine installing the handler up to the return of
+  /// __cxa_begin_catch
+  std::uint32_t catch_entry = 0;
+  /// __cxa_begin_catch up to __cxa_end_catch, the body of the handler
+  std::uint32_t handler = 0;
+};
+
+/**
+ * @return throw_record - the most recent throw that reached a handler, or
+ * std::terminate. handler is filled in once the handler ends.
+ */
+throw_record
+last_throw() noexcept;
+
+/**
+ * @return std::uint32_t - throws seen since start up or clear()
+ */
+std::uint32_t
+throw_count() noexcept;
+
+/**
+ * Forget the last throw and reset the throw count
+ */
+void
+clear() noexcept;
+} // namespace unwind_trace
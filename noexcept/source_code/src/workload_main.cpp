@@ -0,0 +1,124 @@
+/**
+ * @file workload_main.cpp
+ * @brief Throw latency through a generated workload, see README.md
+ *
+ * Links in every function written by tools/generate_workload.py, so the
+ * exception index and table have the size of a program with that many
+ * functions, then times workload::throw_path_0() with bar() disarmed (happy
+ * path) and armed (throw path). The throw crosses workload::throw_depth frames
+ * before the catch block in this file.
+ *
+ * Results are written over semihosting to workload_latency.csv in the working
+ * directory of the emulator.
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <span>
+
+#include "cycle_counter.hpp"
+#include "exhibits.hpp"
+#include "external.hpp"
+#include "semihost.hpp"
+#include "workload.hpp"
+
+#if not defined(NOEXCEPT_CPU_HZ)
+#define NOEXCEPT_CPU_HZ 120000000
+#endif
+
+#if not defined(NOEXCEPT_ICOUNT_SHIFT)
+#define NOEXCEPT_ICOUNT_SHIFT 4
+#endif
+
+extern "C"
+{
+  void _exit(int rc) // NOLINT
+  {
+    semihost::exit(rc);
+  }
+}
+
+namespace {
+// side_effect counter nothing writes, keeps link_in_workload() reachable
+constexpr std::size_t never_set = 24;
+
+// Deterministic under QEMU, repeated for hardware runs like throw_benchmark
+constexpr int repetitions = 4;
+
+[[gnu::noinline]] std::uint32_t
+measure_once()
+{
+  volatile std::uint32_t end = 0;
+  const std::uint32_t start = cycle_counter::now();
+  try {
+    workload::throw_path_0();
+    end = cycle_counter::now();
+  } catch (...) {
+    end = cycle_counter::now();
+  }
+  return cycle_counter::elapsed(start, end);
+}
+
+std::uint32_t
+measure(throw_trigger p_trigger)
+{
+  std::uint32_t best = std::numeric_limits<std::uint32_t>::max();
+  for (int i = 0; i < repetitions; i++) {
+    arm_trigger(p_trigger);
+    best = std::min(best, measure_once());
+  }
+  disarm_triggers();
+  return best;
+}
+
+std::uint32_t
+to_report_units(std::uint32_t p_count, cycle_counter::source p_source)
+{
+  if (p_source == cycle_counter::source::dwt_cycles) {
+    return p_count;
+  }
+  return cycle_counter::to_instructions(
+    p_count, NOEXCEPT_CPU_HZ, NOEXCEPT_ICOUNT_SHIFT);
+}
+} // namespace
+
+int
+main()
+{
+  if (side_effect[never_set] != 0) {
+    workload::link_in_workload();
+  }
+
+  const auto source = cycle_counter::enable();
+  const char* unit =
+    (source == cycle_counter::source::dwt_cycles) ? "cycles" : "instructions";
+
+  const auto happy = to_report_units(measure(throw_trigger::none), source);
+  const auto thrown = to_report_units(measure(throw_trigger::bar), source);
+
+  semihost::file csv("workload_latency.csv");
+  if (not csv.is_open()) {
+    semihost::write("workload: unable to open workload_latency.csv\n");
+    return 1;
+  }
+
+  std::array<char, 128> row{};
+  const int length =
+    std::snprintf(row.data(),
+                  row.size(),
+                  "functions,throw_depth,happy_path,throw_path,unit\n"
+                  "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%s\n",
+                  workload::function_count,
+                  workload::throw_depth,
+                  happy,
+                  thrown,
+                  unit);
+  csv.write(std::span(row).first(std::min<std::size_t>(length, row.size())));
+
+  semihost::write("workload: wrote workload_latency.csv\n");
+  return 0;
+}
@@ -0,0 +1,321 @@
+#!/usr/bin/env python3
+"""Build app.elf over a matrix of toolchains and code generation flags.
+
+Every configuration is built with conan, analyzed with exception_analyzer and
+compared against a baseline configuration. For each configuration the output
+directory receives:
+
+    <name>/exception_rank.csv      csv/v1 schema
+    <name>/lsda_info.csv           csv/v1 schema
+    <name>/exception_sections.csv  size of the exception index and table
+    <name>/diff.csv                functions whose rank or LSDA size differ
+                                   from the baseline
+    <name>/footprint.csv           tools/footprint_report.py output, bytes of
+                                   the exception runtime, metadata and
+                                   application
+
+and summary.csv lists the totals of every configuration next to their
+difference from the baseline.
+
+Example, every GCC release at -Os and -O2, with and without LTO:
+
+    tools/build_matrix.py --gcc 11.3 12.3 13.2 --optimization Os O2 \\
+        --lto off on --analyzer build/tools/exception_analyzer
+"""
+
+import argparse
+import csv
+import itertools
+import subprocess
+import sys
+from collections import Counter
+from dataclasses import dataclass
+from pathlib import Path
+
+import footprint_report
+
+SOURCE_DIR = Path(__file__).resolve().parent.parent
+
+RANKS = [
+    "unknown",
+    "no_entry",
+    "inlined_noexcept",
+    "inlined_personality",
+    "table_personality",
+    "table_gcc_lsda",
+]
+
+
+@dataclass(frozen=True)
+class configuration:
+    gcc: str
+    arch: str
+    optimization: str
+    lto: bool
+    gc_sections: bool
+
+    @property
+    def name(self):
+        lto = "lto" if self.lto else "nolto"
+        gc = "gc" if self.gc_sections else "nogc"
+        return f"gcc{self.gcc}-{self.arch}-{self.optimization}-{lto}-{gc}"
+
+    def conan_arguments(self):
+        return [
+            "-pr", str(SOURCE_DIR / "baremetal.profile"),
+            "-pr", str(SOURCE_DIR / "profiles" / f"gcc-{self.gcc}"),
+            "-s", f"arch={self.arch}",
+            "-o", f"&:optimization={self.optimization}",
+            "-o", f"&:lto={self.lto}",
+            "-o", f"&:gc_sections={self.gc_sections}",
+        ]
+
+
+@dataclass
+class results:
+    """Analysis of a single configuration, keyed by function name"""
+    ranks: dict
+    lsda_sizes: dict
+    sections: dict
+    # (image, section, category) -> bytes, from footprint.csv
+    footprint: dict
+
+
+def on_off(value):
+    if value not in ("on", "off"):
+        raise argparse.ArgumentTypeError("expected on or off")
+    return value == "on"
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--gcc", nargs="+", default=["12.3"],
+                        help="GCC releases, each needs profiles/gcc-<version>")
+    parser.add_argument("--arch", nargs="+", default=["cortex-m3"],
+                        help="conan arch settings")
+    parser.add_argument("--optimization", nargs="+", default=["build_type"],
+                        choices=["build_type", "Os", "O2", "O3"])
+    parser.add_argument("--lto", nargs="+", type=on_off, default=[False],
+                        metavar="{on,off}")
+    parser.add_argument("--gc-sections", nargs="+", type=on_off,
+                        default=[False], metavar="{on,off}")
+    parser.add_argument("--baseline",
+                        help="configuration name or analysis directory to "
+                             "compare against, defaults to the first "
+                             "configuration")
+    parser.add_argument("--analyzer", type=Path, required=True,
+                        help="path to the exception_analyzer executable")
+    parser.add_argument("--build-dir", type=Path,
+                        default=SOURCE_DIR / "build" / "matrix")
+    parser.add_argument("--output", type=Path,
+                        default=SOURCE_DIR / "csv" / "matrix")
+    parser.add_argument("--skip-build", action="store_true",
+                        help="reuse the images from a previous run")
+    return parser.parse_args()
+
+
+def build(config, build_dir):
+    """Build app.elf for config and return its path, None if the build failed"""
+    command = ["conan", "build", str(SOURCE_DIR), "--build=missing",
+               "--output-folder", str(build_dir)] + config.conan_arguments()
+    print(f"==> {config.name}", flush=True)
+    if subprocess.run(command).returncode != 0:
+        return None
+    return find_image(build_dir)
+
+
+def find_image(build_dir):
+    images = sorted(build_dir.rglob("app.elf"))
+    return images[0] if images else None
+
+
+def read_csv(path):
+    with open(path, newline="") as file:
+        return list(csv.DictReader(file))
+
+
+def keyed_by_function(rows, column):
+    """Map function name to column. The full demangled name tells overloads
+    and clones apart, files without it fall back to function_name. Repeated
+    names, from static functions in different translation units, get the
+    occurrence number appended."""
+    occurrences = Counter()
+    result = {}
+    for row in rows:
+        name = row.get("demangled_name") or row["function_name"]
+        occurrences[name] += 1
+        if occurrences[name] > 1:
+            name = f"{name}#{occurrences[name]}"
+        result[name] = row[column]
+    return result
+
+
+def load_results(directory):
+    sections_path = directory / "exception_sections.csv"
+    sections = {}
+    if sections_path.exists():
+        sections = {row["section"]: int(row["size"])
+                    for row in read_csv(sections_path)}
+    footprint_path = directory / "footprint.csv"
+    footprint = {}
+    if footprint_path.exists():
+        footprint = {(row["image"], row["section"], row["category"]):
+                     int(row["bytes"]) for row in read_csv(footprint_path)}
+    lsda = read_csv(directory / "lsda_info.csv")
+    return results(
+        ranks=keyed_by_function(read_csv(directory / "exception_rank.csv"),
+                                "rank"),
+        lsda_sizes={name: int(size) for name, size in
+                    keyed_by_function(lsda, "total_size").items()},
+        sections=sections,
+        footprint=footprint)
+
+
+def write_footprint(config, image, output):
+    """Run tools/footprint_report.py on the map files the build wrote next to
+    image, if there are any"""
+    image_map = image.with_name(image.name + ".map")
+    baseline_map = image.with_name("baseline.elf.map")
+    if not image_map.exists() or not baseline_map.exists():
+        print(f"{config.name}: no map files, skipping the footprint",
+              file=sys.stderr)
+        return
+    footprint_report.report(image_map, baseline_map, output, config.name)
+
+
+def footprint_bytes(values, image, category, sections):
+    return sum(values.footprint.get((image, section, category), 0)
+               for section in sections)
+
+
+def write_diff(path, baseline, current):
+    """Write every function whose rank or LSDA size differs from baseline.
+    Functions missing from one side have an empty rank on that side."""
+    names = sorted(set(baseline.ranks) | set(current.ranks))
+    changed = 0
+    with open(path, "w", newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["function_name", "baseline_rank", "rank",
+                         "baseline_lsda_size", "lsda_size",
+                         "lsda_size_delta"])
+        for name in names:
+            before_rank = baseline.ranks.get(name, "")
+            after_rank = current.ranks.get(name, "")
+            before_size = baseline.lsda_sizes.get(name, 0)
+            after_size = current.lsda_sizes.get(name, 0)
+            if before_rank == after_rank and before_size == after_size:
+                continue
+            changed += 1
+            writer.writerow([name, before_rank, after_rank, before_size,
+                             after_size, after_size - before_size])
+    return changed
+
+
+def summary_row(config, analysis, baseline, changed):
+    def section(values, name):
+        return values.sections.get(name, 0)
+
+    row = {
+        "configuration": config.name,
+        "gcc": config.gcc,
+        "arch": config.arch,
+        "optimization": config.optimization,
+        "lto": config.lto,
+        "gc_sections": config.gc_sections,
+        "status": "ok",
+    }
+    if analysis is None:
+        row["status"] = "no_image"
+        return row
+
+    lsda_total = sum(analysis.lsda_sizes.values())
+    row.update({
+        "exidx": section(analysis, "exidx"),
+        "exidx_delta": section(analysis, "exidx") - section(baseline, "exidx"),
+        "extab": section(analysis, "extab"),
+        "extab_delta": section(analysis, "extab") - section(baseline, "extab"),
+        "lsda_total": lsda_total,
+        "lsda_total_delta": lsda_total - sum(baseline.lsda_sizes.values()),
+        "changed_functions": changed,
+    })
+    if analysis.footprint:
+        flash = footprint_report.FLASH_SECTIONS
+        ram = footprint_report.RAM_SECTIONS
+        runtime_flash = footprint_bytes(analysis, "image",
+                                        "exception_runtime", flash)
+        row.update({
+            "runtime_flash": runtime_flash,
+            "runtime_flash_delta": runtime_flash - footprint_bytes(
+                baseline, "image", "exception_runtime", flash),
+            "runtime_ram": footprint_bytes(analysis, "image",
+                                           "exception_runtime", ram),
+            "baseline_flash": sum(
+                footprint_bytes(analysis, "baseline", category, flash)
+                for category in footprint_report.CATEGORIES),
+        })
+    counts = Counter(analysis.ranks.values())
+    for rank in RANKS:
+        row[rank] = counts.get(rank, 0)
+    return row
+
+
+def main():
+    arguments = parse_arguments()
+    configurations = [
+        configuration(*values) for values in itertools.product(
+            arguments.gcc, arguments.arch, arguments.optimization,
+            arguments.lto, arguments.gc_sections)
+    ]
+
+    analyses = {}
+    for config in configurations:
+        build_dir = arguments.build_dir / config.name
+        if arguments.skip_build:
+            image = find_image(build_dir)
+        else:
+            image = build(config, build_dir)
+
+        if image is None:
+            print(f"{config.name}: no app.elf, skipping", file=sys.stderr)
+            analyses[config] = None
+            continue
+
+        output = arguments.output / config.name
+        subprocess.run([str(arguments.analyzer), str(image), str(output)],
+                       check=True)
+        write_footprint(config, image, output)
+        analyses[config] = load_results(output)
+
+    baseline_name = arguments.baseline or configurations[0].name
+    baseline_dir = arguments.output / baseline_name
+    if not baseline_dir.is_dir():
+        baseline_dir = Path(baseline_name)
+    baseline = load_results(baseline_dir)
+
+    fields = ["configuration", "gcc", "arch", "optimization", "lto",
+              "gc_sections", "status", "exidx", "exidx_delta", "extab",
+              "extab_delta", "lsda_total", "lsda_total_delta",
+              "changed_functions", "runtime_flash", "runtime_flash_delta",
+              "runtime_ram", "baseline_flash"] + RANKS
+    summary_path = arguments.output / "summary.csv"
+    with open(summary_path, "w", newline="") as file:
+        writer = csv.DictWriter(file, fieldnames=fields)
+        writer.writeheader()
+        for config in configurations:
+            analysis = analyses[config]
+            changed = 0
+            if analysis is not None:
+                changed = write_diff(
+                    arguments.output / config.name / "diff.csv", baseline,
+                    analysis)
+            writer.writerow(summary_row(config, analysis, baseline, changed))
+
+    print(f"baseline: {baseline_dir}")
+    print(f"summary: {summary_path}")
+    return 0 if all(analyses.values()) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
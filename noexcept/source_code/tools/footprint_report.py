@@ -0,0 +1,426 @@
+#!/usr/bin/env python3
+"""Attribute the bytes of a firmware image to the exception runtime.
+
+Reads the GNU ld map files of app.elf and of baseline.elf, the same startup
+code, picolibc and linker script built with -fno-exceptions, and assigns every
+input section of the .text, .rodata, .ARM.exidx, .ARM.extab, .data and .bss
+bytes to one of three categories:
+
+    exception_runtime  the unwinder of libgcc, the exception support of
+                       libsupc++, the replacements for parts of them in src/
+                       and the library members only they pulled into the link
+    metadata           the exception index and table, per function
+    application        everything else
+
+Alignment padding counts for the input section it follows, so the categories
+of an output section add up to its size. The output directory receives:
+
+    footprint.csv         per image, section and category: the bytes, with a
+                          row for every combination so configurations can be
+                          compared row by row
+    footprint_detail.csv  per image and input section: the section, category,
+                          object, size, padding and the symbols the map lists
+
+Example, with the map files the firmware build writes next to the images:
+
+    tools/footprint_report.py --image build/Release/app.elf.map \\
+        --baseline build/Release/baseline.elf.map --output csv/footprint
+"""
+
+import argparse
+import csv
+import re
+import sys
+from dataclasses import dataclass, field
+from pathlib import Path
+
+SOURCE_DIR = Path(__file__).resolve().parent.parent
+
+SECTIONS = [".text", ".rodata", ".ARM.exidx", ".ARM.extab", ".data", ".bss"]
+CATEGORIES = ["exception_runtime", "metadata", "application"]
+RAM_SECTIONS = [".data", ".bss"]
+# Loaded from flash, .data once for its initial values
+FLASH_SECTIONS = [".text", ".rodata", ".ARM.exidx", ".ARM.extab", ".data"]
+
+# Output sections of third_party/standard_arm.ld whose name does not say what
+# they hold
+OUTPUT_SECTIONS = {
+    ".init": ".text",
+    ".exception_index": ".ARM.exidx",
+    ".exception_table": ".ARM.extab",
+    ".preserve": ".bss",
+    ".tdata": ".data",
+    ".tbss": ".bss",
+    ".tbss_space": ".bss",
+    ".heap": ".bss",
+    ".stack": ".bss",
+}
+
+# Section name prefixes, longest first so .data.rel.ro is not .data
+INPUT_SECTIONS = [
+    (".ARM.exidx", ".ARM.exidx"),
+    (".ARM.extab", ".ARM.extab"),
+    (".gnu.linkonce.armextab", ".ARM.extab"),
+    (".gcc_except_table", ".ARM.extab"),
+    (".eh_frame", ".ARM.extab"),
+    (".data.rel.ro", ".rodata"),
+    (".rodata", ".rodata"),
+    (".srodata", ".rodata"),
+    (".rdata", ".rodata"),
+    (".got", ".rodata"),
+    (".preinit_array", ".rodata"),
+    (".init_array", ".rodata"),
+    (".fini_array", ".rodata"),
+    (".ctors", ".rodata"),
+    (".dtors", ".rodata"),
+    (".text", ".text"),
+    (".init", ".text"),
+    (".fini", ".text"),
+    (".glue_7", ".text"),
+    (".vfp11_veneer", ".text"),
+    (".v4_bx", ".text"),
+    (".tdata", ".data"),
+    (".sdata", ".data"),
+    (".data", ".data"),
+    (".tbss", ".bss"),
+    (".tcommon", ".bss"),
+    (".sbss", ".bss"),
+    (".bss", ".bss"),
+    ("COMMON", ".bss"),
+]
+
+# Archive members that are the exception runtime, by archive
+SUPCXX_RUNTIME = re.compile(
+    r"^(eh_|vterminate|cp-demangle|\w*type_info|tinfo)")
+RUNTIME_MEMBERS = {
+    "libgcc.a": re.compile(r"^(unwind|libunwind|pr-support)"),
+    "libgcc_eh.a": re.compile(r"."),
+    "libsupc++.a": SUPCXX_RUNTIME,
+    "libstdc++.a": SUPCXX_RUNTIME,
+}
+
+# Sources in src/ that replace or instrument parts of the exception runtime
+RUNTIME_SOURCES = {
+    "exception_pool",
+    "exidx_search",
+    "personality_actions",
+    "personality_cache",
+    "slim_personality",
+    "throw_telemetry",
+    "unwind_plan",
+    "unwind_trace",
+}
+
+ARCHIVE_MEMBER = re.compile(r"^(.*?)([^/\\]+\.a)\((.+)\)$")
+HEX = r"0x([0-9a-fA-F]+)"
+OUTPUT_LINE = re.compile(rf"^(\S+)\s+{HEX}\s+{HEX}")
+INPUT_LINE = re.compile(rf"^ (\S+)\s+{HEX}\s+{HEX}(?:\s+(.*))?$")
+PLACEMENT_LINE = re.compile(rf"^\s+{HEX}\s+{HEX}(?:\s+(.*))?$")
+SYMBOL_LINE = re.compile(rf"^\s+{HEX}\s+([A-Za-z_.$][^\s=]*)$")
+REFERENCE = re.compile(r"^(.*\S)\s+\((.*)\)$")
+
+
+@dataclass
+class input_section:
+    name: str
+    address: int
+    size: int
+    object: str
+    section: str
+    padding: int = 0
+    symbols: list = field(default_factory=list)
+    category: str = "application"
+
+
+@dataclass
+class link_map:
+    sections: list
+    # member -> object whose reference pulled it into the link
+    pulled_by: dict
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--image", type=Path, required=True,
+                        help="map file of the image with exceptions")
+    parser.add_argument("--baseline", type=Path, required=True,
+                        help="map file of the -fno-exceptions baseline")
+    parser.add_argument("--configuration", default="",
+                        help="name written to every row, to tell the "
+                             "reports of several builds apart")
+    parser.add_argument("--output", type=Path,
+                        default=SOURCE_DIR / "csv" / "footprint")
+    return parser.parse_args()
+
+
+def section_kind(name):
+    """One of SECTIONS for a section name, None if it is not loaded"""
+    if name in OUTPUT_SECTIONS:
+        return OUTPUT_SECTIONS[name]
+    for prefix, kind in INPUT_SECTIONS:
+        if name == prefix or name.startswith(prefix + "."):
+            return kind
+    return None
+
+
+def placed_kind(output_kind, name):
+    """Kind of input section name placed into an output section of
+    output_kind. RAM output sections decide on their own, anything that is not
+    code or exception metadata in flash is read-only data."""
+    if output_kind in RAM_SECTIONS:
+        return output_kind
+    kind = section_kind(name)
+    if kind is None or kind in RAM_SECTIONS:
+        return ".rodata" if name.startswith(".") else output_kind
+    return kind
+
+
+def parse_references(lines):
+    """The "Archive member included to satisfy reference" part of the map"""
+    pulled_by = {}
+    member = None
+    for line in lines:
+        if not line.strip():
+            if pulled_by or member:
+                break
+            continue
+        if not line[0].isspace():
+            parts = line.split(None, 1)
+            member = parts[0]
+            if len(parts) == 1:
+                continue
+            line = parts[1]
+        match = REFERENCE.match(line.strip())
+        if member and match:
+            pulled_by[member] = match.group(1)
+            member = None
+    return pulled_by
+
+
+def read_map(path):
+    lines = Path(path).read_text().splitlines()
+
+    pulled_by = {}
+    start = 0
+    for index, line in enumerate(lines):
+        if line.startswith("Archive member included"):
+            pulled_by = parse_references(lines[index + 1:])
+        if line.startswith("Linker script and memory map"):
+            start = index + 1
+            break
+
+    sections = []
+    output = None
+    pending = None
+    for line in lines[start:]:
+        if line and not line[0].isspace():
+            pending = None
+            match = OUTPUT_LINE.match(line)
+            name = match.group(1) if match else line.strip()
+            kind = section_kind(name) if name.startswith(".") else None
+            output = None
+            if kind is None:
+                continue
+            output = {"name": name, "kind": kind, "items": []}
+            if match:
+                output["address"] = int(match.group(2), 16)
+                output["size"] = int(match.group(3), 16)
+            sections.append(output)
+            continue
+        if output is None:
+            continue
+
+        if "address" not in output:
+            # The name did not fit, the address and size are on the next line
+            match = PLACEMENT_LINE.match(line)
+            if match:
+                output["address"] = int(match.group(1), 16)
+                output["size"] = int(match.group(2), 16)
+            continue
+
+        match = INPUT_LINE.match(line)
+        if match:
+            pending = None
+            name, address, size, rest = match.groups()
+            if name != "*fill*":
+                add_item(output, name, address, size, rest)
+            continue
+        if line.startswith(" ") and not line.startswith("  ") and \
+                len(line.split()) == 1 and not line.startswith(" *"):
+            pending = line.strip()
+            continue
+        match = PLACEMENT_LINE.match(line)
+        if match:
+            address, size, rest = match.groups()
+            # An input section whose name did not fit, or a data statement
+            # like LONG in .init
+            name = pending or (rest.split()[0] if rest else "*data*")
+            if pending is None:
+                rest = "linker script"
+            pending = None
+            add_item(output, name, address, size, rest)
+            continue
+        match = SYMBOL_LINE.match(line)
+        if match and output["items"]:
+            output["items"][-1].symbols.append(match.group(2))
+
+    return link_map(sections=sections, pulled_by=pulled_by)
+
+
+def add_item(output, name, address, size, rest):
+    size = int(size, 16)
+    if size == 0:
+        return
+    output["items"].append(input_section(
+        name=name,
+        address=int(address, 16),
+        size=size,
+        object=(rest or "").strip(),
+        section=placed_kind(output["kind"], name)))
+
+
+def flatten(link):
+    """Input sections of link, with the gaps between them as padding of the
+    one before. Bytes before the first input section are application
+    padding."""
+    result = []
+    for output in link.sections:
+        size = output.get("size", 0)
+        if size == 0:
+            continue
+        items = sorted(output["items"], key=lambda item: item.address)
+        end = output["address"] + size
+        first = items[0].address if items else end
+        if first > output["address"]:
+            result.append(input_section(
+                name="*padding*", address=output["address"],
+                size=0, padding=first - output["address"],
+                object="linker script", section=output["kind"]))
+        for item, following in zip(items, items[1:] + [None]):
+            next_address = following.address if following else end
+            item.padding = max(0, next_address - item.address - item.size)
+            result.append(item)
+    return result
+
+
+def archive_member(path):
+    """(archive name, member name) of an archive member path, else None"""
+    match = ARCHIVE_MEMBER.match(path)
+    if not match:
+        return None
+    return match.group(2), match.group(3)
+
+
+def is_runtime_object(path):
+    member = archive_member(path)
+    if member:
+        archive, name = member
+        members = RUNTIME_MEMBERS.get(archive)
+        return members is not None and members.search(name) is not None
+    stem = Path(path).name.split(".")[0]
+    return stem in RUNTIME_SOURCES
+
+
+def runtime_objects(link, baseline_objects):
+    """Objects of link that are the exception runtime. A library member counts
+    when something of the runtime pulled it into the link and the baseline
+    does not link it."""
+    objects = {item.object for item in flatten(link)}
+    runtime = {path for path in objects if is_runtime_object(path)}
+
+    def pulled_by_runtime(path, seen):
+        reference = link.pulled_by.get(path)
+        if reference is None or reference in seen:
+            return False
+        if reference in runtime:
+            return True
+        return pulled_by_runtime(reference, seen | {path})
+
+    for path in objects - runtime:
+        if archive_member(path) and path not in baseline_objects and \
+                pulled_by_runtime(path, {path}):
+            runtime.add(path)
+    return runtime
+
+
+def classify(link, baseline_objects):
+    runtime = runtime_objects(link, baseline_objects)
+    items = flatten(link)
+    for item in items:
+        if item.section in (".ARM.exidx", ".ARM.extab"):
+            item.category = "metadata"
+        elif item.object in runtime:
+            item.category = "exception_runtime"
+    return items
+
+
+def write_report(output, configuration, images):
+    """Write footprint.csv and footprint_detail.csv for images, a dict of
+    image name to classified input sections, and return the totals per
+    (image, section, category)"""
+    output.mkdir(parents=True, exist_ok=True)
+    totals = {}
+    for image, items in images.items():
+        for item in items:
+            key = (image, item.section, item.category)
+            totals[key] = totals.get(key, 0) + item.size + item.padding
+
+    with open(output / "footprint.csv", "w", newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["configuration", "image", "section", "category",
+                         "bytes"])
+        for image in images:
+            for section in SECTIONS:
+                for category in CATEGORIES:
+                    writer.writerow([configuration, image, section, category,
+                                     totals.get((image, section, category),
+                                                0)])
+
+    with open(output / "footprint_detail.csv", "w", newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["configuration", "image", "section", "category",
+                         "object", "input_section", "address", "size",
+                         "padding", "symbols"])
+        for image, items in images.items():
+            for item in items:
+                writer.writerow([configuration, image, item.section,
+                                 item.category, item.object, item.name,
+                                 f"0x{item.address:08x}", item.size,
+                                 item.padding, " ".join(item.symbols)])
+    return totals
+
+
+def report(image_map, baseline_map, output, configuration=""):
+    """Classify both map files and write the report into output"""
+    baseline = read_map(baseline_map)
+    image = read_map(image_map)
+    baseline_objects = {item.object for item in flatten(baseline)}
+    return write_report(output, configuration, {
+        "image": classify(image, set(baseline_objects)),
+        "baseline": classify(baseline, set()),
+    })
+
+
+def main():
+    arguments = parse_arguments()
+    totals = report(arguments.image, arguments.baseline, arguments.output,
+                    arguments.configuration)
+
+    def total(image, category, sections):
+        return sum(totals.get((image, section, category), 0)
+                   for section in sections)
+
+    print(f"exception runtime: "
+          f"{total('image', 'exception_runtime', FLASH_SECTIONS)} bytes of "
+          f"flash, {total('image', 'exception_runtime', RAM_SECTIONS)} bytes "
+          f"of RAM")
+    print(f"exception metadata: "
+          f"{total('image', 'metadata', FLASH_SECTIONS)} bytes")
+    print(f"see {arguments.output / 'footprint.csv'}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""Generate a synthetic workload in the style of the exhibits.
+
+The exhibits are a dozen hand written functions. This writes translation
+units with as many functions as asked for, so effects that only show up at
+scale, such as entry merging and the depth of the exception index search, can
+be measured. Every function looks like the ones in except_vs_noexcept.cpp and
+dtor_paths.cpp:
+
+    [[gnu::noinline]] void
+    f42() noexcept
+    {
+      dtor::non_trivial_dtor obj1;
+      obj1.noexcept_action();
+      try {
+        f97();
+        bar();
+      } catch (...) {
+        side_effect[9] = side_effect[9] + 1;
+      }
+    }
+
+Functions only call functions with a higher number, so the call graph is
+acyclic, and end with a call to noexcept_bar() or bar() from external.cpp.
+The output directory receives:
+
+    workload.hpp             function_count, throw_depth and the entry points
+    workload_<n>.cpp         the functions, --functions-per-unit in each
+    workload_throw_path.cpp  throw_path_0() to throw_path_<depth - 1>(), a chain
+                             of functions without handlers ending in bar()
+    workload_roots.cpp       link_in_workload(), calls every function that
+                             nothing else calls
+
+Example, 10000 functions, a third of them noexcept:
+
+    tools/generate_workload.py --functions 10000 --noexcept-ratio 0.33 \\
+        --output build/workload
+"""
+
+import argparse
+import random
+import sys
+from pathlib import Path
+
+# side_effect counter the catch blocks increment, not used by any trigger
+CATCH_COUNTER = 9
+
+
+def ratio(value):
+    value = float(value)
+    if not 0.0 <= value <= 1.0:
+        raise argparse.ArgumentTypeError("expected a value from 0 to 1")
+    return value
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--functions", type=int, required=True,
+                        help="number of generated functions")
+    parser.add_argument("--noexcept-ratio", type=ratio, default=0.5,
+                        help="fraction of functions declared noexcept")
+    parser.add_argument("--dtor-locals", type=int, default=1,
+                        help="non_trivial_dtor locals in every function")
+    parser.add_argument("--try-ratio", type=ratio, default=0.25,
+                        help="fraction of functions with try/catch blocks")
+    parser.add_argument("--try-depth", type=int, default=1,
+                        help="nesting of the try/catch blocks")
+    parser.add_argument("--fan-out", type=int, default=2,
+                        help="generated functions called by every function")
+    parser.add_argument("--throw-depth", type=int, default=16,
+                        help="frames between the handler and the throw of "
+                             "throw_path_0()")
+    parser.add_argument("--functions-per-unit", type=int, default=1000)
+    parser.add_argument("--seed", type=int, default=3313)
+    parser.add_argument("--output", type=Path, required=True)
+    arguments = parser.parse_args()
+    if arguments.functions < 1 or arguments.functions_per_unit < 1:
+        parser.error("--functions and --functions-per-unit must be positive")
+    if arguments.throw_depth < 1:
+        parser.error("--throw-depth must be positive")
+    return arguments
+
+
+class function:
+    def __init__(self, number):
+        self.number = number
+        self.name = f"f{number}"
+        self.is_noexcept = False
+        self.try_depth = 0
+        self.callees = []
+        self.throwing_leaf = False
+        self.has_caller = False
+
+
+def plan(arguments, generator):
+    functions = [function(number) for number in range(arguments.functions)]
+    for current in functions:
+        current.is_noexcept = generator.random() < arguments.noexcept_ratio
+        if generator.random() < arguments.try_ratio:
+            current.try_depth = arguments.try_depth
+        later = arguments.functions - current.number - 1
+        for _ in range(min(arguments.fan_out, later)):
+            callee = functions[generator.randint(current.number + 1,
+                                                 arguments.functions - 1)]
+            callee.has_caller = True
+            current.callees.append(callee)
+        current.throwing_leaf = generator.random() >= arguments.noexcept_ratio
+    return functions
+
+
+def signature(name, is_noexcept):
+    return f"{name}(){' noexcept' if is_noexcept else ''}"
+
+
+def body(calls, dtor_locals, try_depth):
+    """Lines of a function body, calls are wrapped in try_depth try blocks"""
+    lines = []
+    for local in range(1, dtor_locals + 1):
+        lines.append(f"dtor::non_trivial_dtor obj{local};")
+        lines.append(f"obj{local}.noexcept_action();")
+
+    inner = [f"{call}();" for call in calls]
+    for _ in range(try_depth):
+        inner = (["try {"] + ["  " + line for line in inner] +
+                 ["} catch (...) {",
+                  f"  side_effect[{CATCH_COUNTER}] = "
+                  f"side_effect[{CATCH_COUNTER}] + 1;",
+                  "}"])
+    return lines + inner
+
+
+def definition(name, is_noexcept, lines):
+    text = ["[[gnu::noinline]] void", signature(name, is_noexcept), "{"]
+    text += ["  " + line for line in lines]
+    text += ["}", ""]
+    return text
+
+
+def prologue(declarations):
+    text = ["// Generated by tools/generate_workload.py, do not edit",
+            '#include "dtor_paths.hpp"',
+            '#include "external.hpp"',
+            '#include "workload.hpp"',
+            "",
+            "namespace workload {"]
+    text += [f"void {signature(name, is_noexcept)};"
+             for name, is_noexcept in sorted(declarations)]
+    return text + [""]
+
+
+def write(path, lines):
+    path.write_text("\n".join(lines) + "\n")
+
+
+def write_unit(path, functions, arguments):
+    # Callees in the same unit are defined after their callers
+    declarations = set()
+    for current in functions:
+        declarations.update((callee.name, callee.is_noexcept)
+                            for callee in current.callees)
+
+    text = prologue(declarations)
+    for current in functions:
+        calls = [callee.name for callee in current.callees]
+        calls.append("bar" if current.throwing_leaf else "noexcept_bar")
+        text += definition(current.name, current.is_noexcept,
+                           body(calls, arguments.dtor_locals,
+                                current.try_depth))
+    write(path, text + ["} // namespace workload"])
+
+
+def write_throw_path(path, arguments):
+    # Deepest frame first, every function is defined before its caller
+    text = prologue(set())
+    for depth in reversed(range(arguments.throw_depth)):
+        next_call = (f"throw_path_{depth + 1}"
+                     if depth + 1 < arguments.throw_depth else "bar")
+        text += definition(f"throw_path_{depth}", False,
+                           body([next_call], arguments.dtor_locals, 0))
+    write(path, text + ["} // namespace workload"])
+
+
+def write_roots(path, functions):
+    roots = [current for current in functions if not current.has_caller]
+    text = prologue({(root.name, root.is_noexcept) for root in roots})
+    text += definition("link_in_workload", False,
+                       [f"{root.name}();" for root in roots])
+    write(path, text + ["} // namespace workload"])
+
+
+def write_header(path, arguments):
+    write(path, [
+        "#pragma once",
+        "",
+        "// Generated by tools/generate_workload.py, do not edit",
+        "",
+        "#include <cstdint>",
+        "",
+        "namespace workload {",
+        "inline constexpr std::uint32_t function_count = "
+        f"{arguments.functions};",
+        "inline constexpr std::uint32_t throw_depth = "
+        f"{arguments.throw_depth};",
+        "",
+        "/// Calls every generated function, directly or indirectly",
+        "[[gnu::noinline]] void",
+        "link_in_workload();",
+        "",
+        "/// Throws from bar() through throw_depth frames without a handler",
+        "[[gnu::noinline]] void",
+        "throw_path_0();",
+        "} // namespace workload",
+    ])
+
+
+def main():
+    arguments = parse_arguments()
+    generator = random.Random(arguments.seed)
+    functions = plan(arguments, generator)
+
+    arguments.output.mkdir(parents=True, exist_ok=True)
+    for stale in arguments.output.glob("workload_*.cpp"):
+        stale.unlink()
+
+    write_header(arguments.output / "workload.hpp", arguments)
+    per_unit = arguments.functions_per_unit
+    for unit, start in enumerate(range(0, len(functions), per_unit)):
+        write_unit(arguments.output / f"workload_{unit}.cpp",
+                   functions[start:start + per_unit], arguments)
+    write_throw_path(arguments.output / "workload_throw_path.cpp", arguments)
+    write_roots(arguments.output / "workload_roots.cpp", functions)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Compare the slim personality routine with the one in libsupc++.
+
+bench.elf is built twice in a configured build directory, with
+NOEXCEPT_UNWIND_TRACE on and NOEXCEPT_SLIM_PERSONALITY off and on, and run in
+QEMU. The output directory receives:
+
+    <variant>/bench.elf        the image that was run
+    <variant>/unwind_trace.csv its unwinder phase trace
+    personality_flash.csv      per variant: the flash bytes of the image and
+                               of __gxx_personality_v0, and the difference
+                               from the stock image
+    personality_frames.csv     per Exhibit 5 to 7 try/catch function and
+                               variant: the personality routine calls and
+                               the instructions each of them took
+
+The two images only differ in the personality routine, so the difference in
+flash is the footprint saved, including the helpers libsupc++ links with it.
+The build directory is configured back to its previous settings afterwards.
+
+Example, with a build directory configured by conan:
+
+    tools/personality_compare.py --build-dir build/Release
+"""
+
+import argparse
+import csv
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+SOURCE_DIR = Path(__file__).resolve().parent.parent
+
+VARIANTS = {"stock": "OFF", "slim": "ON"}
+OPTIONS = ["NOEXCEPT_UNWIND_TRACE", "NOEXCEPT_SLIM_PERSONALITY"]
+
+# The try/catch exhibits of the paper
+EXHIBITS = {"5", "6", "7"}
+
+SHF_ALLOC = 0x2
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", type=Path, required=True,
+                        help="build directory of the firmware, configured")
+    parser.add_argument("--results-dir", type=Path,
+                        default=SOURCE_DIR / "csv" / "qemu",
+                        help="NOEXCEPT_RESULTS_DIR of the build directory")
+    parser.add_argument("--output", type=Path,
+                        default=SOURCE_DIR / "csv" / "personality")
+    return parser.parse_args()
+
+
+def read_csv(path):
+    with open(path, newline="") as file:
+        return list(csv.DictReader(file))
+
+
+def cached_options(build_dir):
+    """Current values of OPTIONS in the CMake cache of build_dir"""
+    values = {option: "OFF" for option in OPTIONS}
+    pattern = re.compile(r"^(\w+):\w+=(.*)$")
+    with open(build_dir / "CMakeCache.txt") as cache:
+        for line in cache:
+            match = pattern.match(line.strip())
+            if match and match.group(1) in values:
+                values[match.group(1)] = match.group(2)
+    return values
+
+
+def configure(build_dir, values):
+    command = ["cmake", "-S", str(SOURCE_DIR), "-B", str(build_dir)]
+    command += [f"-D{option}={value}" for option, value in values.items()]
+    subprocess.run(command, check=True)
+
+
+def flash_bytes(image):
+    """Bytes of image loaded into flash and the size of
+    __gxx_personality_v0, from the ELF32 section and symbol tables"""
+    data = image.read_bytes()
+    section_offset, = struct.unpack_from("<I", data, 0x20)
+    entry_size, count = struct.unpack_from("<HH", data, 0x2E)
+    sections = [struct.unpack_from("<IIIIIIIIII", data,
+                                   section_offset + i * entry_size)
+                for i in range(count)]
+
+    loaded = 0
+    personality = 0
+    for _, kind, flags, _, offset, size, link, _, _, _ in sections:
+        if flags & SHF_ALLOC and kind != SHT_NOBITS:
+            loaded += size
+        if kind != SHT_SYMTAB:
+            continue
+        strings = sections[link]
+        for symbol in range(offset, offset + size, 16):
+            name, _, symbol_size = struct.unpack_from("<III", data, symbol)
+            start = strings[4] + name
+            end = data.index(b"\0", start)
+            if data[start:end] == b"__gxx_personality_v0":
+                personality = symbol_size
+    return loaded, personality
+
+
+def run_variant(arguments, variant, slim):
+    values = {"NOEXCEPT_UNWIND_TRACE": "ON",
+              "NOEXCEPT_SLIM_PERSONALITY": slim}
+    print(f"==> {variant}", flush=True)
+    configure(arguments.build_dir, values)
+
+    trace = arguments.results_dir / "unwind_trace.csv"
+    trace.unlink(missing_ok=True)
+    subprocess.run(["cmake", "--build", str(arguments.build_dir),
+                    "--target", "run_bench"], check=True)
+
+    output = arguments.output / variant
+    output.mkdir(parents=True, exist_ok=True)
+    images = sorted(arguments.build_dir.rglob("bench.elf"))
+    if not images or not trace.exists():
+        raise RuntimeError(f"{variant}: no bench.elf or unwind_trace.csv")
+    shutil.copy(images[0], output / "bench.elf")
+    shutil.copy(trace, output / "unwind_trace.csv")
+    return output
+
+
+def per_call(row):
+    calls = int(row["personality_calls"])
+    return f"{int(row['personality']) / calls:.1f}" if calls else ""
+
+
+def main():
+    arguments = parse_arguments()
+    arguments.output.mkdir(parents=True, exist_ok=True)
+    previous = cached_options(arguments.build_dir)
+
+    outputs = {}
+    try:
+        for variant, slim in VARIANTS.items():
+            outputs[variant] = run_variant(arguments, variant, slim)
+    finally:
+        configure(arguments.build_dir, previous)
+
+    flash = {variant: flash_bytes(output / "bench.elf")
+             for variant, output in outputs.items()}
+    with open(arguments.output / "personality_flash.csv", "w",
+              newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["variant", "flash_bytes", "personality_bytes",
+                         "flash_delta"])
+        for variant, (loaded, personality) in flash.items():
+            writer.writerow([variant, loaded, personality,
+                             loaded - flash["stock"][0]])
+
+    traces = {variant: read_csv(output / "unwind_trace.csv")
+              for variant, output in outputs.items()}
+    with open(arguments.output / "personality_frames.csv", "w",
+              newline="") as file:
+        writer = csv.writer(file)
+        writer.writerow(["exhibit", "function", "variant",
+                         "personality_calls", "personality",
+                         "personality_per_call", "unit"])
+        for variant, rows in traces.items():
+            for row in rows:
+                if row["exhibit"] not in EXHIBITS:
+                    continue
+                writer.writerow([row["exhibit"], row["function"], variant,
+                                 row["personality_calls"],
+                                 row["personality"], per_call(row),
+                                 row["unit"]])
+
+    saved = flash["stock"][0] - flash["slim"][0]
+    print(f"slim personality saves {saved} bytes of flash, see "
+          f"{arguments.output / 'personality_frames.csv'} for the "
+          f"instructions per frame")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
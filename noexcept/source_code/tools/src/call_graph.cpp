@@ -0,0 +1,241 @@
+#include "call_graph.hpp"
+
+#include <elf.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "thumb2.hpp"
+
+namespace {
+struct mapping_symbol
+{
+  std::uint32_t address = 0;
+  bool is_data = false;
+};
+
+/**
+ * @return std::vector<mapping_symbol> - every `$t`, `$a` and `$d` mapping
+ * symbol, sorted by address
+ */
+std::vector<mapping_symbol>
+collect_mapping_symbols(const elf_image& p_image)
+{
+  std::vector<mapping_symbol> mapping;
+  for (const auto& symbol : p_image.symbols()) {
+    const auto name = p_image.symbol_name(symbol);
+    if (ELF32_ST_TYPE(symbol.st_info) != STT_NOTYPE || name.size() < 2 ||
+        name[0] != '$' || (name.size() > 2 && name[2] != '.')) {
+      continue;
+    }
+    if (name[1] == 't' || name[1] == 'a' || name[1] == 'd') {
+      mapping.push_back({ symbol.st_value, name[1] == 'd' });
+    }
+  }
+  std::ranges::sort(mapping, {}, &mapping_symbol::address);
+  return mapping;
+}
+
+void
+add_node(call_graph& p_graph,
+         const elf_image& p_image,
+         const Elf32_Sym& p_symbol)
+{
+  const auto name = p_image.symbol_name(p_symbol);
+  // clear least significant bit produced by ARM function call ABI
+  const auto address = p_symbol.st_value & ~1U;
+
+  if (not p_graph.nodes.empty() && p_graph.nodes.back().address == address) {
+    auto& alias = p_graph.nodes.back();
+    alias.size = std::max(alias.size, p_symbol.st_size);
+  } else {
+    p_graph.nodes.push_back(
+      { .symbol = name, .address = address, .size = p_symbol.st_size });
+  }
+  p_graph.names.emplace_back(name, p_graph.nodes.size() - 1);
+}
+
+void
+decode_node(call_graph& p_graph,
+            call_graph_node& p_node,
+            const elf_image& p_image,
+            std::span<const mapping_symbol> p_mapping)
+{
+  const auto* code = p_image.to_host(p_node.address);
+  if (p_node.size == 0 || code == nullptr ||
+      not p_image.contains(code, p_node.size)) {
+    return;
+  }
+  p_node.decoded = true;
+
+  const auto start = p_node.address;
+  const auto end = p_node.address + p_node.size;
+
+  auto record = [&](const branch& p_branch) {
+    if (p_branch.kind == branch_kind::indirect_call ||
+        p_branch.kind == branch_kind::indirect_jump) {
+      p_node.indirect_branches++;
+      return;
+    }
+    if (start <= p_branch.target && p_branch.target < end) {
+      return; // stays within the function
+    }
+    if (const auto* callee = p_graph.find(p_branch.target)) {
+      const auto index = static_cast<std::size_t>(callee - p_graph.nodes.data());
+      p_node.callees.push_back(index);
+      p_node.calls.push_back({ .address = p_branch.address,
+                               .callee = index,
+                               .tail = p_branch.kind == branch_kind::jump });
+    } else {
+      p_node.unresolved_branches++;
+    }
+  };
+
+  // Split the function into runs of code, starting in the state of the last
+  // mapping symbol before it. Without mapping symbols everything is code.
+  auto marker = std::ranges::upper_bound(
+    p_mapping, start, {}, &mapping_symbol::address);
+  bool is_data = marker != p_mapping.begin() && std::prev(marker)->is_data;
+  auto run_start = start;
+
+  while (run_start < end) {
+    const auto run_end =
+      (marker != p_mapping.end() && marker->address < end) ? marker->address
+                                                           : end;
+    if (not is_data && run_start < run_end) {
+      for_each_branch(
+        std::span(code + (run_start - start), run_end - run_start),
+        run_start,
+        record);
+    }
+    if (run_end == end) {
+      break;
+    }
+    is_data = marker->is_data;
+    run_start = run_end;
+    marker++;
+  }
+
+  std::ranges::sort(p_node.callees);
+  const auto duplicates = std::ranges::unique(p_node.callees);
+  p_node.callees.erase(duplicates.begin(), duplicates.end());
+}
+
+/**
+ * @return std::string_view - the quoted value following p_key in p_block,
+ * empty if p_block has no such key
+ */
+std::string_view
+quoted_value(std::string_view p_block, std::string_view p_key)
+{
+  const auto key = p_block.find(p_key);
+  if (key == std::string_view::npos) {
+    return {};
+  }
+  const auto open = p_block.find('"', key + p_key.size());
+  const auto close = p_block.find('"', open + 1);
+  if (open == std::string_view::npos || close == std::string_view::npos) {
+    return {};
+  }
+  return p_block.substr(open + 1, close - open - 1);
+}
+} // namespace
+
+std::vector<std::size_t>
+call_graph::find(std::string_view p_symbol) const
+{
+  std::vector<std::size_t> matches;
+  const auto [first, last] = std::ranges::equal_range(
+    names, p_symbol, {}, &std::pair<std::string_view, std::size_t>::first);
+  for (auto name = first; name != last; name++) {
+    matches.push_back(name->second);
+  }
+  return matches;
+}
+
+const call_graph_node*
+call_graph::find(std::uint32_t p_address) const
+{
+  const auto match =
+    std::ranges::lower_bound(nodes, p_address, {}, &call_graph_node::address);
+  if (match == nodes.end() || match->address != p_address) {
+    return nullptr;
+  }
+  return &*match;
+}
+
+call_graph
+build_call_graph(const elf_image& p_image)
+{
+  std::vector<const Elf32_Sym*> functions;
+  for (const auto& symbol : p_image.symbols()) {
+    if (ELF32_ST_TYPE(symbol.st_info) == STT_FUNC &&
+        symbol.st_shndx != SHN_UNDEF && symbol.st_shndx < SHN_LORESERVE) {
+      functions.push_back(&symbol);
+    }
+  }
+  std::ranges::sort(functions, [](const auto* p_lhs, const auto* p_rhs) {
+    return (p_lhs->st_value & ~1U) < (p_rhs->st_value & ~1U);
+  });
+
+  call_graph graph;
+  graph.nodes.reserve(functions.size());
+  graph.names.reserve(functions.size());
+  for (const auto* function : functions) {
+    add_node(graph, p_image, *function);
+  }
+  std::ranges::sort(graph.names);
+
+  const auto mapping = collect_mapping_symbols(p_image);
+  for (auto& node : graph.nodes) {
+    decode_node(graph, node, p_image, mapping);
+  }
+
+  return graph;
+}
+
+std::size_t
+add_callgraph_info(call_graph& p_graph, const std::filesystem::path& p_path)
+{
+  std::ifstream file(p_path);
+  if (not file) {
+    throw std::runtime_error("unable to read " + p_path.string());
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const auto contents = buffer.str();
+  const std::string_view text = contents;
+
+  // Edges look like
+  //   edge: { sourcename: "_Z3foov" targetname: "_Z3barv" label: "a.cpp:3:6" }
+  std::size_t added = 0;
+  for (auto edge = text.find("edge:"); edge != std::string_view::npos;
+       edge = text.find("edge:", edge + 1)) {
+    const auto block_end = text.find('}', edge);
+    const auto block = text.substr(edge, block_end - edge);
+    const auto source = quoted_value(block, "sourcename:");
+    const auto target = quoted_value(block, "targetname:");
+
+    for (const auto caller : p_graph.find(source)) {
+      auto& node = p_graph.nodes[caller];
+      if (target == "__indirect_call") {
+        node.indirect_branches++;
+        added++;
+        continue;
+      }
+      for (const auto callee : p_graph.find(target)) {
+        const auto position = std::ranges::lower_bound(node.callees, callee);
+        if (position == node.callees.end() || *position != callee) {
+          node.callees.insert(position, callee);
+          added++;
+        }
+      }
+    }
+  }
+
+  return added;
+}
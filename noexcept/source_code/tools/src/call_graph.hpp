@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "elf_image.hpp"
+
+// Call graph of a linked ARM image, built from the branches in its code and
+// optionally extended with the call graphs GCC writes for -fcallgraph-info.
+
+/// A direct branch from one function into the start of another
+struct call_edge
+{
+  /// Address of the branch instruction
+  std::uint32_t address = 0;
+  /// Node branched to
+  std::size_t callee = 0;
+  /// True for a jump, the caller's frame is gone before the callee runs
+  bool tail = false;
+};
+
+struct call_graph_node
+{
+  /// First symbol at the address, aliases share the node
+  std::string_view symbol;
+  std::uint32_t address = 0;
+  std::uint32_t size = 0;
+  /// Nodes called or tail called, sorted and unique
+  std::vector<std::size_t> callees;
+  /// Every call and tail call found in the code, by address. Edges from
+  /// add_callgraph_info() have no address and are only in callees.
+  std::vector<call_edge> calls;
+  /// Calls and jumps through registers
+  std::size_t indirect_branches = 0;
+  /// Branches leaving the function for an address that is no function start
+  std::size_t unresolved_branches = 0;
+  /// False if the function has no size, so its code could not be decoded
+  bool decoded = false;
+};
+
+struct call_graph
+{
+  /// Sorted by address
+  std::vector<call_graph_node> nodes;
+  /// Every symbol name with its node, sorted by name. Local symbols can repeat.
+  std::vector<std::pair<std::string_view, std::size_t>> names;
+
+  /**
+   * @return std::vector<std::size_t> - nodes named p_symbol, more than one for
+   * local functions sharing a name
+   */
+  std::vector<std::size_t>
+  find(std::string_view p_symbol) const;
+
+  /**
+   * @return const call_graph_node* - node starting exactly at p_address,
+   * nullptr if there is none
+   */
+  const call_graph_node*
+  find(std::uint32_t p_address) const;
+};
+
+/**
+ * Decode every Thumb function of p_image. Literal pools are skipped using the
+ * `$t` and `$d` mapping symbols.
+ *
+ * @param p_image - linked image with a symbol table
+ * @return call_graph - one node per function address
+ */
+call_graph
+build_call_graph(const elf_image& p_image);
+
+/**
+ * Add the edges of a GCC -fcallgraph-info (.ci) file to p_graph. Calls to
+ * `__indirect_call` count as indirect branches, edges naming functions that are
+ * not in the image are ignored, the image shows they are never made.
+ *
+ * @param p_graph - graph to extend
+ * @param p_path - VCG file written by GCC
+ * @return std::size_t - number of edges added
+ * @throws std::runtime_error - if p_path cannot be read
+ */
+std::size_t
+add_callgraph_info(call_graph& p_graph, const std::filesystem::path& p_path);
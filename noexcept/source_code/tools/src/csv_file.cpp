@@ -0,0 +1,23 @@
+#include "csv_file.hpp"
+
+#include <stdexcept>
+
+file_handle
+create_output_file(const std::filesystem::path& p_path)
+{
+  file_handle file(std::fopen(p_path.c_str(), "w"), &std::fclose);
+  if (not file) {
+    throw std::runtime_error("unable to create " + p_path.string());
+  }
+  // Large buffer so tens of thousands of rows cost a handful of syscalls
+  std::setvbuf(file.get(), nullptr, _IOFBF, 1 << 20);
+  return file;
+}
+
+file_handle
+open_csv(const std::filesystem::path& p_path, const char* p_header)
+{
+  auto file = create_output_file(p_path);
+  std::fputs(p_header, file.get());
+  return file;
+}
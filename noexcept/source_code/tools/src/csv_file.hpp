@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+#include <filesystem>
+#include <memory>
+
+using file_handle = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+/**
+ * @param p_path - file to create or truncate
+ * @return file_handle - the open file, buffered for writing many lines
+ * @throws std::runtime_error - if the file cannot be created
+ */
+file_handle
+create_output_file(const std::filesystem::path& p_path);
+
+/**
+ * Create a csv file and write its header
+ *
+ * @param p_path - file to create or truncate
+ * @param p_header - first line of the file, including the newline
+ * @return file_handle - the open file, buffered for writing many rows
+ * @throws std::runtime_error - if the file cannot be created
+ */
+file_handle
+open_csv(const std::filesystem::path& p_path, const char* p_header);
@@ -0,0 +1,359 @@
+#include "eh_frame.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+
+#include "exception_metadata.hpp"
+
+namespace {
+constexpr std::uint8_t encoding_omit = 0xFF;
+constexpr std::uint8_t encoding_indirect = 0x80;
+
+template<typename T>
+T
+read(const std::uint8_t*& p_data)
+{
+  T value;
+  std::memcpy(&value, p_data, sizeof(value));
+  p_data += sizeof(value);
+  return value;
+}
+
+std::uint64_t
+read_uleb128_64(const std::uint8_t*& p_data)
+{
+  std::uint64_t result = 0;
+  unsigned shift = 0;
+  std::uint8_t byte = 0;
+  do {
+    byte = *p_data++;
+    if (shift < 64) {
+      result |= std::uint64_t{ byte & 0x7Fu } << shift;
+    }
+    shift += 7;
+  } while (byte & 0x80);
+  return result;
+}
+
+std::int64_t
+read_sleb128_64(const std::uint8_t*& p_data)
+{
+  std::uint64_t result = 0;
+  unsigned shift = 0;
+  std::uint8_t byte = 0;
+  do {
+    byte = *p_data++;
+    if (shift < 64) {
+      result |= std::uint64_t{ byte & 0x7Fu } << shift;
+    }
+    shift += 7;
+  } while (byte & 0x80);
+  if (shift < 64 && (byte & 0x40)) {
+    result |= ~std::uint64_t{ 0 } << shift;
+  }
+  return static_cast<std::int64_t>(result);
+}
+
+/**
+ * Read a DW_EH_PE encoded pointer. Indirect pointers are not followed, the
+ * caller gets the address of the pointer.
+ *
+ * @param p_data_base - base of datarel values, the `.eh_frame_hdr` address
+ */
+std::uint64_t
+read_encoded(const elf64_image& p_image,
+             const std::uint8_t*& p_data,
+             std::uint8_t p_encoding,
+             std::uint64_t p_data_base = 0)
+{
+  if (p_encoding == encoding_omit) {
+    return 0;
+  }
+
+  const auto field = p_image.to_target(p_data);
+  std::uint64_t value = 0;
+  const auto format = static_cast<std::uint8_t>(p_encoding & 0x0F);
+  const auto application = static_cast<std::uint8_t>(p_encoding & 0x70);
+  switch (personality_encoding{ format }) {
+    case personality_encoding::absptr:
+    case personality_encoding::udata8:
+    case personality_encoding::sdata8:
+      value = read<std::uint64_t>(p_data);
+      break;
+    case personality_encoding::uleb128:
+      value = read_uleb128_64(p_data);
+      break;
+    case personality_encoding::sleb128:
+      value = read_sleb128_64(p_data);
+      break;
+    case personality_encoding::udata2:
+      value = read<std::uint16_t>(p_data);
+      break;
+    case personality_encoding::sdata2:
+      value = read<std::int16_t>(p_data);
+      break;
+    case personality_encoding::udata4:
+      value = read<std::uint32_t>(p_data);
+      break;
+    case personality_encoding::sdata4:
+      value = read<std::int32_t>(p_data);
+      break;
+    default:
+      throw std::runtime_error("unsupported pointer encoding in .eh_frame");
+  }
+
+  switch (personality_encoding{ application }) {
+    case personality_encoding::absptr:
+      break;
+    case personality_encoding::pcrel:
+      value += field;
+      break;
+    case personality_encoding::datarel:
+      value += p_data_base;
+      break;
+    default:
+      throw std::runtime_error("unsupported pointer application in .eh_frame");
+  }
+
+  return value;
+}
+
+struct record_header
+{
+  const std::uint8_t* start = nullptr;
+  /// First byte after the length field
+  const std::uint8_t* contents = nullptr;
+  const std::uint8_t* end = nullptr;
+};
+
+/// @return record_header - the record at p_data, end is nullptr at the
+/// zero terminator
+record_header
+read_record_header(const std::uint8_t* p_data)
+{
+  record_header header{ .start = p_data };
+  std::uint64_t length = read<std::uint32_t>(p_data);
+  if (length == 0xFFFF'FFFF) {
+    length = read<std::uint64_t>(p_data);
+  }
+  header.contents = p_data;
+  header.end = length == 0 ? nullptr : p_data + length;
+  return header;
+}
+
+struct common_information
+{
+  std::size_t size = 0;
+  std::uint8_t fde_encoding = 0;
+  std::uint8_t lsda_encoding = encoding_omit;
+  bool has_augmentation_data = false;
+  std::uint64_t personality = 0;
+  bool personality_indirect = false;
+};
+
+common_information
+read_cie(const elf64_image& p_image, const std::uint8_t* p_cie)
+{
+  const auto header = read_record_header(p_cie);
+  if (header.end == nullptr) {
+    throw std::runtime_error("FDE refers to the .eh_frame terminator");
+  }
+
+  common_information cie{ .size =
+                            static_cast<std::size_t>(header.end - p_cie) };
+  const auto* data = header.contents;
+  if (read<std::uint32_t>(data) != 0) {
+    throw std::runtime_error("FDE does not refer to a CIE");
+  }
+  const auto version = *data++;
+  const std::string_view augmentation(reinterpret_cast<const char*>(data));
+  data += augmentation.size() + 1;
+
+  if (augmentation.starts_with("eh")) {
+    data += sizeof(std::uint64_t);
+  }
+  read_uleb128_64(data); // code alignment factor
+  read_sleb128_64(data); // data alignment factor
+  if (version == 1) {
+    data++; // return address register
+  } else {
+    read_uleb128_64(data);
+  }
+
+  if (not augmentation.starts_with('z')) {
+    return cie;
+  }
+  cie.has_augmentation_data = true;
+  read_uleb128_64(data); // augmentation data length
+
+  for (const auto letter : augmentation.substr(1)) {
+    switch (letter) {
+      case 'L':
+        cie.lsda_encoding = *data++;
+        break;
+      case 'P': {
+        const auto encoding = *data++;
+        cie.personality = read_encoded(p_image, data, encoding);
+        cie.personality_indirect = encoding & encoding_indirect;
+        break;
+      }
+      case 'R':
+        cie.fde_encoding = *data++;
+        break;
+      case 'S':
+      case 'B':
+      case 'G':
+        break;
+      default:
+        // Unknown letters make the rest of the augmentation data unreadable
+        return cie;
+    }
+  }
+
+  return cie;
+}
+
+class frame_reader
+{
+public:
+  explicit frame_reader(const elf64_image& p_image)
+    : m_image(p_image)
+  {
+  }
+
+  frame_description
+  read_fde(const std::uint8_t* p_fde)
+  {
+    const auto header = read_record_header(p_fde);
+    if (header.end == nullptr) {
+      throw std::runtime_error(".eh_frame_hdr refers to the terminator");
+    }
+    const auto* data = header.contents;
+    const auto* cie = data - read<std::uint32_t>(data);
+    const auto& common = lookup(cie);
+
+    frame_description fde{
+      .record = p_fde,
+      .record_size = static_cast<std::size_t>(header.end - p_fde),
+      .cie = cie,
+      .cie_size = common.size,
+      .personality = common.personality,
+      .personality_indirect = common.personality_indirect,
+    };
+    fde.function = read_encoded(m_image, data, common.fde_encoding);
+    // The range has the size of the encoding but is never relative
+    fde.size = read_encoded(m_image, data, common.fde_encoding & 0x0F);
+
+    if (common.has_augmentation_data) {
+      const auto length = read_uleb128_64(data);
+      const auto* augmentation_end = data + length;
+      if (common.lsda_encoding != encoding_omit && length != 0) {
+        auto* lsda_data = data;
+        const auto lsda =
+          read_encoded(m_image, lsda_data, common.lsda_encoding);
+        if (lsda != 0) {
+          fde.lsda = m_image.to_host(lsda);
+        }
+      }
+      data = augmentation_end;
+    }
+
+    fde.instruction_bytes = header.end - data;
+    return fde;
+  }
+
+private:
+  const common_information&
+  lookup(const std::uint8_t* p_cie)
+  {
+    auto found = m_cies.find(p_cie);
+    if (found == m_cies.end()) {
+      found = m_cies.emplace(p_cie, read_cie(m_image, p_cie)).first;
+    }
+    return found->second;
+  }
+
+  const elf64_image& m_image;
+  std::map<const std::uint8_t*, common_information> m_cies;
+};
+
+/// @return true - if the FDEs were read through the search table
+bool
+read_search_table(const elf64_image& p_image,
+                  frame_reader& p_reader,
+                  std::vector<frame_description>& p_frames)
+{
+  const auto* section = p_image.find_section(".eh_frame_hdr");
+  if (section == nullptr) {
+    return false;
+  }
+  const auto contents = p_image.section_data(*section);
+  if (contents.size() < 4 || contents[0] != 1) {
+    return false;
+  }
+
+  const auto* data = contents.data() + 4;
+  const auto data_base = section->sh_addr;
+  read_encoded(p_image, data, contents[1], data_base); // .eh_frame pointer
+  const auto count = read_encoded(p_image, data, contents[2], data_base);
+  const auto table_encoding = contents[3];
+  if (count == 0 || table_encoding == encoding_omit) {
+    return false;
+  }
+
+  p_frames.reserve(count);
+  for (std::uint64_t i = 0; i < count; i++) {
+    read_encoded(p_image, data, table_encoding, data_base); // initial location
+    const auto address = read_encoded(p_image, data, table_encoding, data_base);
+    const auto* fde = p_image.to_host(address);
+    if (fde == nullptr) {
+      throw std::runtime_error(".eh_frame_hdr points outside of the image");
+    }
+    p_frames.push_back(p_reader.read_fde(fde));
+  }
+  return true;
+}
+
+void
+walk_eh_frame(const elf64_image& p_image,
+              frame_reader& p_reader,
+              std::vector<frame_description>& p_frames)
+{
+  const auto* section = p_image.find_section(".eh_frame");
+  if (section == nullptr) {
+    return;
+  }
+  const auto contents = p_image.section_data(*section);
+  const auto* data = contents.data();
+  const auto* end = data + contents.size();
+
+  while (end - data >= 4) {
+    const auto header = read_record_header(data);
+    if (header.end == nullptr || header.end > end) {
+      break;
+    }
+    const auto* id = header.contents;
+    if (read<std::uint32_t>(id) != 0) {
+      p_frames.push_back(p_reader.read_fde(data));
+    }
+    data = header.end;
+  }
+}
+} // namespace
+
+std::vector<frame_description>
+read_frame_descriptions(const elf64_image& p_image)
+{
+  frame_reader reader(p_image);
+  std::vector<frame_description> frames;
+
+  if (not read_search_table(p_image, reader, frames)) {
+    walk_eh_frame(p_image, reader, frames);
+  }
+
+  std::ranges::sort(frames, {}, &frame_description::function);
+  return frames;
+}
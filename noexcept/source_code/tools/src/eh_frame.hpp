@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "elf_image.hpp"
+
+// DWARF call frame information as used for exceptions on x86-64: the
+// `.eh_frame_hdr` search table, the CIE and FDE records of `.eh_frame` and
+// the LSDA pointers into `.gcc_except_table`.
+
+struct frame_description
+{
+  /// First address covered by the FDE
+  std::uint64_t function = 0;
+  /// Number of bytes covered
+  std::uint64_t size = 0;
+  /// The FDE within the mapping, including its length field
+  const std::uint8_t* record = nullptr;
+  std::size_t record_size = 0;
+  /// Call frame instructions of the FDE, without those of its CIE
+  std::size_t instruction_bytes = 0;
+  /// The CIE shared with other FDEs, including its length field
+  const std::uint8_t* cie = nullptr;
+  std::size_t cie_size = 0;
+  /// Personality routine from the CIE, 0 if there is none. When
+  /// personality_indirect is set, this is the address of a pointer to it.
+  std::uint64_t personality = 0;
+  bool personality_indirect = false;
+  /// LSDA within the mapping, nullptr if the FDE has none
+  const std::uint8_t* lsda = nullptr;
+};
+
+/**
+ * Read every FDE of p_image, through the `.eh_frame_hdr` search table when the
+ * image has one, by walking `.eh_frame` otherwise.
+ *
+ * @param p_image - linked x86-64 image
+ * @return std::vector<frame_description> - sorted by function
+ * @throws std::runtime_error - if a record is malformed
+ */
+std::vector<frame_description>
+read_frame_descriptions(const elf64_image& p_image);
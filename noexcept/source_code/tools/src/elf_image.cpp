@@ -0,0 +1,369 @@
+#include "elf_image.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+template<typename T>
+std::span<const T>
+view_as(const std::uint8_t* p_data,
+        std::size_t p_size,
+        std::size_t p_offset,
+        std::size_t p_count)
+{
+  if (p_offset > p_size || p_count > (p_size - p_offset) / sizeof(T)) {
+    throw std::runtime_error("ELF structure lies outside of the file");
+  }
+  return { reinterpret_cast<const T*>(p_data + p_offset), p_count };
+}
+
+template<typename Section>
+bool
+is_loaded(const Section& p_section)
+{
+  return (p_section.sh_flags & SHF_ALLOC) && p_section.sh_type != SHT_NOBITS &&
+         p_section.sh_size != 0;
+}
+
+/**
+ * @return bool - false if p_section is in a segment loaded at another address
+ * than it runs at, which the startup code copies into place
+ */
+template<typename Segment, typename Section>
+bool
+runs_where_loaded(std::span<const Segment> p_segments,
+                  const Section& p_section)
+{
+  for (const auto& segment : p_segments) {
+    if (segment.p_type == PT_LOAD &&
+        p_section.sh_offset >= segment.p_offset &&
+        p_section.sh_offset - segment.p_offset < segment.p_filesz) {
+      return segment.p_vaddr == segment.p_paddr;
+    }
+  }
+  return true;
+}
+} // namespace
+
+template<typename Layout>
+basic_elf_image<Layout>::basic_elf_image(const char* p_path)
+{
+  const int file = ::open(p_path, O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    throw std::runtime_error(std::string("unable to open ") + p_path);
+  }
+
+  struct stat file_stat{};
+  if (::fstat(file, &file_stat) != 0 || file_stat.st_size <= 0) {
+    ::close(file);
+    throw std::runtime_error(std::string("unable to stat ") + p_path);
+  }
+
+  m_size = static_cast<std::size_t>(file_stat.st_size);
+  void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error(std::string("unable to map ") + p_path);
+  }
+  m_data = static_cast<const std::uint8_t*>(mapping);
+
+  // From here on the destructor will not run if we throw, so unmap manually
+  try {
+    const auto header =
+      view_as<typename Layout::file_header>(m_data, m_size, 0, 1);
+    const auto& ehdr = header.front();
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr.e_ident[EI_CLASS] != Layout::file_class ||
+        ehdr.e_ident[EI_DATA] != ELFDATA2LSB ||
+        ehdr.e_machine != Layout::machine) {
+      throw std::runtime_error(std::string("not a ") + Layout::description +
+                               " ELF file");
+    }
+    if (ehdr.e_shentsize != sizeof(section_header)) {
+      throw std::runtime_error("unexpected section header size");
+    }
+
+    m_sections =
+      view_as<section_header>(m_data, m_size, ehdr.e_shoff, ehdr.e_shnum);
+    if (ehdr.e_phnum != 0) {
+      if (ehdr.e_phentsize != sizeof(program_header)) {
+        throw std::runtime_error("unexpected program header size");
+      }
+      m_segments =
+        view_as<program_header>(m_data, m_size, ehdr.e_phoff, ehdr.e_phnum);
+    }
+
+    if (ehdr.e_shstrndx < m_sections.size()) {
+      const auto& names = m_sections[ehdr.e_shstrndx];
+      const auto data = view_as<char>(
+        m_data, m_size, names.sh_offset, names.sh_size);
+      m_section_names = { data.data(), data.size() };
+    }
+
+    if (const auto* symtab = find_section_by_type(SHT_SYMTAB)) {
+      m_symbols = view_as<symbol>(m_data,
+                                  m_size,
+                                  symtab->sh_offset,
+                                  symtab->sh_size / sizeof(symbol));
+      if (symtab->sh_link < m_sections.size()) {
+        const auto& names = m_sections[symtab->sh_link];
+        const auto data =
+          view_as<char>(m_data, m_size, names.sh_offset, names.sh_size);
+        m_symbol_names = { data.data(), data.size() };
+      }
+    }
+
+    bool first = true;
+    for (const auto& section : m_sections) {
+      if (not is_loaded(section)) {
+        continue;
+      }
+      view_as<std::uint8_t>(
+        m_data, m_size, section.sh_offset, section.sh_size);
+      if (not runs_where_loaded(m_segments, section)) {
+        continue;
+      }
+      const auto bias = static_cast<std::intptr_t>(section.sh_offset) -
+                        static_cast<std::intptr_t>(section.sh_addr);
+      if (first) {
+        m_bias = bias;
+        first = false;
+      } else if (bias != m_bias) {
+        m_uniform_layout = false;
+      }
+    }
+  } catch (...) {
+    ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    throw;
+  }
+}
+
+template<typename Layout>
+basic_elf_image<Layout>::~basic_elf_image()
+{
+  ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+}
+
+template<typename Layout>
+std::span<const typename basic_elf_image<Layout>::section_header>
+basic_elf_image<Layout>::sections() const
+{
+  return m_sections;
+}
+
+template<typename Layout>
+std::string_view
+basic_elf_image<Layout>::section_name(const section_header& p_section) const
+{
+  if (p_section.sh_name >= m_section_names.size()) {
+    return {};
+  }
+  return m_section_names.substr(p_section.sh_name).data();
+}
+
+template<typename Layout>
+const typename basic_elf_image<Layout>::section_header*
+basic_elf_image<Layout>::find_section(std::string_view p_name) const
+{
+  for (const auto& section : m_sections) {
+    if (section_name(section) == p_name) {
+      return &section;
+    }
+  }
+  return nullptr;
+}
+
+template<typename Layout>
+const typename basic_elf_image<Layout>::section_header*
+basic_elf_image<Layout>::find_section_by_type(std::uint32_t p_type) const
+{
+  for (const auto& section : m_sections) {
+    if (section.sh_type == p_type) {
+      return &section;
+    }
+  }
+  return nullptr;
+}
+
+template<typename Layout>
+const typename basic_elf_image<Layout>::section_header*
+basic_elf_image<Layout>::section_containing(address p_address) const
+{
+  for (const auto& section : m_sections) {
+    if (is_loaded(section) && p_address >= section.sh_addr &&
+        p_address - section.sh_addr < section.sh_size) {
+      return &section;
+    }
+  }
+  return nullptr;
+}
+
+template<typename Layout>
+std::span<const std::uint8_t>
+basic_elf_image<Layout>::section_data(const section_header& p_section) const
+{
+  if (p_section.sh_type == SHT_NOBITS) {
+    return {};
+  }
+  return view_as<std::uint8_t>(
+    m_data, m_size, p_section.sh_offset, p_section.sh_size);
+}
+
+template<typename Layout>
+std::span<const typename basic_elf_image<Layout>::symbol>
+basic_elf_image<Layout>::symbols() const
+{
+  return m_symbols;
+}
+
+template<typename Layout>
+std::string_view
+basic_elf_image<Layout>::symbol_name(const symbol& p_symbol) const
+{
+  if (p_symbol.st_name >= m_symbol_names.size()) {
+    return {};
+  }
+  return m_symbol_names.substr(p_symbol.st_name).data();
+}
+
+template<typename Layout>
+const typename basic_elf_image<Layout>::symbol*
+basic_elf_image<Layout>::find_symbol(std::string_view p_name) const
+{
+  for (const auto& candidate : m_symbols) {
+    if (candidate.st_shndx != SHN_UNDEF && symbol_name(candidate) == p_name) {
+      return &candidate;
+    }
+  }
+  return nullptr;
+}
+
+template<typename Layout>
+const std::uint8_t*
+basic_elf_image<Layout>::to_host(address p_address) const
+{
+  const auto* section = section_containing(p_address);
+  if (section == nullptr) {
+    return nullptr;
+  }
+  return m_data + section->sh_offset + (p_address - section->sh_addr);
+}
+
+template<typename Layout>
+typename basic_elf_image<Layout>::address
+basic_elf_image<Layout>::to_target(const volatile void* p_pointer) const
+{
+  const auto offset =
+    reinterpret_cast<const volatile std::uint8_t*>(p_pointer) -
+    const_cast<const volatile std::uint8_t*>(m_data);
+  const auto position = static_cast<std::size_t>(offset);
+  for (const auto& section : m_sections) {
+    if (is_loaded(section) && offset >= 0 && position >= section.sh_offset &&
+        position - section.sh_offset < section.sh_size) {
+      return static_cast<address>(section.sh_addr +
+                                  (position - section.sh_offset));
+    }
+  }
+  return static_cast<address>(offset - m_bias);
+}
+
+template<typename Layout>
+std::size_t
+basic_elf_image<Layout>::file_offset(const volatile void* p_pointer) const
+{
+  if (not contains(p_pointer, 0)) {
+    throw std::runtime_error("pointer does not refer to the file contents");
+  }
+  return reinterpret_cast<std::uintptr_t>(p_pointer) -
+         reinterpret_cast<std::uintptr_t>(m_data);
+}
+
+template<typename Layout>
+bool
+basic_elf_image<Layout>::has_uniform_layout() const
+{
+  return m_uniform_layout;
+}
+
+template<typename Layout>
+void
+basic_elf_image<Layout>::require_uniform_layout() const
+{
+  if (not m_uniform_layout) {
+    throw std::runtime_error(
+      "loaded sections do not share a single file offset, relative offsets "
+      "in the exception tables cannot be followed in place");
+  }
+}
+
+template<typename Layout>
+bool
+basic_elf_image<Layout>::contains(const volatile void* p_pointer,
+                                  std::size_t p_size) const
+{
+  const auto address = reinterpret_cast<std::uintptr_t>(p_pointer);
+  const auto begin = reinterpret_cast<std::uintptr_t>(m_data);
+  return address >= begin && address - begin <= m_size &&
+         p_size <= m_size - (address - begin);
+}
+
+template class basic_elf_image<elf32_arm_layout>;
+template class basic_elf_image<elf64_x86_64_layout>;
+
+void
+write_patched_copy(const elf_image& p_image,
+                   std::span<const image_patch> p_patches,
+                   const std::filesystem::path& p_input,
+                   const std::filesystem::path& p_output)
+{
+  if (not std::filesystem::exists(p_output) ||
+      not std::filesystem::equivalent(p_input, p_output)) {
+    std::filesystem::copy_file(
+      p_input, p_output, std::filesystem::copy_options::overwrite_existing);
+  }
+  if (p_patches.empty()) {
+    return;
+  }
+
+  std::fstream file(p_output, std::ios::in | std::ios::out | std::ios::binary);
+  if (not file) {
+    throw std::runtime_error("unable to open " + p_output.string());
+  }
+
+  for (const auto& patch : p_patches) {
+    file.seekp(p_image.file_offset(patch.location));
+    file.write(reinterpret_cast<const char*>(patch.bytes.data()),
+               patch.bytes.size());
+  }
+
+  if (not file.flush()) {
+    throw std::runtime_error("unable to write " + p_output.string());
+  }
+}
+
+unsigned char
+elf_file_class(const char* p_path)
+{
+  unsigned char identification[EI_NIDENT]{};
+  std::FILE* file = std::fopen(p_path, "rb");
+  if (file == nullptr) {
+    return ELFCLASSNONE;
+  }
+  const auto read = std::fread(identification, 1, sizeof(identification), file);
+  std::fclose(file);
+
+  if (read != sizeof(identification) ||
+      std::memcmp(identification, ELFMAG, SELFMAG) != 0) {
+    return ELFCLASSNONE;
+  }
+  return identification[EI_CLASS];
+}
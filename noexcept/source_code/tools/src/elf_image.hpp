@@ -0,0 +1,163 @@
+#pragma once
+
+#include <elf.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+/// ELF structures of a 32-bit little endian ARM image
+struct elf32_arm_layout
+{
+  using file_header = Elf32_Ehdr;
+  using program_header = Elf32_Phdr;
+  using section_header = Elf32_Shdr;
+  using symbol = Elf32_Sym;
+  using address = std::uint32_t;
+
+  static constexpr unsigned char file_class = ELFCLASS32;
+  static constexpr std::uint16_t machine = EM_ARM;
+  static constexpr const char* description = "32-bit little endian ARM";
+};
+
+/// ELF structures of a 64-bit little endian x86-64 image
+struct elf64_x86_64_layout
+{
+  using file_header = Elf64_Ehdr;
+  using program_header = Elf64_Phdr;
+  using section_header = Elf64_Shdr;
+  using symbol = Elf64_Sym;
+  using address = std::uint64_t;
+
+  static constexpr unsigned char file_class = ELFCLASS64;
+  static constexpr std::uint16_t machine = EM_X86_64;
+  static constexpr const char* description = "64-bit little endian x86-64";
+};
+
+/**
+ * Read-only, zero-copy view of an ELF file of the machine described by
+ * Layout.
+ *
+ * The file is memory mapped and every accessor hands out pointers into that
+ * mapping, nothing is copied. Errors are reported by throwing
+ * std::runtime_error.
+ */
+template<typename Layout>
+class basic_elf_image
+{
+public:
+  using program_header = typename Layout::program_header;
+  using section_header = typename Layout::section_header;
+  using symbol = typename Layout::symbol;
+  using address = typename Layout::address;
+
+  explicit basic_elf_image(const char* p_path);
+  basic_elf_image(const basic_elf_image&) = delete;
+  basic_elf_image& operator=(const basic_elf_image&) = delete;
+  ~basic_elf_image();
+
+  std::span<const section_header> sections() const;
+  std::string_view section_name(const section_header& p_section) const;
+  const section_header* find_section(std::string_view p_name) const;
+  const section_header* find_section_by_type(std::uint32_t p_type) const;
+  const section_header* section_containing(address p_address) const;
+  std::span<const std::uint8_t> section_data(
+    const section_header& p_section) const;
+
+  std::span<const symbol> symbols() const;
+  std::string_view symbol_name(const symbol& p_symbol) const;
+  const symbol* find_symbol(std::string_view p_name) const;
+
+  /**
+   * @return const std::uint8_t* - location of p_address within the mapping or
+   * nullptr if the address is not backed by file contents.
+   */
+  const std::uint8_t* to_host(address p_address) const;
+
+  /**
+   * @return address - target address of a pointer previously produced by
+   * to_host() or by following relative offsets from one. Pointers into a
+   * loaded section map through that section, others through the bias of the
+   * sections that run where they are loaded.
+   */
+  address to_target(const volatile void* p_pointer) const;
+
+  /**
+   * The exception decoders follow prel31 offsets directly on the mapped
+   * memory. That is only valid if the sections they read keep the same
+   * distance from each other in the file as in the target's address space.
+   * Sections the startup code copies elsewhere, such as .data placed
+   * `>ram AT>flash`, are never reached through those offsets and are left
+   * out.
+   *
+   * @return true - if every loaded section that runs at its load address
+   * shares a single file offset bias
+   */
+  bool has_uniform_layout() const;
+
+  /**
+   * Throw std::runtime_error unless has_uniform_layout(), for the tools that
+   * read the exception tables of the image in place
+   */
+  void require_uniform_layout() const;
+
+  /**
+   * @return std::size_t - position of p_pointer, which must lie within the
+   * file, from the start of the file. Used to patch a copy of the file.
+   */
+  std::size_t file_offset(const volatile void* p_pointer) const;
+
+  /// @return true - if [p_pointer, p_pointer + p_size) lies within the file
+  bool contains(const volatile void* p_pointer, std::size_t p_size) const;
+
+private:
+  const std::uint8_t* m_data = nullptr;
+  std::size_t m_size = 0;
+  std::span<const program_header> m_segments{};
+  std::span<const section_header> m_sections{};
+  std::span<const symbol> m_symbols{};
+  std::string_view m_section_names{};
+  std::string_view m_symbol_names{};
+  std::intptr_t m_bias = 0;
+  bool m_uniform_layout = true;
+};
+
+extern template class basic_elf_image<elf32_arm_layout>;
+extern template class basic_elf_image<elf64_x86_64_layout>;
+
+using elf_image = basic_elf_image<elf32_arm_layout>;
+using elf64_image = basic_elf_image<elf64_x86_64_layout>;
+
+/**
+ * @param p_path - file to inspect
+ * @return unsigned char - ELFCLASS32 or ELFCLASS64, ELFCLASSNONE if p_path
+ * cannot be read or is not an ELF file
+ */
+unsigned char
+elf_file_class(const char* p_path);
+
+/// Bytes to store over the file contents at a location of the mapped image
+struct image_patch
+{
+  /// Pointer into the mapped image, as handed out by its accessors
+  const void* location = nullptr;
+  /// Target bytes, the image is little endian like the hosts of these tools
+  std::span<const std::byte> bytes;
+};
+
+/**
+ * Copy p_input to p_output, unless they are the same file, then apply
+ * p_patches to the copy. Nothing moves, so the copy keeps every address of the
+ * original.
+ *
+ * @param p_image - mapping of p_input the patch locations point into
+ * @throws std::runtime_error - if p_output cannot be written
+ */
+void
+write_patched_copy(const elf_image& p_image,
+                   std::span<const image_patch> p_patches,
+                   const std::filesystem::path& p_input,
+                   const std::filesystem::path& p_output);
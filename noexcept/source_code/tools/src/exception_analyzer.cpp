@@ -0,0 +1,461 @@
+/**
+ * @file exception_analyzer.cpp
+ * @brief Host side version of the on-target exception metadata analysis
+ *
+ * Runs the same exception_info/lsda_info classification as main.cpp, but over
+ * every function in an ARM ELF file rather than a hand picked list, and writes
+ * the results using the csv/v1 schema. The size of the exception index and
+ * table are written to exception_sections.csv and the decoded unwind
+ * instructions of every function to unwind_info.csv. landing_pads.csv holds
+ * the call sites and landing pads of every function and the bytes of code
+ * only reached through its landing pads. prologue_info.csv compares the unwind
+ * instructions of every function with the fewest its prologue needs, and
+ * register_choices.csv lists the functions that would rank cheaper if they
+ * saved other registers.
+ *
+ * 64-bit x86-64 images are analyzed from their DWARF call frame information
+ * instead, `.eh_frame_hdr`, `.eh_frame` and `.gcc_except_table`, into the
+ * same csv/v1 files. Functions with an FDE but no LSDA rank as
+ * table_personality, eh_frame_info.csv holds the size of every FDE.
+ *
+ * Usage:
+ *
+ *     exception_analyzer app.elf [output_directory]
+ *
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_file.hpp"
+#include "eh_frame.hpp"
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+#include "exception_tables.hpp"
+#include "landing_pads.hpp"
+#include "metadata_csv.hpp"
+#include "prologue.hpp"
+#include "symbol_names.hpp"
+#include "unwind_instructions.hpp"
+
+namespace {
+struct landing_pad_info
+{
+  std::uint32_t call_sites = 0;
+  /// Distinct landing pads, call sites often share one
+  std::uint32_t landing_pads = 0;
+  std::uint32_t landing_pad_bytes = 0;
+};
+
+/**
+ * Collect the landing pads of p_lsda and measure the code of p_function that
+ * only they reach
+ */
+landing_pad_info
+measure_landing_pads(const elf_image& p_image,
+                     const function_symbol& p_function,
+                     const lsda_info& p_lsda,
+                     std::span<const std::uint32_t> p_noreturn)
+{
+  landing_pad_info info{};
+  const auto start = p_image.to_target(p_function.address);
+  std::vector<std::uint32_t> pads;
+  for_each_call_site(p_lsda, [&](const call_site_record& p_site) {
+    info.call_sites++;
+    if (p_site.landing_pad != 0) {
+      pads.push_back(start + p_site.landing_pad);
+    }
+  });
+  std::ranges::sort(pads);
+  const auto duplicates = std::ranges::unique(pads);
+  pads.erase(duplicates.begin(), duplicates.end());
+  info.landing_pads = pads.size();
+
+  if (p_image.contains(p_function.address, p_function.size)) {
+    info.landing_pad_bytes = measure_landing_pad_code(
+      std::span(p_function.address, p_function.size), start, pads, p_noreturn);
+  }
+  return info;
+}
+
+/// @return std::string - p_registers as "r4 r5 lr"
+std::string
+register_list(std::uint16_t p_registers)
+{
+  constexpr std::array<const char*, 16> names{
+    "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+    "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc",
+  };
+  std::string list;
+  for (std::size_t i = 0; i < names.size(); i++) {
+    if (p_registers & (1U << i)) {
+      list += list.empty() ? "" : " ";
+      list += names[i];
+    }
+  }
+  return list;
+}
+
+/// @return std::string - the D registers saved by p_saves as "d8-d9"
+std::string
+vfp_register_list(const register_saves& p_saves)
+{
+  if (p_saves.vfp_registers == 0) {
+    return {};
+  }
+  const auto last = p_saves.first_vfp_register + p_saves.vfp_registers - 1;
+  return "d" + std::to_string(p_saves.first_vfp_register) + "-d" +
+         std::to_string(last);
+}
+
+/**
+ * Write the prologue_info.csv row of a function and, if saving other
+ * registers would give it a cheaper rank, its register_choices.csv row
+ */
+void
+write_register_saves(std::FILE* p_prologue_csv,
+                     std::FILE* p_choice_csv,
+                     const char* p_name,
+                     const exception_info& p_info,
+                     const unwind_info& p_unwind,
+                     const prologue_info& p_prologue)
+{
+  const bool compact = p_info.rank == metadata_rank::inlined_personality ||
+                       p_info.rank == metadata_rank::table_personality;
+  if (not p_prologue.decoded ||
+      (not compact && p_info.rank != metadata_rank::table_gcc_lsda)) {
+    return;
+  }
+
+  const auto& saves = p_prologue.saves;
+  const auto minimal = minimal_unwind_bytes(saves);
+  // The LSDA keeps a function in the table whatever its prologue
+  const auto predicted = compact ? compact_rank(minimal) : p_info.rank;
+  std::fprintf(p_prologue_csv,
+               "%s,%s,%s,%s,%" PRId32 ",%d,%" PRIu32 ",%" PRIu32 ",%" PRIu32
+               ",%" PRIu32 ",%s\n",
+               p_name,
+               to_string(p_info.rank),
+               register_list(saves.core_registers).c_str(),
+               vfp_register_list(saves).c_str(),
+               saves.stack_adjust,
+               saves.frame_pointer,
+               p_prologue.epilogues,
+               p_prologue.mismatched_epilogues,
+               p_unwind.opcode_bytes,
+               minimal,
+               to_string(predicted));
+
+  // Renaming registers only helps if every epilogue restores the same set
+  if (not compact || p_prologue.mismatched_epilogues != 0) {
+    return;
+  }
+  const auto choice = contiguous_register_choice(saves);
+  const auto choice_bytes = minimal_unwind_bytes(choice);
+  const auto choice_rank = compact_rank(choice_bytes);
+  if (choice_rank >= p_info.rank) {
+    return;
+  }
+  const auto table_bytes =
+    p_info.rank == metadata_rank::inlined_personality ? 0 : p_unwind.words * 4;
+  std::fprintf(p_choice_csv,
+               "%s,%s,%s,%" PRIu32 ",%" PRIu32 ",%s,%s,%" PRIu32 ",%" PRIu32
+               "\n",
+               p_name,
+               to_string(p_info.rank),
+               register_list(saves.core_registers).c_str(),
+               p_unwind.opcode_bytes,
+               table_bytes,
+               register_list(choice.core_registers).c_str(),
+               to_string(choice_rank),
+               choice_bytes,
+               table_bytes - exception_table_bytes(choice_rank, choice_bytes));
+}
+
+void
+write_section_sizes(const elf_image& p_image,
+                    const std::filesystem::path& p_output)
+{
+  auto csv = open_csv(p_output / "exception_sections.csv", "section,size\n");
+  std::fprintf(csv.get(),
+               "exidx,%zu\n",
+               find_exception_index(p_image).size_bytes());
+  std::fprintf(
+    csv.get(), "extab,%zu\n", find_exception_table(p_image).size());
+  // Program size, the scale the exception sections are compared against
+  if (const auto* text = p_image.find_section(".text")) {
+    std::fprintf(csv.get(), "text,%zu\n", std::size_t{ text->sh_size });
+  }
+}
+
+void
+analyze_arm(const char* p_elf_path, const std::filesystem::path& p_output)
+{
+  const elf_image image(p_elf_path);
+
+  image.require_uniform_layout();
+
+  const auto exception_index = find_exception_index(image);
+  validate_exception_index(image, exception_index);
+
+  const void* gcc_personality = find_gcc_personality(image);
+
+  const auto functions = collect_functions(image);
+  const auto noreturn = find_noreturn_routines(image);
+
+  // Aliases share an address, the index only needs to be walked once for them
+  std::vector<void*> addresses;
+  addresses.reserve(functions.size());
+  for (const auto& function : functions) {
+    auto* address = const_cast<std::uint8_t*>(function.address);
+    if (addresses.empty() || addresses.back() != address) {
+      addresses.push_back(address);
+    }
+  }
+
+  std::filesystem::create_directories(p_output);
+  write_section_sizes(image, p_output);
+
+  auto rank_csv =
+    open_csv(p_output / "exception_rank.csv", exception_rank_csv_header);
+  auto lsda_csv = open_csv(p_output / "lsda_info.csv", lsda_info_csv_header);
+  auto unwind_csv =
+    open_csv(p_output / "unwind_info.csv", unwind_info_csv_header);
+  auto landing_pad_csv =
+    open_csv(p_output / "landing_pads.csv",
+             "function_name,call_sites,landing_pads,function_bytes,"
+             "landing_pad_bytes\n");
+  auto prologue_csv =
+    open_csv(p_output / "prologue_info.csv",
+             "function_name,rank,registers,vfp_registers,stack_adjust,"
+             "frame_pointer,epilogues,mismatched_epilogues,opcode_bytes,"
+             "minimal_opcode_bytes,predicted_rank\n");
+  auto choice_csv =
+    open_csv(p_output / "register_choices.csv",
+             "function_name,rank,registers,opcode_bytes,table_bytes,"
+             "better_registers,better_rank,better_opcode_bytes,"
+             "bytes_saved\n");
+
+  std::string row;
+  auto symbol_cursor = functions.begin();
+
+  scan_exception_index(
+    addresses,
+    exception_index,
+    gcc_personality,
+    [&](const exception_info& p_info) {
+      const auto lsda = generate_lsda_info(p_info);
+      const auto unwind = decode_unwind_instructions(p_info);
+      const auto index_entry =
+        p_info.index_entry ? image.to_target(p_info.index_entry) : 0;
+      landing_pad_info pads{};
+      prologue_info prologue{};
+      if (symbol_cursor != functions.end() &&
+          symbol_cursor->address == p_info.function_address) {
+        pads = measure_landing_pads(image, *symbol_cursor, lsda, noreturn);
+        if (image.contains(symbol_cursor->address, symbol_cursor->size)) {
+          prologue = decode_prologue(
+            std::span(symbol_cursor->address, symbol_cursor->size));
+        }
+      }
+
+      for (; symbol_cursor != functions.end() &&
+             symbol_cursor->address == p_info.function_address;
+           symbol_cursor++) {
+        const auto name = csv_field(function_name(symbol_cursor->symbol));
+        const auto demangled =
+          csv_field(demangled_name(symbol_cursor->symbol));
+        row.resize(name.size() + demangled.size() + 256);
+
+        auto length = format_exception_rank_row(
+          row, name.c_str(), demangled.c_str(), index_entry, p_info.rank);
+        std::fwrite(row.data(), 1, length, rank_csv.get());
+
+        length =
+          format_lsda_info_row(row, name.c_str(), demangled.c_str(), lsda);
+        std::fwrite(row.data(), 1, length, lsda_csv.get());
+
+        length =
+          format_unwind_info_row(row, name.c_str(), demangled.c_str(), unwind);
+        std::fwrite(row.data(), 1, length, unwind_csv.get());
+
+        std::fprintf(landing_pad_csv.get(),
+                     "%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\n",
+                     name.c_str(),
+                     pads.call_sites,
+                     pads.landing_pads,
+                     symbol_cursor->size,
+                     pads.landing_pad_bytes);
+
+        write_register_saves(prologue_csv.get(),
+                             choice_csv.get(),
+                             name.c_str(),
+                             p_info,
+                             unwind,
+                             prologue);
+      }
+    });
+}
+
+/**
+ * Rank a function by its FDE. x86-64 keeps all unwind information in
+ * `.eh_frame`, so a function that can be unwound without an LSDA ranks like a
+ * compact model entry in the ARM exception table.
+ */
+metadata_rank
+rank_of(const frame_description* p_frame, bool p_gcc_personality)
+{
+  if (p_frame == nullptr) {
+    return metadata_rank::no_entry;
+  }
+  if (p_frame->lsda == nullptr) {
+    return metadata_rank::table_personality;
+  }
+  return p_gcc_personality ? metadata_rank::table_gcc_lsda
+                           : metadata_rank::unknown;
+}
+
+/// @return true - if p_frame's personality routine is __gxx_personality_v0
+bool
+uses_gcc_personality(const elf64_image& p_image,
+                     const frame_description& p_frame)
+{
+  // Position independent code reaches the personality routine through a
+  // DW.ref.__gxx_personality_v0 pointer, which is only filled in at load time
+  constexpr std::string_view gcc_personality = "__gxx_personality_v0";
+  constexpr std::string_view reference_prefix = "DW.ref.";
+
+  for (const auto& symbol : p_image.symbols()) {
+    if (symbol.st_value != p_frame.personality ||
+        symbol.st_shndx == SHN_UNDEF) {
+      continue;
+    }
+    auto name = p_image.symbol_name(symbol);
+    if (p_frame.personality_indirect && name.starts_with(reference_prefix)) {
+      name.remove_prefix(reference_prefix.size());
+    }
+    if (name == gcc_personality) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+write_section_sizes(const elf64_image& p_image,
+                    const std::filesystem::path& p_output)
+{
+  auto csv = open_csv(p_output / "exception_sections.csv", "section,size\n");
+  for (const auto* name :
+       { ".eh_frame_hdr", ".eh_frame", ".gcc_except_table" }) {
+    const auto* section = p_image.find_section(name);
+    std::fprintf(csv.get(),
+                 "%s,%zu\n",
+                 name + 1,
+                 section ? static_cast<std::size_t>(section->sh_size) : 0);
+  }
+}
+
+void
+analyze_x86_64(const char* p_elf_path, const std::filesystem::path& p_output)
+{
+  const elf64_image image(p_elf_path);
+  const auto frames = read_frame_descriptions(image);
+  const auto functions = collect_functions(image);
+
+  std::filesystem::create_directories(p_output);
+  write_section_sizes(image, p_output);
+
+  auto rank_csv =
+    open_csv(p_output / "exception_rank.csv", exception_rank_csv_header);
+  auto lsda_csv = open_csv(p_output / "lsda_info.csv", lsda_info_csv_header);
+  auto frame_csv = open_csv(p_output / "eh_frame_info.csv",
+                            "function_name,fde_size,cie_size,"
+                            "instruction_bytes,lsda_size\n");
+
+  // CIEs are shared, look up the personality routine of each one once
+  std::map<const std::uint8_t*, bool> gcc_personality;
+  std::string row;
+
+  for (const auto& function : functions) {
+    const auto address = image.to_target(function.address);
+    const auto match = std::ranges::lower_bound(
+      frames, address, {}, &frame_description::function);
+    const frame_description* frame =
+      (match != frames.end() && match->function == address) ? &*match : nullptr;
+
+    bool is_gcc = false;
+    if (frame != nullptr && frame->lsda != nullptr) {
+      auto [cached, inserted] = gcc_personality.try_emplace(frame->cie);
+      if (inserted) {
+        cached->second = uses_gcc_personality(image, *frame);
+      }
+      is_gcc = cached->second;
+    }
+
+    const auto rank = rank_of(frame, is_gcc);
+    lsda_info lsda{};
+    if (rank == metadata_rank::table_gcc_lsda) {
+      lsda = decode_lsda(frame->lsda, frame->lsda, sizeof(std::uint64_t));
+    }
+
+    const auto name = csv_field(function_name(function.symbol));
+    const auto demangled = csv_field(demangled_name(function.symbol));
+    row.resize(name.size() + demangled.size() + 256);
+
+    auto length =
+      format_exception_rank_row(row,
+                                name.c_str(),
+                                demangled.c_str(),
+                                frame ? image.to_target(frame->record) : 0,
+                                rank);
+    std::fwrite(row.data(), 1, length, rank_csv.get());
+
+    length = format_lsda_info_row(row, name.c_str(), demangled.c_str(), lsda);
+    std::fwrite(row.data(), 1, length, lsda_csv.get());
+
+    if (frame != nullptr) {
+      std::fprintf(frame_csv.get(),
+                   "%s,%zu,%zu,%zu,%" PRIu32 "\n",
+                   name.c_str(),
+                   frame->record_size,
+                   frame->cie_size,
+                   frame->instruction_bytes,
+                   lsda.total_size);
+    }
+  }
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  if (p_argc < 2 || p_argc > 3) {
+    std::fprintf(stderr, "usage: %s <app.elf> [output_directory]\n", p_argv[0]);
+    return 1;
+  }
+
+  try {
+    const std::filesystem::path output = p_argc == 3 ? p_argv[2] : ".";
+    if (elf_file_class(p_argv[1]) == ELFCLASS64) {
+      analyze_x86_64(p_argv[1], output);
+    } else {
+      analyze_arm(p_argv[1], output);
+    }
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", p_argv[1], p_error.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include "exception_tables.hpp"
+
+#include <elf.h>
+
+#include <cinttypes>
+#include <cstdio>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+/**
+ * @return std::span<const std::uint8_t> - bytes between two linker script
+ * symbols or, if the image does not define them, the contents of
+ * p_fallback_section.
+ */
+std::span<const std::uint8_t>
+find_region(const elf_image& p_image,
+            std::string_view p_start_symbol,
+            std::string_view p_end_symbol,
+            const Elf32_Shdr* p_fallback_section)
+{
+  const auto* start = p_image.find_symbol(p_start_symbol);
+  const auto* end = p_image.find_symbol(p_end_symbol);
+  if (start && end) {
+    const auto* begin = p_image.to_host(start->st_value);
+    const std::size_t size = end->st_value - start->st_value;
+    if (begin == nullptr || not p_image.contains(begin, size)) {
+      return {};
+    }
+    return { begin, size };
+  }
+  if (p_fallback_section) {
+    return p_image.section_data(*p_fallback_section);
+  }
+  return {};
+}
+
+template<typename Image>
+std::vector<function_symbol>
+collect_function_symbols(const Image& p_image,
+                         typename Image::address p_address_mask)
+{
+  std::vector<function_symbol> functions;
+  functions.reserve(p_image.symbols().size());
+
+  for (const auto& symbol : p_image.symbols()) {
+    if (ELF32_ST_TYPE(symbol.st_info) != STT_FUNC ||
+        symbol.st_shndx == SHN_UNDEF || symbol.st_shndx >= SHN_LORESERVE) {
+      continue;
+    }
+    const auto* address = p_image.to_host(symbol.st_value & p_address_mask);
+    if (address == nullptr) {
+      continue;
+    }
+    functions.push_back({ address,
+                          p_image.symbol_name(symbol),
+                          static_cast<std::uint32_t>(symbol.st_size) });
+  }
+
+  std::ranges::sort(functions, [](const auto& p_lhs, const auto& p_rhs) {
+    if (p_lhs.address != p_rhs.address) {
+      return p_lhs.address < p_rhs.address;
+    }
+    return p_lhs.symbol < p_rhs.symbol;
+  });
+
+  return functions;
+}
+} // namespace
+
+std::span<const arm_index_entry>
+find_exception_index(const elf_image& p_image)
+{
+  // The linker script names the output section `.exception_index`, so prefer
+  // the symbols the unwinder itself uses over any particular section name.
+  const auto region = find_region(p_image,
+                                  "__exidx_start",
+                                  "__exidx_end",
+                                  p_image.find_section_by_type(SHT_ARM_EXIDX));
+
+  return { reinterpret_cast<const arm_index_entry*>(region.data()),
+           region.size() / sizeof(arm_index_entry) };
+}
+
+std::span<const std::uint8_t>
+find_exception_table(const elf_image& p_image)
+{
+  // standard_arm.ld collects .ARM.extab into `.exception_table`
+  const auto* section = p_image.find_section(".exception_table");
+  if (section == nullptr) {
+    section = p_image.find_section(".ARM.extab");
+  }
+  return find_region(p_image, "__extab_start", "__extab_end", section);
+}
+
+void
+validate_exception_index(const elf_image& p_image,
+                         std::span<const arm_index_entry> p_index)
+{
+  for (const auto& entry : p_index) {
+    if (entry.content == cannot_unwind_token ||
+        entry.content & is_personality_data) {
+      continue;
+    }
+    const auto* table = to_absolute_address(&entry.content);
+    if (not p_image.contains(table, 2 * sizeof(std::uint32_t))) {
+      char message[96];
+      std::snprintf(message,
+                    sizeof(message),
+                    "exception index entry at 0x%" PRIx32
+                    " points outside of the image",
+                    p_image.to_target(&entry));
+      throw std::runtime_error(message);
+    }
+  }
+}
+
+const void*
+find_gcc_personality(const elf_image& p_image)
+{
+  if (const auto* symbol = p_image.find_symbol("__gxx_personality_v0")) {
+    return p_image.to_host(symbol->st_value);
+  }
+  return nullptr;
+}
+
+std::vector<function_symbol>
+collect_functions(const elf_image& p_image)
+{
+  // clear least significant bit produced by ARM function call ABI
+  return collect_function_symbols(p_image, ~1U);
+}
+
+std::vector<function_symbol>
+collect_functions(const elf64_image& p_image)
+{
+  return collect_function_symbols(p_image, ~std::uint64_t{ 0 });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+
+// Locate the exception tables and functions of an ARM ELF image, shared by the
+// host tools.
+
+struct function_symbol
+{
+  const std::uint8_t* address = nullptr;
+  std::string_view symbol;
+  /// Bytes of code, 0 if the symbol has no size
+  std::uint32_t size = 0;
+};
+
+/**
+ * @return std::span<const arm_index_entry> - the exception index within the
+ * mapped image, empty if the image has none.
+ */
+std::span<const arm_index_entry>
+find_exception_index(const elf_image& p_image);
+
+/**
+ * @return std::span<const std::uint8_t> - the exception table (.ARM.extab)
+ * region within the mapped image, empty if the image has none.
+ */
+std::span<const std::uint8_t>
+find_exception_table(const elf_image& p_image);
+
+/**
+ * Make sure every table reference points inside of the file before the
+ * decoders start to dereference them.
+ *
+ * @throws std::runtime_error - naming the first entry that does not
+ */
+void
+validate_exception_index(const elf_image& p_image,
+                         std::span<const arm_index_entry> p_index);
+
+/**
+ * @return const void* - `__gxx_personality_v0` within the mapped image or
+ * nullptr if the image does not define it.
+ */
+const void*
+find_gcc_personality(const elf_image& p_image);
+
+/**
+ * @return std::vector<function_symbol> - every defined function symbol, sorted
+ * by address and then by name so aliases are adjacent.
+ */
+std::vector<function_symbol>
+collect_functions(const elf_image& p_image);
+
+/// @copydoc collect_functions(const elf_image&)
+std::vector<function_symbol>
+collect_functions(const elf64_image& p_image);
@@ -0,0 +1,147 @@
+/**
+ * @file exidx_compactor.cpp
+ * @brief Replace empty GCC LSDAs with the inline CANTUNWIND token
+ *
+ * A function whose GCC LSDA has no call sites cannot catch or clean up after
+ * anything, every exception reaching it ends in std::terminate. Its exception
+ * index entry still points at a table entry holding the personality routine,
+ * the unwind instructions and the empty LSDA. This tool rewrites such index
+ * entries to EXIDX_CANTUNWIND (0x1), the same encoding used for functions the
+ * compiler knows cannot unwind, and zeroes the table bytes nothing references
+ * anymore.
+ *
+ * The program is unchanged apart from when std::terminate is reached: the
+ * unwinder now stops during its search phase at the converted function, where
+ * the personality routine used to stop it one phase later. Both are permitted
+ * for an exception leaving a noexcept function.
+ *
+ * Code and data after the exception table keep their addresses, so the image
+ * is not smaller until it is relinked, the report lists the bytes to gain.
+ *
+ * Usage:
+ *
+ *     exidx_compactor app.elf compacted.elf [report_directory]
+ *
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csv_file.hpp"
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+#include "exception_tables.hpp"
+#include "exidx_rewrite.hpp"
+#include "symbol_names.hpp"
+
+namespace {
+bool
+has_empty_lsda(const exception_info& p_info)
+{
+  if (p_info.rank != metadata_rank::table_gcc_lsda) {
+    return false;
+  }
+  const auto lsda = generate_lsda_info(p_info);
+  return lsda.valid && lsda.call_site.size == 0 && lsda.call_site.count == 0;
+}
+
+std::vector<cantunwind_rewrite>
+find_conversions(const elf_image& p_image,
+                 std::span<const arm_index_entry> p_index)
+{
+  const void* gcc_personality = find_gcc_personality(p_image);
+
+  std::vector<const arm_index_entry*> entries;
+  for (const auto& entry : p_index) {
+    if (has_empty_lsda(exception_info(entry, gcc_personality))) {
+      entries.push_back(&entry);
+    }
+  }
+
+  return plan_cantunwind_rewrites(p_image, p_index, entries);
+}
+
+std::string
+name_of(const std::vector<function_symbol>& p_functions, const void* p_address)
+{
+  const auto match = std::ranges::lower_bound(
+    p_functions,
+    static_cast<const std::uint8_t*>(p_address),
+    {},
+    &function_symbol::address);
+  if (match == p_functions.end() || match->address != p_address) {
+    return {};
+  }
+  return csv_field(function_name(match->symbol));
+}
+
+void
+compact(const std::filesystem::path& p_input,
+        const std::filesystem::path& p_output,
+        const std::filesystem::path& p_report)
+{
+  std::size_t freed_bytes = 0;
+  std::size_t converted = 0;
+  {
+    const elf_image image(p_input.c_str());
+    image.require_uniform_layout();
+
+    const auto index = find_exception_index(image);
+    validate_exception_index(image, index);
+
+    const auto conversions = find_conversions(image, index);
+    const auto functions = collect_functions(image);
+
+    std::filesystem::create_directories(p_report);
+    auto report =
+      open_csv(p_report / "exidx_compaction.csv",
+               "function_name,index_entry,table_entry,table_bytes_freed\n");
+    for (const auto& conversion : conversions) {
+      const auto name =
+        name_of(functions, get_function(*conversion.index_entry));
+      std::fprintf(report.get(),
+                   "%s,0x%" PRIx32 ",0x%" PRIx32 ",%zu\n",
+                   name.c_str(),
+                   image.to_target(conversion.index_entry),
+                   image.to_target(conversion.table_entry),
+                   conversion.table_bytes);
+      freed_bytes += conversion.table_bytes;
+    }
+    converted = conversions.size();
+
+    write_rewritten_copy(image, conversions, p_input, p_output);
+  }
+
+  std::printf("%zu index entries converted to CANTUNWIND, %zu bytes of the "
+              "exception table are no longer referenced\n",
+              converted,
+              freed_bytes);
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  if (p_argc < 3 || p_argc > 4) {
+    std::fprintf(stderr,
+                 "usage: %s <input.elf> <output.elf> [report_directory]\n",
+                 p_argv[0]);
+    return 1;
+  }
+
+  try {
+    compact(p_argv[1], p_argv[2], p_argc == 4 ? p_argv[3] : ".");
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", p_argv[1], p_error.what());
+    return 1;
+  }
+
+  return 0;
+}
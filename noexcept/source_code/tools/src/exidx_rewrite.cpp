@@ -0,0 +1,143 @@
+#include "exidx_rewrite.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "exception_tables.hpp"
+
+namespace {
+bool
+is_table_reference(const arm_index_entry& p_entry)
+{
+  return p_entry.content != cannot_unwind_token &&
+         not(p_entry.content & is_personality_data);
+}
+
+const std::uint8_t*
+table_entry_of(const arm_index_entry& p_entry)
+{
+  return static_cast<const std::uint8_t*>(
+    to_absolute_address(&p_entry.content));
+}
+
+/**
+ * @return std::size_t - smallest number of bytes the table entry of p_info is
+ * known to occupy, the maximum value if its personality routine is unknown.
+ */
+std::size_t
+decoded_size(const exception_info& p_info)
+{
+  constexpr std::size_t word_size = sizeof(std::uint32_t);
+
+  switch (p_info.rank) {
+    case metadata_rank::table_gcc_lsda:
+      return generate_lsda_info(p_info).total_size;
+    case metadata_rank::table_personality: {
+      // ARM compact model, personality routines 1 and 2 keep the number of
+      // additional instruction words in bits 16 to 23.
+      const auto first_word = *reinterpret_cast<const std::uint32_t*>(
+        table_entry_of(*p_info.index_entry));
+      const auto personality = (first_word >> 24) & 0xF;
+      const auto additional_words =
+        personality == 0 ? 0 : (first_word >> 16) & 0xFF;
+      return (additional_words + 1) * word_size;
+    }
+    default:
+      return std::numeric_limits<std::size_t>::max();
+  }
+}
+} // namespace
+
+std::vector<cantunwind_rewrite>
+plan_cantunwind_rewrites(const elf_image& p_image,
+                         std::span<const arm_index_entry> p_index,
+                         std::span<const arm_index_entry* const> p_entries)
+{
+  const void* gcc_personality = find_gcc_personality(p_image);
+  const auto table = find_exception_table(p_image);
+
+  // Table entries are laid out back to back, each one ends where the next
+  // referenced entry (or the table) begins.
+  std::vector<const std::uint8_t*> table_entries;
+  for (const auto& entry : p_index) {
+    if (is_table_reference(entry)) {
+      table_entries.push_back(table_entry_of(entry));
+    }
+  }
+  std::ranges::sort(table_entries);
+
+  std::vector<cantunwind_rewrite> rewrites;
+  for (const auto* entry : p_entries) {
+    if (entry->content == cannot_unwind_token) {
+      continue;
+    }
+    rewrites.push_back(
+      { .index_entry = entry,
+        .table_entry =
+          is_table_reference(*entry) ? table_entry_of(*entry) : nullptr });
+  }
+
+  // Group rewrites sharing a table entry so each entry is counted once
+  std::ranges::sort(rewrites, {}, &cantunwind_rewrite::table_entry);
+  const auto* table_end = table.data() + table.size();
+
+  for (auto group = rewrites.begin(); group != rewrites.end();) {
+    const auto* table_entry = group->table_entry;
+    const auto group_end = std::ranges::find_if(
+      group, rewrites.end(), [table_entry](const cantunwind_rewrite& p_other) {
+        return p_other.table_entry != table_entry;
+      });
+    const auto [first, last] =
+      std::ranges::equal_range(table_entries, table_entry);
+    auto& owner = *group;
+    const bool all_references_rewritten = (group_end - group) == (last - first);
+    group = group_end;
+
+    // Leave the bytes of shared entries alone unless every user is rewritten.
+    // Without a known table region only the index entry is rewritten.
+    if (table_entry == nullptr || not all_references_rewritten ||
+        table_entry < table.data() || table_entry >= table_end) {
+      continue;
+    }
+    const auto* entry_end = (last != table_entries.end()) ? *last : table_end;
+    const auto entry_size = static_cast<std::size_t>(entry_end - table_entry);
+
+    // The decoded contents have to fit, otherwise the layout is not understood
+    const exception_info info(*owner.index_entry, gcc_personality);
+    if (decoded_size(info) > entry_size) {
+      continue;
+    }
+    owner.table_bytes = entry_size;
+  }
+
+  return rewrites;
+}
+
+void
+write_rewritten_copy(const elf_image& p_image,
+                     std::span<const cantunwind_rewrite> p_rewrites,
+                     const std::filesystem::path& p_input,
+                     const std::filesystem::path& p_output)
+{
+  static constexpr std::uint32_t token = cannot_unwind_token;
+  const auto token_bytes = std::as_bytes(std::span(&token, 1));
+  const std::vector<std::byte> zeros(
+    p_rewrites.empty()
+      ? 0
+      : std::ranges::max(p_rewrites, {}, &cantunwind_rewrite::table_bytes)
+          .table_bytes);
+
+  std::vector<image_patch> patches;
+  for (const auto& rewrite : p_rewrites) {
+    patches.push_back({ .location = &rewrite.index_entry->content,
+                        .bytes = token_bytes });
+    if (rewrite.table_bytes != 0) {
+      patches.push_back({ .location = rewrite.table_entry,
+                          .bytes = std::span(zeros).first(
+                            rewrite.table_bytes) });
+    }
+  }
+
+  write_patched_copy(p_image, patches, p_input, p_output);
+}
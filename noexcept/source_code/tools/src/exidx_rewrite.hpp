@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+
+// Rewrite exception index entries of a linked image to EXIDX_CANTUNWIND,
+// shared by the tools that prove functions never need to be unwound.
+
+struct cantunwind_rewrite
+{
+  const arm_index_entry* index_entry = nullptr;
+  /// Table entry referenced before the rewrite, nullptr for inline entries
+  const std::uint8_t* table_entry = nullptr;
+  /// Table bytes freed by this rewrite, 0 when still referenced elsewhere
+  std::size_t table_bytes = 0;
+};
+
+/**
+ * Work out which exception table entries are no longer referenced once
+ * p_entries are rewritten. A table entry only counts as freed if every index
+ * entry referencing it is rewritten and its decoded contents fit between it and
+ * the next referenced entry.
+ *
+ * @param p_image - image owning p_index
+ * @param p_index - complete exception index of p_image
+ * @param p_entries - entries of p_index to rewrite, entries that already are
+ * CANTUNWIND are skipped
+ * @return std::vector<cantunwind_rewrite> - one per rewritten entry, sorted by
+ * table entry
+ */
+std::vector<cantunwind_rewrite>
+plan_cantunwind_rewrites(const elf_image& p_image,
+                         std::span<const arm_index_entry> p_index,
+                         std::span<const arm_index_entry* const> p_entries);
+
+/**
+ * Copy p_input to p_output, unless they are the same file, then apply
+ * p_rewrites to the copy. Freed table bytes are zeroed. Nothing moves, so the
+ * copy keeps every address of the original.
+ *
+ * @throws std::runtime_error - if p_output cannot be written
+ */
+void
+write_rewritten_copy(const elf_image& p_image,
+                     std::span<const cantunwind_rewrite> p_rewrites,
+                     const std::filesystem::path& p_input,
+                     const std::filesystem::path& p_output);
@@ -0,0 +1,207 @@
+/**
+ * @file exidx_search_benchmark.cpp
+ * @brief Lookup cost of exidx_search_table against the unwinder's own search
+ *
+ * Builds synthetic exception indexes of growing size, with functions of
+ * random length, and times looking up random addresses in them with:
+ *
+ *   - stock: the bisection libgcc's unwinder performs over the prel31 index
+ *            (search_EIT_table in libgcc/config/arm/unwind-arm-common.inc)
+ *   - eytzinger: exidx_search_table from src/exidx_search.hpp
+ *
+ * Both searches must agree on every lookup. The host has caches and branch
+ * predictors a Cortex-M lacks, so the instructions column is the better guide
+ * to the cost on the device.
+ *
+ * Usage:
+ *
+ *     exidx_search_benchmark [output_directory]
+ *
+ * Writes exidx_search.csv with one row per index size.
+ */
+#include <cstdint>
+#include <cstdio>
+
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "csv_file.hpp"
+#include "exception_metadata.hpp"
+#include "exidx_search.hpp"
+#include "perf_counters.hpp"
+
+namespace {
+constexpr std::size_t largest_index = 1 << 20;
+constexpr std::size_t lookups = 1 << 20;
+
+using search_table = exidx_search_table<largest_index>;
+
+/// Copy of libgcc's search_EIT_table, which is static there
+[[gnu::noinline]] const arm_index_entry*
+stock_search(const arm_index_entry* p_table,
+             std::size_t p_count,
+             std::uintptr_t p_address)
+{
+  if (p_count == 0) {
+    return nullptr;
+  }
+
+  std::size_t left = 0;
+  std::size_t right = p_count - 1;
+  while (true) {
+    const auto middle = (left + right) / 2;
+    const auto function =
+      reinterpret_cast<std::uintptr_t>(get_function(p_table[middle]));
+    auto last_address = ~std::uintptr_t{ 0 };
+    if (middle != p_count - 1) {
+      last_address =
+        reinterpret_cast<std::uintptr_t>(get_function(p_table[middle + 1])) - 1;
+    }
+
+    if (p_address < function) {
+      if (middle == left) {
+        return nullptr;
+      }
+      right = middle - 1;
+    } else if (p_address <= last_address) {
+      return &p_table[middle];
+    } else {
+      left = middle + 1;
+    }
+  }
+}
+
+[[gnu::noinline]] const arm_index_entry*
+eytzinger_search(const search_table& p_table, std::uintptr_t p_address)
+{
+  return p_table.find(p_address);
+}
+
+/**
+ * Index entries for p_count functions placed one after another, starting
+ * right after the index itself so every prel31 offset is in range. Only the
+ * offsets matter, no function is ever read.
+ */
+std::vector<arm_index_entry>
+make_index(std::size_t p_count, std::mt19937& p_random)
+{
+  std::uniform_int_distribution<std::uintptr_t> function_size(4, 256);
+
+  std::vector<arm_index_entry> index(p_count);
+  auto address = reinterpret_cast<std::uintptr_t>(index.data() + p_count);
+  for (auto& entry : index) {
+    const auto offset =
+      address - reinterpret_cast<std::uintptr_t>(&entry.function);
+    entry.function = static_cast<std::uint32_t>(offset) & 0x7FFF'FFFF;
+    entry.content = cannot_unwind_token;
+    address += function_size(p_random) & ~std::uintptr_t{ 1 };
+  }
+  return index;
+}
+
+struct lookup_cost
+{
+  double nanoseconds = 0;
+  double instructions = 0;
+};
+
+template<typename Search>
+lookup_cost
+time_lookups(perf_counters& p_counters,
+             const std::vector<std::uintptr_t>& p_addresses,
+             std::vector<const arm_index_entry*>& p_results,
+             Search&& p_search)
+{
+  p_counters.start();
+  for (std::size_t i = 0; i < p_addresses.size(); i++) {
+    p_results[i] = p_search(p_addresses[i]);
+  }
+  const auto sample = p_counters.stop();
+  const double count = p_addresses.size();
+  return { .nanoseconds = sample.nanoseconds / count,
+           .instructions = sample.instructions / count };
+}
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  const std::filesystem::path output = argc > 1 ? argv[1] : ".";
+
+  try {
+    std::filesystem::create_directories(output);
+    auto csv = open_csv(output / "exidx_search.csv",
+                        "entries,stock_ns,eytzinger_ns,stock_instructions,"
+                        "eytzinger_instructions,speedup\n");
+
+    perf_counters counters;
+    std::mt19937 random(3313);
+    auto table = std::make_unique<search_table>();
+    std::vector<std::uintptr_t> addresses(lookups);
+    std::vector<const arm_index_entry*> stock_results(lookups);
+    std::vector<const arm_index_entry*> eytzinger_results(lookups);
+
+    for (std::size_t count = 16; count <= largest_index; count *= 4) {
+      const auto index = make_index(count, random);
+      table->build(index);
+
+      // Return addresses from anywhere in the covered functions
+      const auto first =
+        reinterpret_cast<std::uintptr_t>(get_function(index.front()));
+      const auto last =
+        reinterpret_cast<std::uintptr_t>(get_function(index.back()));
+      std::uniform_int_distribution<std::uintptr_t> address(first, last + 3);
+      for (auto& value : addresses) {
+        value = address(random);
+      }
+
+      // Each search runs once to warm up, then once measured
+      const auto stock_lookup = [&](std::uintptr_t p_address) {
+        return stock_search(index.data(), index.size(), p_address);
+      };
+      time_lookups(counters, addresses, stock_results, stock_lookup);
+      const auto stock =
+        time_lookups(counters, addresses, stock_results, stock_lookup);
+      const auto eytzinger_lookup = [&](std::uintptr_t p_address) {
+        return eytzinger_search(*table, p_address);
+      };
+      time_lookups(counters, addresses, eytzinger_results, eytzinger_lookup);
+      const auto eytzinger =
+        time_lookups(counters, addresses, eytzinger_results, eytzinger_lookup);
+
+      if (stock_results != eytzinger_results) {
+        std::fprintf(stderr,
+                     "exidx_search_benchmark: searches disagree for %zu "
+                     "entries\n",
+                     count);
+        return 1;
+      }
+
+      std::fprintf(csv.get(),
+                   "%zu,%.2f,%.2f,",
+                   count,
+                   stock.nanoseconds,
+                   eytzinger.nanoseconds);
+      if (counters.available()) {
+        std::fprintf(
+          csv.get(), "%.1f,%.1f,", stock.instructions, eytzinger.instructions);
+      } else {
+        std::fputs(",,", csv.get());
+      }
+      std::fprintf(
+        csv.get(), "%.2f\n", stock.nanoseconds / eytzinger.nanoseconds);
+      std::printf("%8zu entries: stock %6.2f ns, eytzinger %6.2f ns\n",
+                  count,
+                  stock.nanoseconds,
+                  eytzinger.nanoseconds);
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "exidx_search_benchmark: %s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
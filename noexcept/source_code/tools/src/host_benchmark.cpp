@@ -0,0 +1,306 @@
+/**
+ * @file host_benchmark.cpp
+ * @brief Happy path and throw path latency of every exhibit on the host
+ *
+ * The host counterpart of throw_benchmark.cpp. Every exhibit from exhibits.hpp
+ * is called with its throw trigger disarmed (happy path) and armed (throw
+ * path). Each measurement runs a batch of calls between two reads of the
+ * clock and of the hardware counters, repeated to get a distribution:
+ *
+ *   - the thread is pinned to the CPU it started on
+ *   - warm up batches run first and are discarded
+ *   - the median of the repetitions is reported along with the minimum and
+ *     the standard deviation of the time per call
+ *   - the cost of the harness itself, measured with an empty exhibit, is
+ *     subtracted from every column
+ *
+ * Exceptions that reach a noexcept boundary return to the harness from the
+ * terminate handler, as they do in throw_benchmark.cpp.
+ *
+ * Usage:
+ *
+ *     host_benchmark [output_directory] [repetitions]
+ *
+ * Writes host_latency.csv with one row per exhibit and path. Instructions and
+ * branch misses are left empty when perf_event_open(2) is unavailable.
+ */
+#include <sched.h>
+
+#include <cmath>
+#include <csetjmp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <numeric>
+#include <vector>
+
+#include <cxxabi.h>
+
+#include "csv_file.hpp"
+#include "exhibits.hpp"
+#include "perf_counters.hpp"
+
+namespace {
+enum class call_outcome : std::uint8_t
+{
+  /// The exhibit returned, either without throwing or after catching
+  returned,
+  /// The exception propagated out of the exhibit
+  caught,
+  /// The exception reached a noexcept boundary and std::terminate was called
+  terminated,
+};
+
+const char*
+to_string(call_outcome p_outcome)
+{
+  switch (p_outcome) {
+    case call_outcome::returned:
+      return "returned";
+    case call_outcome::caught:
+      return "caught";
+    case call_outcome::terminated:
+      return "terminate";
+  }
+  return "unknown";
+}
+
+struct batch_size
+{
+  std::uint32_t repetitions = 0;
+  std::uint32_t iterations = 0;
+};
+
+// Throwing costs microseconds, not nanoseconds, so it gets smaller batches
+constexpr std::uint32_t warm_up_batches = 3;
+constexpr std::uint32_t default_repetitions = 31;
+constexpr std::uint32_t happy_path_iterations = 2000;
+constexpr std::uint32_t throw_path_iterations = 200;
+
+/// Per call statistics of the repetitions of one measurement
+struct statistics
+{
+  double nanoseconds = 0;
+  double minimum_nanoseconds = 0;
+  double stddev_nanoseconds = 0;
+  double instructions = 0;
+  double branch_misses = 0;
+  call_outcome outcome = call_outcome::returned;
+};
+
+std::jmp_buf terminate_jump{};
+
+[[noreturn]] void
+return_from_terminate()
+{
+  std::longjmp(terminate_jump, 1);
+}
+
+/**
+ * Arm p_trigger and call the exhibit once. Arming happens for the happy path
+ * too, so both paths and the baseline run the same harness code.
+ */
+[[gnu::noinline]] call_outcome
+call_once(const exhibit& p_exhibit, throw_trigger p_trigger)
+{
+  volatile call_outcome outcome = call_outcome::returned;
+  arm_trigger(p_trigger);
+
+  if (setjmp(terminate_jump) == 0) {
+    try {
+      p_exhibit.run();
+    } catch (...) {
+      outcome = call_outcome::caught;
+    }
+  } else {
+    outcome = call_outcome::terminated;
+    // libsupc++ begins catching the exception before calling terminate,
+    // finish catching it so the exception object is released.
+    __cxxabiv1::__cxa_end_catch();
+  }
+
+  return outcome;
+}
+
+double
+median(std::vector<double> p_values)
+{
+  const auto middle = p_values.begin() + p_values.size() / 2;
+  std::ranges::nth_element(p_values, middle);
+  return *middle;
+}
+
+statistics
+measure(perf_counters& p_counters,
+        const exhibit& p_exhibit,
+        throw_trigger p_trigger,
+        batch_size p_size)
+{
+  std::vector<double> nanoseconds;
+  std::vector<double> instructions;
+  std::vector<double> branch_misses;
+  nanoseconds.reserve(p_size.repetitions);
+  instructions.reserve(p_size.repetitions);
+  branch_misses.reserve(p_size.repetitions);
+
+  statistics result{};
+  const double iterations = p_size.iterations;
+  for (std::uint32_t batch = 0; batch < warm_up_batches + p_size.repetitions;
+       batch++) {
+    p_counters.start();
+    for (std::uint32_t i = 0; i < p_size.iterations; i++) {
+      result.outcome = call_once(p_exhibit, p_trigger);
+    }
+    const auto sample = p_counters.stop();
+
+    if (batch >= warm_up_batches) {
+      nanoseconds.push_back(sample.nanoseconds / iterations);
+      instructions.push_back(sample.instructions / iterations);
+      branch_misses.push_back(sample.branch_misses / iterations);
+    }
+  }
+  disarm_triggers();
+
+  const double mean =
+    std::accumulate(nanoseconds.begin(), nanoseconds.end(), 0.0) /
+    nanoseconds.size();
+  double squares = 0;
+  for (const auto value : nanoseconds) {
+    squares += (value - mean) * (value - mean);
+  }
+
+  result.nanoseconds = median(nanoseconds);
+  result.minimum_nanoseconds = std::ranges::min(nanoseconds);
+  result.stddev_nanoseconds = std::sqrt(squares / nanoseconds.size());
+  result.instructions = median(instructions);
+  result.branch_misses = median(branch_misses);
+  return result;
+}
+
+/// Remove the cost of the harness measured by p_baseline
+statistics
+subtract(statistics p_measured, const statistics& p_baseline)
+{
+  p_measured.nanoseconds =
+    std::max(0.0, p_measured.nanoseconds - p_baseline.nanoseconds);
+  p_measured.minimum_nanoseconds = std::max(
+    0.0, p_measured.minimum_nanoseconds - p_baseline.minimum_nanoseconds);
+  p_measured.instructions =
+    std::max(0.0, p_measured.instructions - p_baseline.instructions);
+  p_measured.branch_misses =
+    std::max(0.0, p_measured.branch_misses - p_baseline.branch_misses);
+  return p_measured;
+}
+
+/// Keep the scheduler from migrating the benchmark between measurements
+void
+pin_to_current_cpu()
+{
+  const int cpu = ::sched_getcpu();
+  if (cpu < 0) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  ::sched_setaffinity(0, sizeof(set), &set);
+}
+
+void
+write_row(std::FILE* p_csv,
+          bool p_has_counters,
+          const exhibit& p_exhibit,
+          const char* p_path,
+          const statistics& p_result,
+          batch_size p_size)
+{
+  std::fprintf(p_csv,
+               "%u,%s,%s,%s,%s,%s,%.2f,%.2f,%.2f,",
+               p_exhibit.number,
+               p_exhibit.name,
+               p_exhibit.is_noexcept ? "True" : "False",
+               to_string(p_exhibit.trigger),
+               p_path,
+               to_string(p_result.outcome),
+               p_result.nanoseconds,
+               p_result.minimum_nanoseconds,
+               p_result.stddev_nanoseconds);
+  if (p_has_counters) {
+    std::fprintf(
+      p_csv, "%.2f,%.3f,", p_result.instructions, p_result.branch_misses);
+  } else {
+    std::fputs(",,", p_csv);
+  }
+  std::fprintf(p_csv, "%u,%u\n", p_size.repetitions, p_size.iterations);
+}
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  const std::filesystem::path output = argc > 1 ? argv[1] : ".";
+  const std::uint32_t repetitions =
+    argc > 2 ? std::strtoul(argv[2], nullptr, 10) : default_repetitions;
+  if (repetitions == 0) {
+    std::fprintf(
+      stderr, "usage: %s [output_directory] [repetitions]\n", argv[0]);
+    return 1;
+  }
+
+  try {
+    std::filesystem::create_directories(output);
+    pin_to_current_cpu();
+    std::set_terminate(return_from_terminate);
+
+    perf_counters counters;
+    if (not counters.available()) {
+      std::fprintf(stderr,
+                   "host_benchmark: hardware counters unavailable, only "
+                   "measuring time\n");
+    }
+
+    const batch_size happy_size{ repetitions, happy_path_iterations };
+    const batch_size throw_size{ repetitions, throw_path_iterations };
+    const exhibit empty{
+      .number = 0, .name = "", .is_noexcept = true, .trigger = {}, .run = [] {}
+    };
+    const auto happy_baseline =
+      measure(counters, empty, throw_trigger::none, happy_size);
+    const auto throw_baseline =
+      measure(counters, empty, throw_trigger::none, throw_size);
+
+    auto csv = open_csv(output / "host_latency.csv",
+                        "exhibit,function,noexcept,trigger,path,outcome,"
+                        "ns_per_op,ns_min,ns_stddev,instructions,"
+                        "branch_misses,repetitions,iterations\n");
+
+    for (const auto& entry : exhibits()) {
+      const auto happy = subtract(
+        measure(counters, entry, throw_trigger::none, happy_size),
+        happy_baseline);
+      write_row(
+        csv.get(), counters.available(), entry, "happy", happy, happy_size);
+      std::printf("%-42s happy %9.2f ns", entry.name, happy.nanoseconds);
+
+      if (entry.trigger != throw_trigger::none) {
+        const auto thrown = subtract(
+          measure(counters, entry, entry.trigger, throw_size), throw_baseline);
+        write_row(
+          csv.get(), counters.available(), entry, "throw", thrown, throw_size);
+        std::printf("  throw %9.2f ns (%s)",
+                    thrown.nanoseconds,
+                    to_string(thrown.outcome));
+      }
+      std::printf("\n");
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "host_benchmark: %s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
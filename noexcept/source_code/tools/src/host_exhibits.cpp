@@ -0,0 +1,28 @@
+/**
+ * @file host_exhibits.cpp
+ * @brief The exhibits of except_vs_noexcept.cpp and dtor_paths.cpp built for
+ * the host
+ *
+ * Links every exhibit the same way app.elf does so exception_analyzer can
+ * compare the DWARF metadata of the host against the ARM exception tables:
+ *
+ *     exception_analyzer host_exhibits csv/x86_64
+ *
+ */
+#include "dtor_paths.hpp"
+#include "except_vs_noexcept.hpp"
+#include "external.hpp"
+
+int
+main()
+{
+  link_in_except_vs_noexcept();
+
+  try {
+    dtor::link_in_dtor_paths();
+  } catch (const dtor::action_exception_t&) {
+    side_effect[17] = side_effect[17] + 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include "instruction_bounds.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <span>
+
+#include "landing_pads.hpp"
+#include "thumb2.hpp"
+
+instruction_bounds::instruction_bounds(const elf_image& p_image,
+                                       const call_graph& p_graph)
+  : m_image(p_image)
+  , m_graph(p_graph)
+  , m_noreturn(find_noreturn_routines(p_image))
+  , m_states(p_graph.nodes.size(), state::unknown)
+  , m_bounds(p_graph.nodes.size(), 0)
+{
+}
+
+std::optional<std::uint32_t>
+instruction_bounds::function(std::size_t p_node)
+{
+  switch (m_states[p_node]) {
+    case state::bounded:
+      return m_bounds[p_node];
+    case state::active: // recursion
+    case state::unbounded:
+      return std::nullopt;
+    case state::unknown:
+      break;
+  }
+
+  m_states[p_node] = state::active;
+  const auto bound = from(p_node, m_graph.nodes[p_node].address);
+  m_states[p_node] = bound ? state::bounded : state::unbounded;
+  m_bounds[p_node] = bound.value_or(0);
+  return bound;
+}
+
+std::optional<std::uint32_t>
+instruction_bounds::from(std::size_t p_node, std::uint32_t p_address)
+{
+  const auto& node = m_graph.nodes[p_node];
+  const auto* host = m_image.to_host(node.address);
+  const auto start = p_address & ~1U;
+  if (not node.decoded || host == nullptr ||
+      not m_image.contains(host, node.size) ||
+      start - node.address >= node.size) {
+    return std::nullopt;
+  }
+  const std::span<const std::uint8_t> code(host, node.size);
+
+  auto halfword_at = [&code](std::size_t p_offset) -> std::uint16_t {
+    return code[p_offset] | (code[p_offset + 1] << 8);
+  };
+
+  std::vector<bool> reached(code.size() / 2, false);
+  std::vector<std::uint32_t> pending{ start };
+  std::vector<std::size_t> callees;
+  std::uint32_t instructions = 0;
+
+  while (not pending.empty()) {
+    std::size_t offset = pending.back() - node.address;
+    pending.pop_back();
+    // Instructions left in the IT block, branches never enter one
+    std::uint32_t conditional_left = 0;
+
+    while (offset + 2 <= code.size() && not reached[offset / 2]) {
+      const auto first = halfword_at(offset);
+      const bool wide = is_wide_instruction(first);
+      if (wide && offset + 4 > code.size()) {
+        return std::nullopt;
+      }
+      const auto second = wide ? halfword_at(offset + 2) : std::uint16_t{ 0 };
+      const auto address = static_cast<std::uint32_t>(node.address + offset);
+
+      reached[offset / 2] = true;
+      instructions++;
+      offset += wide ? 4 : 2;
+
+      const bool in_it_block = conditional_left != 0;
+      conditional_left =
+        in_it_block ? conditional_left - 1 : it_block_length(first);
+
+      // UDF, used for __builtin_trap
+      bool ends = not wide && (first & 0xFF00) == 0xDE00;
+      if (is_return(first, second)) {
+        ends = true;
+      } else if (is_table_branch(first, second)) {
+        return std::nullopt;
+      } else if (const auto found = decode_branch(address, first, second)) {
+        const bool inside = found->target - node.address < code.size();
+        const auto* callee = m_graph.find(found->target);
+        const bool noreturn =
+          std::ranges::binary_search(m_noreturn, found->target);
+
+        switch (found->kind) {
+          case branch_kind::jump:
+            if (inside) {
+              if (found->target <= address) {
+                return std::nullopt; // a loop
+              }
+              pending.push_back(found->target);
+            } else if (noreturn) {
+              // Tail call that leaves the path
+            } else if (callee != nullptr) {
+              callees.push_back(callee - m_graph.nodes.data());
+            } else {
+              return std::nullopt;
+            }
+            ends = not found->conditional;
+            break;
+          case branch_kind::call:
+            if (noreturn) {
+              ends = true;
+            } else if (callee != nullptr) {
+              callees.push_back(callee - m_graph.nodes.data());
+            } else {
+              return std::nullopt;
+            }
+            break;
+          case branch_kind::indirect_call:
+          case branch_kind::indirect_jump:
+            return std::nullopt;
+        }
+      }
+
+      if (ends && not in_it_block) {
+        break;
+      }
+    }
+  }
+
+  // Every reached call runs at most once, like the instructions around it
+  for (const auto callee : callees) {
+    const auto bound = function(callee);
+    if (not bound) {
+      return std::nullopt;
+    }
+    instructions += *bound;
+  }
+  return instructions;
+}
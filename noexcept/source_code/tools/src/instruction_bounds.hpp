@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <optional>
+#include <vector>
+
+#include "call_graph.hpp"
+#include "elf_image.hpp"
+
+// Upper bounds on the instructions executed by Thumb code without loops. Every
+// jump within a function has to go forward, so no instruction runs twice per
+// call and the instructions reachable from the start bound any one execution.
+// Calls add the bound of their callee, calls to the routines that never
+// return to a landing pad end the path. Backward jumps, recursion, table
+// branches and branches through registers leave the code unbounded.
+
+class instruction_bounds
+{
+public:
+  /**
+   * @param p_image - image p_graph was built from
+   * @param p_graph - call graph of p_image, must outlive the bounds
+   */
+  instruction_bounds(const elf_image& p_image, const call_graph& p_graph);
+
+  /**
+   * @return std::optional<std::uint32_t> - instructions one call to p_node
+   * executes at most, including its callees, std::nullopt if unbounded
+   */
+  std::optional<std::uint32_t>
+  function(std::size_t p_node);
+
+  /**
+   * @param p_node - function containing p_address
+   * @param p_address - where execution starts, such as a landing pad. The
+   * Thumb bit is ignored.
+   * @return std::optional<std::uint32_t> - instructions executed from
+   * p_address until p_node returns or calls a routine that does not return,
+   * std::nullopt if unbounded
+   */
+  std::optional<std::uint32_t>
+  from(std::size_t p_node, std::uint32_t p_address);
+
+private:
+  enum class state : std::uint8_t
+  {
+    unknown,
+    active,
+    bounded,
+    unbounded,
+  };
+
+  const elf_image& m_image;
+  const call_graph& m_graph;
+  /// Sorted, see find_noreturn_routines()
+  std::vector<std::uint32_t> m_noreturn;
+  std::vector<state> m_states;
+  std::vector<std::uint32_t> m_bounds;
+};
@@ -0,0 +1,144 @@
+#include "landing_pads.hpp"
+
+#include <elf.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+#include "thumb2.hpp"
+
+namespace {
+/// Routines called at the end of a landing pad, or instead of returning to it
+constexpr std::array<std::string_view, 8> noreturn_routines{
+  "__cxa_end_cleanup",
+  "_Unwind_Resume",
+  "__cxa_throw",
+  "__cxa_rethrow",
+  "__cxa_call_unexpected",
+  "__cxa_call_terminate",
+  "_ZSt9terminatev",
+  "abort",
+};
+
+/**
+ * @return std::vector<bool> - one flag per halfword of p_code, set for the
+ * halfwords of every instruction reached from p_starts
+ */
+std::vector<bool>
+reach(std::span<const std::uint8_t> p_code,
+      std::uint32_t p_address,
+      std::span<const std::uint32_t> p_starts,
+      std::span<const std::uint32_t> p_noreturn)
+{
+  auto halfword_at = [&p_code](std::size_t p_offset) -> std::uint16_t {
+    return p_code[p_offset] | (p_code[p_offset + 1] << 8);
+  };
+
+  std::vector<bool> reached(p_code.size() / 2, false);
+  std::vector<std::uint32_t> pending(p_starts.begin(), p_starts.end());
+
+  while (not pending.empty()) {
+    std::size_t offset = pending.back() - p_address;
+    pending.pop_back();
+    // Instructions left in the IT block, branches never enter one
+    std::uint32_t conditional_left = 0;
+
+    while (offset + 2 <= p_code.size() && not reached[offset / 2]) {
+      const auto first = halfword_at(offset);
+      const bool wide = is_wide_instruction(first);
+      if (wide && offset + 4 > p_code.size()) {
+        break;
+      }
+      const auto second = wide ? halfword_at(offset + 2) : std::uint16_t{ 0 };
+      const auto address = static_cast<std::uint32_t>(p_address + offset);
+
+      reached[offset / 2] = true;
+      if (wide) {
+        reached[(offset / 2) + 1] = true;
+      }
+      offset += wide ? 4 : 2;
+
+      const bool in_it_block = conditional_left != 0;
+      conditional_left =
+        in_it_block ? conditional_left - 1 : it_block_length(first);
+
+      // UDF, used for __builtin_trap
+      bool ends = not wide && (first & 0xFF00) == 0xDE00;
+      if (is_return(first, second) || is_table_branch(first, second)) {
+        ends = true;
+      } else if (const auto found = decode_branch(address, first, second)) {
+        switch (found->kind) {
+          case branch_kind::jump:
+            if (found->target - p_address < p_code.size()) {
+              pending.push_back(found->target);
+            }
+            ends = not found->conditional;
+            break;
+          case branch_kind::call:
+            ends = std::ranges::binary_search(p_noreturn, found->target);
+            break;
+          case branch_kind::indirect_jump:
+            ends = true;
+            break;
+          case branch_kind::indirect_call:
+            break;
+        }
+      }
+
+      if (ends && not in_it_block) {
+        break;
+      }
+    }
+  }
+
+  return reached;
+}
+} // namespace
+
+std::vector<std::uint32_t>
+find_noreturn_routines(const elf_image& p_image)
+{
+  std::vector<std::uint32_t> addresses;
+  for (const auto name : noreturn_routines) {
+    if (const auto* symbol = p_image.find_symbol(name);
+        symbol != nullptr && symbol->st_shndx != SHN_UNDEF) {
+      // clear least significant bit produced by ARM function call ABI
+      addresses.push_back(symbol->st_value & ~1U);
+    }
+  }
+  std::ranges::sort(addresses);
+  return addresses;
+}
+
+std::uint32_t
+measure_landing_pad_code(std::span<const std::uint8_t> p_code,
+                         std::uint32_t p_address,
+                         std::span<const std::uint32_t> p_landing_pads,
+                         std::span<const std::uint32_t> p_noreturn)
+{
+  std::vector<std::uint32_t> pads;
+  for (const auto pad : p_landing_pads) {
+    if (pad - p_address < p_code.size()) {
+      pads.push_back(pad & ~1U);
+    }
+  }
+  if (pads.empty()) {
+    return 0;
+  }
+
+  const std::array<std::uint32_t, 1> entry{ p_address };
+  const auto normal = reach(p_code, p_address, entry, p_noreturn);
+  const auto exceptional = reach(p_code, p_address, pads, p_noreturn);
+
+  std::uint32_t bytes = 0;
+  for (std::size_t i = 0; i < normal.size(); i++) {
+    if (exceptional[i] && not normal[i]) {
+      bytes += 2;
+    }
+  }
+  return bytes;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+#include <vector>
+
+#include "elf_image.hpp"
+
+// Code that only runs while an exception propagates: the landing pads named by
+// the call site records of an LSDA and whatever can be reached from them, but
+// not from the start of the function.
+
+/**
+ * @return std::vector<std::uint32_t> - sorted addresses of the routines in
+ * p_image that never return to a landing pad, such as __cxa_end_cleanup and
+ * _Unwind_Resume
+ */
+std::vector<std::uint32_t>
+find_noreturn_routines(const elf_image& p_image);
+
+/**
+ * Follow the Thumb code of a function from its start and from its landing
+ * pads. Jumps within p_code are followed, calls fall through unless they call
+ * one of p_noreturn, returns, table branches and jumps through registers end
+ * the path. Jumps leaving p_code are tail calls.
+ *
+ * @param p_code - instructions of the function
+ * @param p_address - address of p_code[0], the start of the function
+ * @param p_landing_pads - landing pad addresses, those outside of p_code are
+ * ignored
+ * @param p_noreturn - sorted addresses returned by find_noreturn_routines()
+ * @return std::uint32_t - bytes reached from a landing pad but never from the
+ * start of the function
+ */
+std::uint32_t
+measure_landing_pad_code(std::span<const std::uint8_t> p_code,
+                         std::uint32_t p_address,
+                         std::span<const std::uint32_t> p_landing_pads,
+                         std::span<const std::uint32_t> p_noreturn);
@@ -0,0 +1,323 @@
+/**
+ * @file link_order.cpp
+ * @brief Order functions so identical exception index entries become adjacent
+ *
+ * The linker merges neighbouring exception index entries whose content is the
+ * same inline value, such as EXIDX_CANTUNWIND or the same compact unwind
+ * instructions. This tool clusters the functions of a linked image by that
+ * content and writes a link order that places each cluster contiguously:
+ *
+ *   - function_order.ld  input section list for the `.text` output section,
+ *                        picked up by the INCLUDE in standard_arm.ld
+ *   - function_order.txt the same order as symbols, for --symbol-ordering-file
+ *   - exidx_clusters.csv every cluster with its entries before and after
+ *
+ * The input section of every function comes from the GNU ld map of the image,
+ * so `.text.startup.*`, `.text.unlikely.*` and `.text.hot.*` are listed by
+ * their real names. Only a function alone at the start of a uniquely named
+ * `.text.*` section can be placed. The rest, such as the libgcc helpers in
+ * plain `.text`, stay where the linker puts them and are counted there.
+ *
+ * Entries pointing into the exception table are never identical, functions
+ * using them keep their relative order after the clusters.
+ *
+ * Usage:
+ *
+ *     link_order app.elf [output_directory [app.elf.map]]
+ *
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_file.hpp"
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+#include "exception_tables.hpp"
+#include "linker_map.hpp"
+
+namespace {
+struct placed_function
+{
+  const std::uint8_t* address = nullptr;
+  std::string_view symbol;
+  /// Input section the script places, nullptr if the function cannot move
+  const map_input_section* section = nullptr;
+  /// Content of the index entry covering the function, when it can be merged
+  std::optional<std::uint32_t> mergeable_content;
+  bool has_own_entry = false;
+};
+
+struct cluster
+{
+  std::uint32_t content = 0;
+  std::vector<const placed_function*> functions;
+  std::size_t entries_before = 0;
+};
+
+bool
+is_mergeable(std::uint32_t p_content)
+{
+  return p_content == cannot_unwind_token || (p_content & is_personality_data);
+}
+
+/**
+ * Pair every function with the index entry covering it. Aliases are reduced
+ * to their first symbol since they share a section.
+ */
+std::vector<placed_function>
+place_functions(const std::vector<function_symbol>& p_functions,
+                std::span<const arm_index_entry> p_index)
+{
+  std::vector<placed_function> placed;
+  auto entry = p_index.begin();
+  const void* previous_address = nullptr;
+
+  for (const auto& function : p_functions) {
+    if (function.address == previous_address) {
+      continue;
+    }
+    previous_address = function.address;
+
+    while (entry != p_index.end() && std::next(entry) != p_index.end() &&
+           get_function(*std::next(entry)) <= function.address) {
+      entry++;
+    }
+
+    placed_function result{ .address = function.address,
+                            .symbol = function.symbol };
+    if (entry != p_index.end() && get_function(*entry) <= function.address) {
+      result.has_own_entry = get_function(*entry) == function.address;
+      if (is_mergeable(entry->content)) {
+        result.mergeable_content = entry->content;
+      }
+    }
+    placed.push_back(result);
+  }
+
+  return placed;
+}
+
+/**
+ * Give every function that can be moved on its own the input section holding
+ * it. A section is only usable when it starts at the function, holds no other
+ * function and its name matches no other section of the link.
+ */
+void
+assign_sections(const elf_image& p_image,
+                std::span<placed_function> p_placed,
+                std::span<const map_input_section> p_sections)
+{
+  std::map<std::string_view, std::size_t> name_count;
+  std::vector<const map_input_section*> code;
+  for (const auto& section : p_sections) {
+    name_count[section.name]++;
+    if (section.name.starts_with(".text.")) {
+      code.push_back(&section);
+    }
+  }
+  std::ranges::sort(code, {}, &map_input_section::address);
+
+  std::vector<const map_input_section*> containing(p_placed.size());
+  std::map<const map_input_section*, std::size_t> functions_in;
+  for (std::size_t i = 0; i < p_placed.size(); i++) {
+    const auto address = p_image.to_target(p_placed[i].address);
+    auto after = std::ranges::upper_bound(
+      code, address, {}, &map_input_section::address);
+    if (after == code.begin()) {
+      continue;
+    }
+    const auto* section = *std::prev(after);
+    if (address < section->address + section->size) {
+      containing[i] = section;
+      functions_in[section]++;
+    }
+  }
+
+  for (std::size_t i = 0; i < p_placed.size(); i++) {
+    const auto* section = containing[i];
+    if (section != nullptr &&
+        section->address == p_image.to_target(p_placed[i].address) &&
+        functions_in[section] == 1 && name_count[section->name] == 1) {
+      p_placed[i].section = section;
+    }
+  }
+}
+
+/// Number of index entries needed for p_order once identical neighbours merge
+std::size_t
+count_entries(std::span<const placed_function* const> p_order)
+{
+  std::size_t entries = 0;
+  std::optional<std::uint32_t> previous;
+  for (const auto* function : p_order) {
+    if (not function->mergeable_content) {
+      // Only functions with an entry of their own add one to the table
+      entries += function->has_own_entry ? 1 : 0;
+    } else if (function->mergeable_content != previous) {
+      entries++;
+    }
+    previous = function->mergeable_content;
+  }
+  return entries;
+}
+
+void
+write_function(std::FILE* p_script,
+               std::FILE* p_symbols,
+               const placed_function& p_function)
+{
+  const auto length = static_cast<int>(p_function.symbol.size());
+  std::fprintf(p_script, "*(%s)\n", p_function.section->name.c_str());
+  std::fprintf(p_symbols, "%.*s\n", length, p_function.symbol.data());
+}
+
+void
+write_order(const std::filesystem::path& p_output,
+            const char* p_elf_path,
+            std::span<const cluster> p_clusters,
+            std::span<const placed_function* const> p_remaining)
+{
+  auto script = create_output_file(p_output / "function_order.ld");
+  auto symbols = create_output_file(p_output / "function_order.txt");
+  std::fprintf(script.get(),
+               "/* Generated by link_order from %s, regenerate instead of "
+               "editing */\n",
+               p_elf_path);
+
+  for (const auto& cluster : p_clusters) {
+    std::fprintf(script.get(),
+                 "/* exidx 0x%08" PRIx32 ": %zu functions */\n",
+                 cluster.content,
+                 cluster.functions.size());
+    for (const auto* function : cluster.functions) {
+      write_function(script.get(), symbols.get(), *function);
+    }
+  }
+
+  std::fprintf(script.get(), "/* exception table entries */\n");
+  for (const auto* function : p_remaining) {
+    write_function(script.get(), symbols.get(), *function);
+  }
+}
+
+void
+order(const char* p_elf_path,
+      const std::filesystem::path& p_output,
+      const std::filesystem::path& p_map_path)
+{
+  const elf_image image(p_elf_path);
+  const auto index = find_exception_index(image);
+  if (index.empty()) {
+    throw std::runtime_error("image has no exception index");
+  }
+
+  const auto functions = collect_functions(image);
+  const auto sections = read_input_sections(p_map_path);
+  auto placed = place_functions(functions, index);
+  assign_sections(image, placed, sections);
+
+  // Clusters are ordered by the first appearance of their content, so the
+  // most common case, CANTUNWIND, usually leads.
+  std::vector<cluster> clusters;
+  std::map<std::uint32_t, std::size_t> cluster_of_content;
+  std::vector<const placed_function*> remaining;
+  std::vector<const placed_function*> fixed;
+  for (const auto& function : placed) {
+    if (function.section == nullptr) {
+      fixed.push_back(&function);
+      continue;
+    }
+    if (not function.mergeable_content) {
+      remaining.push_back(&function);
+      continue;
+    }
+    const auto content = *function.mergeable_content;
+    auto [position, inserted] =
+      cluster_of_content.try_emplace(content, clusters.size());
+    if (inserted) {
+      clusters.push_back({ .content = content });
+    }
+    auto& destination = clusters[position->second];
+    destination.functions.push_back(&function);
+    destination.entries_before += function.has_own_entry ? 1 : 0;
+  }
+
+  // The script places its sections first, the linker appends the fixed
+  // functions behind them in their original order
+  std::vector<const placed_function*> new_order;
+  for (const auto& cluster : clusters) {
+    new_order.insert(
+      new_order.end(), cluster.functions.begin(), cluster.functions.end());
+  }
+  new_order.insert(new_order.end(), remaining.begin(), remaining.end());
+  new_order.insert(new_order.end(), fixed.begin(), fixed.end());
+
+  std::filesystem::create_directories(p_output);
+  write_order(p_output, p_elf_path, clusters, remaining);
+
+  auto csv = open_csv(p_output / "exidx_clusters.csv",
+                      "content,functions,entries_before,entries_after\n");
+  for (const auto& cluster : clusters) {
+    std::fprintf(csv.get(),
+                 "0x%08" PRIx32 ",%zu,%zu,1\n",
+                 cluster.content,
+                 cluster.functions.size(),
+                 cluster.entries_before);
+  }
+
+  // Entries that do not start at a function symbol are left where they are
+  const auto unattributed =
+    std::ranges::count_if(index, [&functions](const auto& p_entry) {
+      const auto* address =
+        static_cast<const std::uint8_t*>(get_function(p_entry));
+      return not std::ranges::binary_search(
+        functions, address, {}, &function_symbol::address);
+    });
+  const auto before = index.size();
+  const auto after = count_entries(new_order) + unattributed;
+  std::printf("%zu of %zu functions have an input section of their own, "
+              "the rest keep their place\n",
+              placed.size() - fixed.size(),
+              placed.size());
+  std::printf("exception index: %zu entries (%zu bytes) before, %zu entries "
+              "(%zu bytes) after relinking with function_order.ld\n",
+              before,
+              before * sizeof(arm_index_entry),
+              after,
+              after * sizeof(arm_index_entry));
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  if (p_argc < 2 || p_argc > 4) {
+    std::fprintf(stderr,
+                 "usage: %s <app.elf> [output_directory [app.elf.map]]\n",
+                 p_argv[0]);
+    return 1;
+  }
+
+  try {
+    // Every image is linked with -Wl,-Map=<image>.map
+    const auto map_path =
+      p_argc == 4 ? std::string(p_argv[3]) : std::string(p_argv[1]) + ".map";
+    order(p_argv[1], p_argc >= 3 ? p_argv[2] : ".", map_path);
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", p_argv[1], p_error.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "linker_map.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+std::vector<std::string_view>
+split_words(std::string_view p_line)
+{
+  std::vector<std::string_view> words;
+  while (true) {
+    const auto start = p_line.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+      return words;
+    }
+    p_line.remove_prefix(start);
+    const auto end = std::min(p_line.find_first_of(" \t"), p_line.size());
+    words.push_back(p_line.substr(0, end));
+    p_line.remove_prefix(end);
+  }
+}
+
+std::optional<std::uint64_t>
+parse_hex(std::string_view p_word)
+{
+  if (not p_word.starts_with("0x")) {
+    return std::nullopt;
+  }
+  std::uint64_t value = 0;
+  const auto* end = p_word.data() + p_word.size();
+  const auto [last, error] = std::from_chars(p_word.data() + 2, end, value, 16);
+  if (error != std::errc{} || last != end) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/// Add the section if the words after its name are its address and size
+void
+add_placed(std::vector<map_input_section>& p_sections,
+           std::string_view p_name,
+           std::span<const std::string_view> p_placement)
+{
+  if (p_placement.size() < 2) {
+    return;
+  }
+  const auto address = parse_hex(p_placement[0]);
+  const auto size = parse_hex(p_placement[1]);
+  if (address && size && *size != 0) {
+    p_sections.push_back(
+      { .name = std::string(p_name), .address = *address, .size = *size });
+  }
+}
+} // namespace
+
+std::vector<map_input_section>
+read_input_sections(const std::filesystem::path& p_path)
+{
+  std::ifstream file(p_path);
+  if (not file) {
+    throw std::runtime_error("unable to read " + p_path.string());
+  }
+
+  std::string line;
+  bool found_memory_map = false;
+  while (std::getline(file, line)) {
+    if (line.starts_with("Linker script and memory map")) {
+      found_memory_map = true;
+      break;
+    }
+  }
+  if (not found_memory_map) {
+    throw std::runtime_error(p_path.string() + " is not a GNU ld map file");
+  }
+
+  // Input sections are indented by one space. A name too long for its column
+  // has its address and size on the following line.
+  std::vector<map_input_section> sections;
+  std::string pending;
+  while (std::getline(file, line)) {
+    const auto words = split_words(line);
+    const bool is_input = line.starts_with(' ') && not line.starts_with("  ");
+    if (words.empty() || not is_input) {
+      if (not pending.empty() && line.starts_with("  ")) {
+        add_placed(sections, pending, words);
+      }
+      pending.clear();
+      continue;
+    }
+
+    pending.clear();
+    // Skip padding and the input section patterns of the script
+    if (words[0].starts_with('*')) {
+      continue;
+    }
+    if (words.size() == 1) {
+      pending = words[0];
+      continue;
+    }
+    add_placed(sections, words[0], std::span(words).subspan(1));
+  }
+
+  return sections;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Read the input sections out of a GNU ld map file (-Wl,-Map), the same
+// listing tools/footprint_report.py parses.
+
+struct map_input_section
+{
+  /// Section name as the linker script matches it, e.g. `.text.startup.main`
+  std::string name;
+  std::uint64_t address = 0;
+  std::uint64_t size = 0;
+};
+
+/**
+ * @param p_path - map file written by GNU ld
+ * @return std::vector<map_input_section> - every placed input section with a
+ * size, in the order of the map.
+ * @throws std::runtime_error - if the file cannot be read or has no memory map
+ */
+std::vector<map_input_section>
+read_input_sections(const std::filesystem::path& p_path);
@@ -0,0 +1,395 @@
+/**
+ * @file noexcept_deducer.cpp
+ * @brief Deduce noexcept over the whole program's call graph
+ *
+ * An exception can only pass through a function if something the function
+ * calls lets one escape. Starting from the routines that raise exceptions,
+ * this tool walks the call graph backwards and marks every function that an
+ * exception can propagate through. Everything else is never unwound, its
+ * exception index entry is dead weight and is rewritten to EXIDX_CANTUNWIND,
+ * as if the function had been declared noexcept.
+ *
+ * An exception propagates out of a function if the function
+ *
+ *   - is __cxa_throw, __cxa_rethrow or one of the _Unwind_* raise routines,
+ *   - calls through a register, a veneer or anything else that is not a known
+ *     function, or has no size to decode, or
+ *   - calls a function that an exception propagates out of,
+ *
+ * unless its index entry already stops the unwinder: EXIDX_CANTUNWIND, an
+ * empty GCC LSDA or no entry at all. Routines of the C++ runtime that only
+ * continue an exception already in flight (__cxa_end_cleanup, _Unwind_Resume)
+ * or end it (__cxa_end_catch, std::terminate) do not start a new one.
+ *
+ * The call graph is decoded from the `bl`, `b` and `b.w` instructions of the
+ * image. GCC -fcallgraph-info files can be passed in addition, their edges and
+ * indirect calls are added on top.
+ *
+ * Outputs:
+ *
+ *   - noexcept_deduction.csv every function, whether an exception can
+ *                            propagate out of it and why, and what was
+ *                            rewritten
+ *   - the rewritten image, addresses unchanged
+ *
+ * Usage:
+ *
+ *     noexcept_deducer app.elf deduced.elf [report_directory] [file.ci ...]
+ *
+ */
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "call_graph.hpp"
+#include "csv_file.hpp"
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+#include "exception_tables.hpp"
+#include "exidx_rewrite.hpp"
+#include "symbol_names.hpp"
+
+namespace {
+/// Routines that start unwinding a new or rethrown exception
+constexpr std::array<std::string_view, 5> raise_routines{
+  "__cxa_throw",
+  "__cxa_rethrow",
+  "_Unwind_RaiseException",
+  "_Unwind_Resume_or_Rethrow",
+  "_Unwind_ForcedUnwind",
+};
+
+/// Routines reached while an exception is handled that never raise another
+constexpr std::array<std::string_view, 8> handling_routines{
+  "__cxa_begin_catch",
+  "__cxa_end_catch",
+  "__cxa_end_cleanup",
+  "__cxa_call_unexpected",
+  "__cxa_call_terminate",
+  "_Unwind_Resume",
+  "_ZSt9terminatev",
+  "abort",
+};
+
+enum class reason : std::uint8_t
+{
+  no_propagating_callee,
+  stops_unwinding,
+  handling_routine,
+  raises,
+  indirect_branch,
+  unresolved_branch,
+  not_decoded,
+  callee_propagates,
+};
+
+struct deduction
+{
+  /// Index entry covering the function, nullptr if there is none
+  const arm_index_entry* entry = nullptr;
+  metadata_rank rank = metadata_rank::no_entry;
+  bool propagates = false;
+  reason why = reason::no_propagating_callee;
+  /// Callee an exception propagates from, for reason::callee_propagates
+  std::size_t cause = 0;
+};
+
+const char*
+to_string(reason p_reason)
+{
+  switch (p_reason) {
+    case reason::no_propagating_callee:
+      return "no callee propagates";
+    case reason::stops_unwinding:
+      return "stops unwinding";
+    case reason::handling_routine:
+      return "exception handling routine";
+    case reason::raises:
+      return "raises";
+    case reason::indirect_branch:
+      return "indirect branch";
+    case reason::unresolved_branch:
+      return "unresolved branch";
+    case reason::not_decoded:
+      return "not decoded";
+    case reason::callee_propagates:
+    default:
+      return "calls";
+  }
+}
+
+template<std::size_t N>
+bool
+is_one_of(std::string_view p_symbol,
+          const std::array<std::string_view, N>& p_names)
+{
+  return std::ranges::find(p_names, p_symbol) != p_names.end();
+}
+
+bool
+stops_unwinding(const exception_info& p_info)
+{
+  if (p_info.rank == metadata_rank::inlined_noexcept) {
+    return true;
+  }
+  if (p_info.rank != metadata_rank::table_gcc_lsda) {
+    return false;
+  }
+  const auto lsda = generate_lsda_info(p_info);
+  return lsda.valid && lsda.call_site.size == 0 && lsda.call_site.count == 0;
+}
+
+/**
+ * Classify every node by its index entry and the facts known without looking
+ * at its callees.
+ */
+std::vector<deduction>
+classify(const elf_image& p_image,
+         const call_graph& p_graph,
+         std::span<const arm_index_entry> p_index)
+{
+  const void* gcc_personality = find_gcc_personality(p_image);
+  std::vector<deduction> deductions(p_graph.nodes.size());
+
+  auto entry = p_index.begin();
+  for (std::size_t i = 0; i < p_graph.nodes.size(); i++) {
+    const auto& node = p_graph.nodes[i];
+    auto& result = deductions[i];
+    const auto* address = p_image.to_host(node.address);
+
+    while (entry != p_index.end() && std::next(entry) != p_index.end() &&
+           get_function(*std::next(entry)) <= address) {
+      entry++;
+    }
+    bool stops = true;
+    if (entry != p_index.end() && get_function(*entry) <= address) {
+      const exception_info info(*entry, gcc_personality);
+      result.entry = &*entry;
+      result.rank = info.rank;
+      stops = stops_unwinding(info);
+    }
+
+    // The raise routines are where every exception starts, whatever their
+    // own entry says
+    auto why = reason::no_propagating_callee;
+    if (is_one_of(node.symbol, raise_routines)) {
+      why = reason::raises;
+    } else if (stops) {
+      result.why = reason::stops_unwinding;
+    } else if (is_one_of(node.symbol, handling_routines)) {
+      result.why = reason::handling_routine;
+    } else if (not node.decoded) {
+      why = reason::not_decoded;
+    } else if (node.indirect_branches != 0) {
+      why = reason::indirect_branch;
+    } else if (node.unresolved_branches != 0) {
+      why = reason::unresolved_branch;
+    }
+
+    if (why != reason::no_propagating_callee) {
+      result.propagates = true;
+      result.why = why;
+    }
+  }
+
+  return deductions;
+}
+
+/**
+ * Mark every caller of a propagating function as propagating, unless it stops
+ * unwinding, until nothing changes.
+ */
+void
+propagate(const call_graph& p_graph, std::vector<deduction>& p_deductions)
+{
+  std::vector<std::vector<std::size_t>> callers(p_graph.nodes.size());
+  for (std::size_t i = 0; i < p_graph.nodes.size(); i++) {
+    for (const auto callee : p_graph.nodes[i].callees) {
+      callers[callee].push_back(i);
+    }
+  }
+
+  std::deque<std::size_t> pending;
+  for (std::size_t i = 0; i < p_deductions.size(); i++) {
+    if (p_deductions[i].propagates) {
+      pending.push_back(i);
+    }
+  }
+
+  while (not pending.empty()) {
+    const auto callee = pending.front();
+    pending.pop_front();
+    for (const auto caller : callers[callee]) {
+      auto& result = p_deductions[caller];
+      if (result.propagates || result.why != reason::no_propagating_callee) {
+        continue;
+      }
+      result.propagates = true;
+      result.why = reason::callee_propagates;
+      result.cause = callee;
+      pending.push_back(caller);
+    }
+  }
+}
+
+/**
+ * An index entry can be rewritten if it starts at a function and no function
+ * it covers lets an exception propagate.
+ */
+std::vector<const arm_index_entry*>
+find_rewritable_entries(const elf_image& p_image,
+                        const call_graph& p_graph,
+                        std::span<const deduction> p_deductions)
+{
+  std::vector<const arm_index_entry*> entries;
+  for (std::size_t i = 0; i < p_deductions.size(); i++) {
+    const auto* entry = p_deductions[i].entry;
+    if (entry == nullptr || entry->content == cannot_unwind_token ||
+        get_function(*entry) != p_image.to_host(p_graph.nodes[i].address)) {
+      continue;
+    }
+    bool rewritable = true;
+    for (auto j = i; j < p_deductions.size() && p_deductions[j].entry == entry;
+         j++) {
+      rewritable = rewritable && not p_deductions[j].propagates;
+    }
+    if (rewritable) {
+      entries.push_back(entry);
+    }
+  }
+  return entries;
+}
+
+/// Entries that would merge with their predecessor once they are rewritten
+std::size_t
+count_redundant_entries(std::span<const arm_index_entry> p_index,
+                        std::span<const cantunwind_rewrite> p_rewrites)
+{
+  std::vector<bool> rewritten(p_index.size());
+  for (const auto& rewrite : p_rewrites) {
+    rewritten[rewrite.index_entry - p_index.data()] = true;
+  }
+
+  auto content_of = [&](std::size_t p_entry) {
+    return rewritten[p_entry] ? cannot_unwind_token : p_index[p_entry].content;
+  };
+
+  std::size_t redundant = 0;
+  for (std::size_t i = 1; i < p_index.size(); i++) {
+    if (content_of(i) == cannot_unwind_token &&
+        content_of(i - 1) == cannot_unwind_token) {
+      redundant++;
+    }
+  }
+  return redundant;
+}
+
+void
+deduce(const std::filesystem::path& p_input,
+       const std::filesystem::path& p_output,
+       const std::filesystem::path& p_report,
+       std::span<char*> p_callgraph_info)
+{
+  const elf_image image(p_input.c_str());
+  image.require_uniform_layout();
+
+  const auto index = find_exception_index(image);
+  validate_exception_index(image, index);
+
+  auto graph = build_call_graph(image);
+  std::size_t callgraph_edges = 0;
+  for (const auto* path : p_callgraph_info) {
+    callgraph_edges += add_callgraph_info(graph, path);
+  }
+
+  auto deductions = classify(image, graph, index);
+  propagate(graph, deductions);
+
+  const auto entries = find_rewritable_entries(image, graph, deductions);
+  const auto rewrites = plan_cantunwind_rewrites(image, index, entries);
+
+  std::vector<const cantunwind_rewrite*> rewrite_of(index.size());
+  std::size_t table_bytes = 0;
+  for (const auto& rewrite : rewrites) {
+    rewrite_of[rewrite.index_entry - index.data()] = &rewrite;
+    table_bytes += rewrite.table_bytes;
+  }
+
+  std::filesystem::create_directories(p_report);
+  auto report = open_csv(p_report / "noexcept_deduction.csv",
+                         "function_name,rank,propagates,reason,cause,"
+                         "rewritten,table_bytes_freed\n");
+  std::size_t propagating = 0;
+  for (std::size_t i = 0; i < graph.nodes.size(); i++) {
+    const auto& result = deductions[i];
+    propagating += result.propagates ? 1 : 0;
+
+    const cantunwind_rewrite* rewrite = nullptr;
+    if (result.entry != nullptr && get_function(*result.entry) ==
+                                     image.to_host(graph.nodes[i].address)) {
+      rewrite = rewrite_of[result.entry - index.data()];
+    }
+    const auto cause = result.why == reason::callee_propagates
+                         ? function_name(graph.nodes[result.cause].symbol)
+                         : std::string{};
+
+    std::fprintf(report.get(),
+                 "%s,%s,%d,%s,%s,%d,%zu\n",
+                 csv_field(function_name(graph.nodes[i].symbol)).c_str(),
+                 to_string(result.rank),
+                 result.propagates,
+                 to_string(result.why),
+                 csv_field(cause).c_str(),
+                 rewrite != nullptr,
+                 rewrite != nullptr ? rewrite->table_bytes : 0);
+  }
+
+  write_rewritten_copy(image, rewrites, p_input, p_output);
+
+  std::printf("%zu functions, %zu call graph edges from -fcallgraph-info, an "
+              "exception can propagate through %zu\n",
+              graph.nodes.size(),
+              callgraph_edges,
+              propagating);
+  const auto redundant = count_redundant_entries(index, rewrites);
+  std::printf("%zu index entries rewritten to CANTUNWIND, %zu bytes of the "
+              "exception table and %zu redundant index entries (%zu bytes) "
+              "to gain when relinked\n",
+              rewrites.size(),
+              table_bytes,
+              redundant,
+              redundant * sizeof(arm_index_entry));
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  if (p_argc < 3) {
+    std::fprintf(stderr,
+                 "usage: %s <input.elf> <output.elf> [report_directory] "
+                 "[file.ci ...]\n",
+                 p_argv[0]);
+    return 1;
+  }
+
+  try {
+    const std::span<char*> callgraph_info(p_argv + std::min(p_argc, 4),
+                                          p_argv + p_argc);
+    deduce(p_argv[1], p_argv[2], p_argc >= 4 ? p_argv[3] : ".", callgraph_info);
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", p_argv[1], p_error.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include "perf_counters.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+int
+open_counter(std::uint64_t p_config, int p_group)
+{
+  perf_event_attr attributes{};
+  attributes.size = sizeof(attributes);
+  attributes.type = PERF_TYPE_HARDWARE;
+  attributes.config = p_config;
+  attributes.disabled = p_group < 0 ? 1 : 0;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_GROUP;
+
+  return static_cast<int>(
+    ::syscall(SYS_perf_event_open, &attributes, 0, -1, p_group, 0));
+}
+
+std::uint64_t
+monotonic_nanoseconds()
+{
+  timespec now{};
+  ::clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return static_cast<std::uint64_t>(now.tv_sec) * 1'000'000'000 +
+         static_cast<std::uint64_t>(now.tv_nsec);
+}
+} // namespace
+
+perf_counters::perf_counters()
+{
+  m_instructions = open_counter(PERF_COUNT_HW_INSTRUCTIONS, -1);
+  if (m_instructions < 0) {
+    return;
+  }
+  m_branch_misses = open_counter(PERF_COUNT_HW_BRANCH_MISSES, m_instructions);
+  if (m_branch_misses < 0) {
+    ::close(m_instructions);
+    m_instructions = -1;
+  }
+}
+
+perf_counters::~perf_counters()
+{
+  if (m_branch_misses >= 0) {
+    ::close(m_branch_misses);
+  }
+  if (m_instructions >= 0) {
+    ::close(m_instructions);
+  }
+}
+
+bool
+perf_counters::available() const
+{
+  return m_instructions >= 0;
+}
+
+void
+perf_counters::start()
+{
+  if (available()) {
+    ::ioctl(m_instructions, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(m_instructions, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+  m_start_time = monotonic_nanoseconds();
+}
+
+counter_sample
+perf_counters::stop()
+{
+  const auto end_time = monotonic_nanoseconds();
+  counter_sample sample{ .nanoseconds = end_time - m_start_time };
+  if (not available()) {
+    return sample;
+  }
+
+  ::ioctl(m_instructions, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  // PERF_FORMAT_GROUP: the number of counters, then their values in the order
+  // they were added to the group
+  std::uint64_t values[3]{};
+  if (::read(m_instructions, values, sizeof(values)) == sizeof(values) &&
+      values[0] == 2) {
+    sample.instructions = values[1];
+    sample.branch_misses = values[2];
+  }
+  return sample;
+}
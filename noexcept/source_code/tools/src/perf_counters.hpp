@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// Hardware performance counters of the calling thread through Linux
+// perf_event_open(2). Only user space is counted so the counters work with the
+// default perf_event_paranoid setting of 2.
+
+struct counter_sample
+{
+  std::uint64_t nanoseconds = 0;
+  std::uint64_t instructions = 0;
+  std::uint64_t branch_misses = 0;
+};
+
+/**
+ * Counts instructions retired and mispredicted branches of the calling thread
+ * as one group, so both cover exactly the same interval.
+ *
+ * When the kernel or the machine does not provide the counters, for example
+ * inside of a virtual machine without a PMU, available() returns false and
+ * only the wall clock time of samples is filled in.
+ */
+class perf_counters
+{
+public:
+  perf_counters();
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+  ~perf_counters();
+
+  /// @return true - if the hardware counters could be opened
+  bool available() const;
+
+  /// Reset and start the counters and the clock
+  void start();
+
+  /// @return counter_sample - counts since the last call to start()
+  counter_sample stop();
+
+private:
+  int m_instructions = -1;
+  int m_branch_misses = -1;
+  std::uint64_t m_start_time = 0;
+};
@@ -0,0 +1,281 @@
+#include "prologue.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <bit>
+#include <optional>
+
+#include "thumb2.hpp"
+
+namespace {
+constexpr std::uint16_t link_register = 1 << 14;
+constexpr std::uint16_t program_counter = 1 << 15;
+/// r0 to r3, saved to keep sp 8 byte aligned or to reserve a slot
+constexpr std::uint16_t argument_registers = 0x000F;
+/// r4 to r15, what the pop under mask instruction can restore
+constexpr std::uint16_t upper_registers = 0xFFF0;
+
+/// Instructions searched for the prologue, GCC schedules a few others into it
+constexpr std::uint32_t prologue_limit = 8;
+
+/// ThumbExpandImm() of the ARMv7-M reference manual
+std::uint32_t
+expand_immediate(std::uint32_t p_immediate)
+{
+  const auto byte = p_immediate & 0xFF;
+  if ((p_immediate >> 10) == 0) {
+    switch ((p_immediate >> 8) & 0x3) {
+      case 0:
+        return byte;
+      case 1:
+        return (byte << 16) | byte;
+      case 2:
+        return (byte << 24) | (byte << 8);
+      default:
+        return (byte << 24) | (byte << 16) | (byte << 8) | byte;
+    }
+  }
+  return std::rotr(0x80 | (p_immediate & 0x7F), p_immediate >> 7);
+}
+
+/// Add the effect of one prologue instruction to p_saves
+void
+record_save(register_saves& p_saves,
+            std::uint16_t p_first,
+            std::uint16_t p_second)
+{
+  // PUSH T1
+  if ((p_first & 0xFE00) == 0xB400) {
+    p_saves.core_registers |= p_first & 0xFF;
+    p_saves.core_registers |= (p_first & 0x100) ? link_register : 0;
+    return;
+  }
+  // PUSH.W T2, STMDB sp!
+  if (p_first == 0xE92D) {
+    p_saves.core_registers |= p_second & 0x5FFF;
+    return;
+  }
+  // PUSH.W T3, STR.W Rt, [sp, #-4]!
+  if (p_first == 0xF84D && (p_second & 0x0FFF) == 0x0D04) {
+    p_saves.core_registers |= 1U << (p_second >> 12);
+    return;
+  }
+  // VPUSH T1 of D registers
+  if ((p_first & 0xFFBF) == 0xED2D && (p_second & 0x0F00) == 0x0B00) {
+    p_saves.first_vfp_register =
+      (((p_first >> 6) & 1) << 4) | (p_second >> 12);
+    p_saves.vfp_registers = (p_second & 0xFF) / 2;
+    return;
+  }
+  // MOV r7, sp and ADD r7, sp, #imm, the unwinder starts from r7 after them.
+  // The saves are the stack reserved so far above sp, so imm less above r7.
+  if (p_first == 0x466F || (p_first & 0xFF00) == 0xAF00) {
+    const auto offset =
+      (p_first & 0xFF00) == 0xAF00 ? (p_first & 0xFF) << 2 : 0;
+    p_saves.frame_pointer = true;
+    p_saves.stack_adjust -= offset;
+    return;
+  }
+  if (p_saves.frame_pointer) {
+    return;
+  }
+  // SUB sp, sp, #imm T1
+  if ((p_first & 0xFF80) == 0xB080) {
+    p_saves.stack_adjust += (p_first & 0x7F) << 2;
+    return;
+  }
+  // SUB.W sp, sp, #const T2 and SUBW sp, sp, #imm12 T3
+  if ((p_second & 0x8F00) == 0x0D00 &&
+      ((p_first & 0xFBEF) == 0xF1AD || (p_first & 0xFBFF) == 0xF2AD)) {
+    const auto immediate = (((p_first >> 10) & 1) << 11) |
+                           (((p_second >> 12) & 0x7) << 8) | (p_second & 0xFF);
+    const bool subw = p_first & 0x0200;
+    p_saves.stack_adjust += static_cast<std::int32_t>(
+      subw ? immediate : expand_immediate(immediate));
+  }
+}
+
+/**
+ * @return std::optional<std::uint16_t> - the registers an instruction pops
+ * from the stack, with pc counted as lr, std::nullopt for other instructions
+ */
+std::optional<std::uint16_t>
+popped_registers(std::uint16_t p_first, std::uint16_t p_second)
+{
+  std::uint16_t registers = 0;
+  if ((p_first & 0xFE00) == 0xBC00) { // POP T1
+    registers = (p_first & 0xFF) | ((p_first & 0x100) ? program_counter : 0);
+  } else if (p_first == 0xE8BD) { // POP.W T2, LDMIA sp!
+    registers = p_second & 0xDFFF;
+  } else if (p_first == 0xF85D && (p_second & 0x0FFF) == 0x0B04) {
+    // POP.W T3, LDR.W Rt, [sp], #4
+    registers = 1U << (p_second >> 12);
+  } else {
+    return std::nullopt;
+  }
+  if (registers & program_counter) {
+    registers = (registers & ~program_counter) | link_register;
+  }
+  return registers;
+}
+
+/// Bytes of the vsp = vsp + p_bytes instructions, p_bytes may be negative
+std::uint32_t
+stack_adjust_bytes(std::int32_t p_bytes)
+{
+  if (p_bytes <= 0) {
+    // 01xxxxxx subtracts up to 0x100, there is no longer form
+    return (static_cast<std::uint32_t>(-p_bytes) + 0xFF) / 0x100;
+  }
+  const auto added = static_cast<std::uint32_t>(p_bytes);
+  // 00xxxxxx adds up to 0x100, twice reaches 0x200
+  if (added <= 0x200) {
+    return added <= 0x100 ? 1 : 2;
+  }
+  // 10110010 followed by uleb128((added - 0x204) / 4)
+  std::uint32_t bytes = 1;
+  auto value = (added - 0x204) >> 2;
+  do {
+    bytes++;
+    value >>= 7;
+  } while (value != 0);
+  return bytes;
+}
+
+/// Bytes of the instructions popping p_registers from r4 upwards
+std::uint32_t
+pop_bytes(std::uint16_t p_registers)
+{
+  const auto upper = p_registers & upper_registers;
+  if (upper == 0) {
+    return 0;
+  }
+  // 10100nnn and 10101nnn pop r4-r[4+nnn], the second with lr
+  const auto range = (upper & ~link_register) >> 4;
+  if (range != 0 && std::has_single_bit(range + 1U) && range <= 0xFF) {
+    return 1;
+  }
+  // 1000iiii iiiiiiii, pop under mask
+  return 2;
+}
+
+/// Bytes of the vpop instruction of p_saves
+std::uint32_t
+vfp_pop_bytes(const register_saves& p_saves)
+{
+  if (p_saves.vfp_registers == 0) {
+    return 0;
+  }
+  // 11010nnn pops d8-d[8+nnn], 11001001 and 11001000 take a second byte
+  if (p_saves.first_vfp_register == 8 && p_saves.vfp_registers <= 8) {
+    return 1;
+  }
+  return 2;
+}
+} // namespace
+
+prologue_info
+decode_prologue(std::span<const std::uint8_t> p_code)
+{
+  auto halfword_at = [&p_code](std::size_t p_offset) -> std::uint16_t {
+    return p_code[p_offset] | (p_code[p_offset + 1] << 8);
+  };
+
+  prologue_info info{};
+  info.decoded = p_code.size() >= 2;
+
+  bool in_prologue = true;
+  std::uint32_t instructions = 0;
+  std::size_t offset = 0;
+  while (offset + 2 <= p_code.size()) {
+    const auto first = halfword_at(offset);
+    const bool wide = is_wide_instruction(first);
+    if (wide && offset + 4 > p_code.size()) {
+      break;
+    }
+    const auto second = wide ? halfword_at(offset + 2) : std::uint16_t{ 0 };
+
+    const auto popped = popped_registers(first, second);
+    if (in_prologue) {
+      // Branch targets do not matter here, only where the prologue ends
+      in_prologue = ++instructions <= prologue_limit && not popped &&
+                    not is_return(first, second) &&
+                    not is_table_branch(first, second) &&
+                    not decode_branch(
+                      static_cast<std::uint32_t>(offset), first, second);
+    }
+    if (in_prologue) {
+      record_save(info.saves, first, second);
+    } else if (popped) {
+      info.epilogues++;
+      if (*popped != info.saves.core_registers) {
+        info.mismatched_epilogues++;
+      }
+    }
+    offset += wide ? 4 : 2;
+  }
+  return info;
+}
+
+std::uint32_t
+minimal_unwind_bytes(const register_saves& p_saves)
+{
+  // In the order the unwinder runs them: vsp from r7 or past the reserved
+  // stack, vpop, vsp past r0 to r3, pop the rest
+  const auto arguments = 4 * std::popcount(static_cast<std::uint16_t>(
+                                p_saves.core_registers & argument_registers));
+  std::uint32_t bytes = p_saves.frame_pointer ? 1 : 0;
+  if (p_saves.vfp_registers != 0) {
+    bytes += stack_adjust_bytes(p_saves.stack_adjust);
+    bytes += vfp_pop_bytes(p_saves);
+    bytes += stack_adjust_bytes(arguments);
+  } else {
+    bytes += stack_adjust_bytes(p_saves.stack_adjust + arguments);
+  }
+  return bytes + pop_bytes(p_saves.core_registers);
+}
+
+register_saves
+contiguous_register_choice(const register_saves& p_saves)
+{
+  const auto count = std::popcount(
+    static_cast<std::uint16_t>(p_saves.core_registers & ~link_register));
+  // r7 has to stay the frame pointer, r4 to r11 hold at most 8
+  if (p_saves.frame_pointer || count > 8) {
+    return p_saves;
+  }
+  auto choice = p_saves;
+  choice.core_registers = (((1U << count) - 1) << 4) |
+                          (p_saves.core_registers & link_register);
+  return choice;
+}
+
+metadata_rank
+compact_rank(std::uint32_t p_opcode_bytes)
+{
+  // Personality routine 0 holds 3 bytes of instructions in the index entry
+  return p_opcode_bytes <= 3 ? metadata_rank::inlined_personality
+                             : metadata_rank::table_personality;
+}
+
+std::uint32_t
+exception_table_bytes(metadata_rank p_rank, std::uint32_t p_opcode_bytes)
+{
+  constexpr std::uint32_t word = 4;
+  auto words_for = [](std::uint32_t p_bytes, std::uint32_t p_first_word) {
+    const auto rest = p_bytes > p_first_word ? p_bytes - p_first_word : 0;
+    return 1 + (rest + word - 1) / word;
+  };
+
+  switch (p_rank) {
+    case metadata_rank::table_personality:
+      // Personality routine 1: 1000pppp, the word count and 2 instructions
+      return words_for(p_opcode_bytes, 2) * word;
+    case metadata_rank::table_gcc_lsda:
+      // The personality routine, the word count and 3 instructions
+      return (1 + words_for(p_opcode_bytes, 3)) * word;
+    default:
+      return 0;
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+#include <span>
+
+#include "exception_metadata.hpp"
+
+// The registers a Thumb-2 function saves in its prologue and the EHABI unwind
+// instructions needed to restore them, to tell which compact model rank the
+// prologue allows.
+
+/// The stack frame a prologue sets up
+struct register_saves
+{
+  /// Bit n set if a push saved r[n], lr is bit 14
+  std::uint16_t core_registers = 0;
+  /// First D register saved by vpush
+  std::uint8_t first_vfp_register = 0;
+  /// D registers saved by vpush
+  std::uint8_t vfp_registers = 0;
+  /// Bytes from sp, or from r7 when it is the frame pointer, up to the saves.
+  /// Negative when r7 points into the saves.
+  std::int32_t stack_adjust = 0;
+  /// True if r7 is set from sp, the unwinder restores sp from it
+  bool frame_pointer = false;
+};
+
+struct prologue_info
+{
+  /// False if the function's code could not be read
+  bool decoded = false;
+  register_saves saves{};
+  /// Instructions that pop registers from the stack, one per epilogue
+  std::uint32_t epilogues = 0;
+  /// Epilogues popping other registers than the prologue pushed, pc stands
+  /// in for lr
+  std::uint32_t mismatched_epilogues = 0;
+};
+
+/**
+ * Decode the saves of the first instructions of a Thumb-2 function, up to the
+ * first branch, and every pop from the stack after them. Literal pools are
+ * decoded as instructions too, pops found in them count as epilogues.
+ *
+ * @param p_code - instructions of the function
+ * @return prologue_info - the frame and its epilogues
+ */
+prologue_info
+decode_prologue(std::span<const std::uint8_t> p_code);
+
+/**
+ * @return std::uint32_t - fewest bytes of unwind instructions that restore
+ * p_saves. r0 to r3 only pad the frame, nothing needs their saved values, so
+ * they are skipped with a vsp adjustment rather than popped.
+ */
+std::uint32_t
+minimal_unwind_bytes(const register_saves& p_saves);
+
+/**
+ * @return register_saves - p_saves with every saved register other than lr
+ * moved to r4 upwards, the choice the 1 byte pop r4-r[4+n] instruction can
+ * restore. p_saves itself for frame pointers and more than 8 registers.
+ */
+register_saves
+contiguous_register_choice(const register_saves& p_saves);
+
+/**
+ * @param p_opcode_bytes - unwind instructions before finish
+ * @return metadata_rank - inlined_personality when they fit the index entry,
+ * table_personality otherwise
+ */
+metadata_rank
+compact_rank(std::uint32_t p_opcode_bytes);
+
+/**
+ * @param p_rank - inlined_personality, table_personality or table_gcc_lsda
+ * @param p_opcode_bytes - unwind instructions before finish
+ * @return std::uint32_t - bytes of the exception table entry holding them,
+ * without the LSDA. 0 for entries inlined in the index.
+ */
+std::uint32_t
+exception_table_bytes(metadata_rank p_rank, std::uint32_t p_opcode_bytes);
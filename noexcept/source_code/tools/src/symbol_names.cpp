@@ -0,0 +1,81 @@
+#include "symbol_names.hpp"
+
+#include <cxxabi.h>
+
+#include <cstdlib>
+
+#include <memory>
+
+namespace {
+/// Remove the trailing "(...)" and any qualifiers or clone suffixes after it
+std::string
+strip_parameters(std::string p_name)
+{
+  const auto close = p_name.rfind(')');
+  if (close == std::string::npos) {
+    return p_name;
+  }
+
+  int depth = 0;
+  for (auto i = close + 1; i-- > 0;) {
+    if (p_name[i] == ')') {
+      depth++;
+    } else if (p_name[i] == '(') {
+      depth--;
+      if (depth == 0) {
+        p_name.resize(i);
+        return p_name;
+      }
+    }
+  }
+  return p_name;
+}
+} // namespace
+
+std::string
+function_name(std::string_view p_symbol)
+{
+  if (not p_symbol.starts_with("_Z")) {
+    return std::string(p_symbol);
+  }
+  // Plain C names keep any parentheses they have
+  return strip_parameters(demangled_name(p_symbol));
+}
+
+std::string
+demangled_name(std::string_view p_symbol)
+{
+  const std::string symbol(p_symbol);
+  if (not symbol.starts_with("_Z")) {
+    return symbol;
+  }
+
+  int status = 0;
+  std::unique_ptr<char, decltype(&std::free)> demangled(
+    abi::__cxa_demangle(symbol.c_str(), nullptr, nullptr, &status),
+    &std::free);
+
+  if (status != 0 || demangled == nullptr) {
+    return symbol;
+  }
+
+  return demangled.get();
+}
+
+std::string
+csv_field(std::string_view p_value)
+{
+  if (p_value.find_first_of(",\"\n") == std::string_view::npos) {
+    return std::string(p_value);
+  }
+
+  std::string quoted = "\"";
+  for (const char character : p_value) {
+    if (character == '"') {
+      quoted += '"';
+    }
+    quoted += character;
+  }
+  quoted += '"';
+  return quoted;
+}
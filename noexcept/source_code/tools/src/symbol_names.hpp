@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * Convert a symbol into the function name format used by the csv files, which
+ * is the demangled name without its parameter list, like the names main.cpp
+ * writes. `dtor::non_trivial_dtor::action()` becomes
+ * `dtor::non_trivial_dtor::action`.
+ *
+ * @param p_symbol - mangled or unmangled symbol name
+ * @return std::string - the demangled name without parameters or the symbol
+ * itself if it is not a mangled C++ name.
+ */
+std::string
+function_name(std::string_view p_symbol);
+
+/**
+ * @param p_symbol - mangled or unmangled symbol name
+ * @return std::string - the full demangled name, with the parameter list and
+ * the `[clone .cold]` style suffixes GCC gives split and specialized copies,
+ * which tells overloads and clones apart. The symbol itself if it is not a
+ * mangled C++ name.
+ */
+std::string
+demangled_name(std::string_view p_symbol);
+
+/**
+ * @param p_value - text for a single csv column
+ * @return std::string - p_value, quoted if it contains a comma or quote, as
+ * template argument lists often do.
+ */
+std::string
+csv_field(std::string_view p_value);
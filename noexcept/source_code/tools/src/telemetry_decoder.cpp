@@ -0,0 +1,200 @@
+/**
+ * @file telemetry_decoder.cpp
+ * @brief Turn a throw_telemetry.bin stream into CSV
+ *
+ * bench.elf built with NOEXCEPT_THROW_TELEMETRY drains the records of
+ * src/throw_telemetry.hpp to throw_telemetry.bin. This tool checks the stream
+ * header and names the functions that threw and caught with the symbols of the
+ * same ELF file:
+ *
+ *   - throw_telemetry.csv  throw_address, throw_function, catch_address,
+ *                          catch_function, frames, object_size, cycles
+ *
+ * Records the ring dropped become a row with an empty throw_address and the
+ * number dropped in the cycles column. cycles are cycle_counter counts, the
+ * unit bench.elf reports in throw_latency.csv.
+ *
+ * Usage:
+ *
+ *     telemetry_decoder bench.elf throw_telemetry.bin [output_directory]
+ *
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv_file.hpp"
+#include "elf_image.hpp"
+#include "exception_tables.hpp"
+#include "symbol_names.hpp"
+
+namespace {
+// Must match src/throw_telemetry.hpp
+constexpr std::string_view stream_magic = "NXTR";
+constexpr std::uint16_t stream_version = 1;
+constexpr std::size_t stream_header_size = 8;
+constexpr std::size_t record_size = 16;
+
+struct record
+{
+  std::uint32_t throw_address = 0;
+  std::uint32_t catch_address = 0;
+  std::uint32_t cycles = 0;
+  std::uint16_t frames = 0;
+  std::uint16_t object_size = 0;
+};
+
+template<typename Value>
+Value
+read_value(std::span<const std::uint8_t> p_bytes, std::size_t p_offset)
+{
+  Value value = 0;
+  for (std::size_t i = 0; i < sizeof(Value); i++) {
+    value |= static_cast<Value>(p_bytes[p_offset + i]) << (8 * i);
+  }
+  return value;
+}
+
+std::vector<std::uint8_t>
+read_stream(const std::filesystem::path& p_path)
+{
+  std::ifstream file(p_path, std::ios::binary);
+  if (not file) {
+    throw std::runtime_error("unable to open " + p_path.string());
+  }
+  return { std::istreambuf_iterator<char>(file),
+           std::istreambuf_iterator<char>() };
+}
+
+/**
+ * @return std::vector<record> - the records of p_stream, after checking its
+ * header
+ * @throws std::runtime_error - if the header does not match this decoder
+ */
+std::vector<record>
+decode_stream(std::span<const std::uint8_t> p_stream)
+{
+  if (p_stream.size() < stream_header_size ||
+      not std::ranges::equal(p_stream.first(stream_magic.size()),
+                             stream_magic)) {
+    throw std::runtime_error("not a throw telemetry stream");
+  }
+  if (read_value<std::uint16_t>(p_stream, 4) != stream_version ||
+      read_value<std::uint16_t>(p_stream, 6) != record_size) {
+    throw std::runtime_error("unsupported throw telemetry version");
+  }
+
+  // A stream cut short, by a reset during the drain, ends in a partial record
+  const auto records = p_stream.subspan(stream_header_size);
+  std::vector<record> result;
+  for (std::size_t offset = 0; offset + record_size <= records.size();
+       offset += record_size) {
+    result.push_back({
+      .throw_address = read_value<std::uint32_t>(records, offset),
+      .catch_address = read_value<std::uint32_t>(records, offset + 4),
+      .cycles = read_value<std::uint32_t>(records, offset + 8),
+      .frames = read_value<std::uint16_t>(records, offset + 12),
+      .object_size = read_value<std::uint16_t>(records, offset + 14),
+    });
+  }
+  return result;
+}
+
+/**
+ * @return std::string - csv field naming the function around the return
+ * address p_address, empty if no function symbol precedes it
+ */
+std::string
+function_at(const elf_image& p_image,
+            const std::vector<function_symbol>& p_functions,
+            std::uint32_t p_address)
+{
+  // A call to a function that does not return can be the last instruction of
+  // its caller, so the return address can be the start of the next function.
+  // Look up the call instead.
+  const auto* code = p_image.to_host(p_address - 2);
+  if (code == nullptr) {
+    return {};
+  }
+  const auto next =
+    std::ranges::upper_bound(p_functions, code, {}, &function_symbol::address);
+  if (next == p_functions.begin()) {
+    return {};
+  }
+  return csv_field(function_name(std::prev(next)->symbol));
+}
+
+void
+decode(const char* p_elf_path,
+       const char* p_stream_path,
+       const std::filesystem::path& p_output)
+{
+  const elf_image image(p_elf_path);
+  const auto functions = collect_functions(image);
+  const auto stream = read_stream(p_stream_path);
+  const auto records = decode_stream(stream);
+
+  std::filesystem::create_directories(p_output);
+  auto csv = open_csv(p_output / "throw_telemetry.csv",
+                      "throw_address,throw_function,catch_address,"
+                      "catch_function,frames,object_size,cycles\n");
+
+  std::size_t throws = 0;
+  std::uint32_t dropped = 0;
+  for (const auto& entry : records) {
+    if (entry.throw_address == 0) {
+      dropped += entry.cycles;
+      std::fprintf(csv.get(), ",,,,,,%" PRIu32 "\n", entry.cycles);
+      continue;
+    }
+    throws++;
+    const auto thrower = function_at(image, functions, entry.throw_address);
+    const auto catcher = function_at(image, functions, entry.catch_address);
+    std::fprintf(csv.get(),
+                 "0x%08" PRIx32 ",%s,0x%08" PRIx32 ",%s,%u,%u,%" PRIu32 "\n",
+                 entry.throw_address,
+                 thrower.c_str(),
+                 entry.catch_address,
+                 catcher.c_str(),
+                 entry.frames,
+                 entry.object_size,
+                 entry.cycles);
+  }
+
+  std::printf("throw telemetry: %zu records, %" PRIu32 " dropped\n",
+              throws,
+              dropped);
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  if (p_argc < 3 || p_argc > 4) {
+    std::fprintf(stderr,
+                 "usage: %s <bench.elf> <throw_telemetry.bin> "
+                 "[output_directory]\n",
+                 p_argv[0]);
+    return 1;
+  }
+
+  try {
+    decode(p_argv[1], p_argv[2], p_argc == 4 ? p_argv[3] : ".");
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", p_argv[0], p_error.what());
+    return 1;
+  }
+
+  return 0;
+}
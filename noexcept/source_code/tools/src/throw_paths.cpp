@@ -0,0 +1,484 @@
+#include "throw_paths.hpp"
+
+#include <elf.h>
+
+#include <cstring>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+#include "exception_tables.hpp"
+#include "symbol_names.hpp"
+
+namespace {
+/// std::type_info objects point two words into the vtable of their class
+constexpr std::uint32_t vtable_address_point = 8;
+/// Base classes followed before a hierarchy counts as unknown
+constexpr std::size_t max_base_classes = 16;
+/// Bytes searched before a call to __cxa_throw for the load of r1
+constexpr std::uint32_t type_load_window = 24;
+
+constexpr std::uint32_t argument_register = 1;
+
+/// @return std::uint32_t - Align(PC, 4) of the Thumb instruction at p_address
+constexpr std::uint32_t
+literal_base(std::uint32_t p_address)
+{
+  return (p_address + 4) & ~3U;
+}
+
+/// @return std::uint16_t - imm16 of a movw or movt instruction
+constexpr std::uint16_t
+move_immediate(std::uint16_t p_first, std::uint16_t p_second)
+{
+  return ((p_first & 0x000F) << 12) | ((p_first & 0x0400) << 1) |
+         ((p_second & 0x7000) >> 4) | (p_second & 0x00FF);
+}
+
+/// @return bool - if p_first:p_second is a movw (p_top false) or movt to r1
+constexpr bool
+is_move_to_argument(std::uint16_t p_first, std::uint16_t p_second, bool p_top)
+{
+  const std::uint16_t opcode = p_top ? 0xF2C0 : 0xF240;
+  return (p_first & 0xFBF0) == opcode &&
+         ((p_second >> 8) & 0xF) == argument_register &&
+         (p_second & 0x8000) == 0;
+}
+} // namespace
+
+throw_path_finder::throw_path_finder(const elf_image& p_image,
+                                     const call_graph& p_graph)
+  : m_image(p_image)
+  , m_graph(p_graph)
+  , m_index(find_exception_index(p_image))
+  , m_gcc_personality(find_gcc_personality(p_image))
+  , m_callers(p_graph.nodes.size())
+{
+  if (m_index.empty()) {
+    throw std::runtime_error("image has no exception index");
+  }
+  validate_exception_index(p_image, m_index);
+
+  auto vtable_of = [&p_image](std::string_view p_name) -> std::uint32_t {
+    const auto* symbol = p_image.find_symbol(p_name);
+    return symbol ? symbol->st_value + vtable_address_point : 0;
+  };
+  m_vtables = {
+    .class_type = vtable_of("_ZTVN10__cxxabiv117__class_type_infoE"),
+    .si_class_type = vtable_of("_ZTVN10__cxxabiv120__si_class_type_infoE"),
+    .fundamental_type =
+      vtable_of("_ZTVN10__cxxabiv123__fundamental_type_infoE"),
+  };
+
+  for (const auto& symbol : p_image.symbols()) {
+    if (symbol.st_shndx != SHN_UNDEF && symbol.st_shndx < SHN_LORESERVE &&
+        p_image.symbol_name(symbol).starts_with("_ZTI")) {
+      m_type_infos.push_back(symbol.st_value);
+    }
+  }
+  std::ranges::sort(m_type_infos);
+
+  for (std::size_t i = 0; i < p_graph.nodes.size(); i++) {
+    for (const auto& call : p_graph.nodes[i].calls) {
+      m_callers[call.callee].push_back(
+        { .node = i, .address = call.address, .tail = call.tail });
+    }
+  }
+}
+
+bool
+throw_path_finder::read_word(std::uint32_t p_address,
+                             std::uint32_t& p_value) const
+{
+  const auto* host = m_image.to_host(p_address);
+  if (host == nullptr || not m_image.contains(host, sizeof(p_value))) {
+    return false;
+  }
+  // The image is little endian, like the hosts these tools are built for
+  std::memcpy(&p_value, host, sizeof(p_value));
+  return true;
+}
+
+bool
+throw_path_finder::is_type_info(std::uint32_t p_address) const
+{
+  return std::ranges::binary_search(m_type_infos, p_address);
+}
+
+std::uint32_t
+throw_path_finder::recover_thrown_type(std::uint32_t p_call) const
+{
+  // GCC loads the std::type_info into r1 shortly before the call, either from
+  // a literal pool or with movw and movt. Instructions are not decoded
+  // backwards, candidates only count if they name a std::type_info.
+  for (std::uint32_t back = 2; back <= type_load_window; back += 2) {
+    const auto address = p_call - back;
+    std::uint32_t word = 0;
+    if (not read_word(address, word)) {
+      continue;
+    }
+    const auto first = static_cast<std::uint16_t>(word);
+    const auto second = static_cast<std::uint16_t>(word >> 16);
+
+    std::uint32_t candidate = 0;
+    bool found = false;
+    if ((first & 0xFF00) == 0x4900) {
+      // ldr r1, [pc, #imm8 * 4]
+      found =
+        read_word(literal_base(address) + ((first & 0xFF) * 4), candidate);
+    } else if ((first & 0xFF7F) == 0xF85F &&
+               (second >> 12) == argument_register) {
+      // ldr.w r1, [pc, #+/-imm12]
+      const std::uint32_t offset = second & 0x0FFF;
+      const auto base = literal_base(address);
+      found = read_word((first & 0x0080) ? base + offset : base - offset,
+                        candidate);
+    } else if (is_move_to_argument(first, second, true) && back >= 4) {
+      std::uint32_t low = 0;
+      if (read_word(address - 4, low) &&
+          is_move_to_argument(static_cast<std::uint16_t>(low),
+                              static_cast<std::uint16_t>(low >> 16),
+                              false)) {
+        candidate = (move_immediate(first, second) << 16) |
+                    move_immediate(static_cast<std::uint16_t>(low),
+                                   static_cast<std::uint16_t>(low >> 16));
+        found = true;
+      }
+    }
+
+    if (found && is_type_info(candidate)) {
+      return candidate;
+    }
+  }
+  return 0;
+}
+
+std::vector<throw_site>
+throw_path_finder::find_throw_sites() const
+{
+  std::vector<throw_site> sites;
+  const auto throw_nodes = m_graph.find("__cxa_throw");
+  for (std::size_t i = 0; i < m_graph.nodes.size(); i++) {
+    for (const auto& call : m_graph.nodes[i].calls) {
+      if (std::ranges::find(throw_nodes, call.callee) == throw_nodes.end()) {
+        continue;
+      }
+      sites.push_back({ .node = i,
+                        .address = call.address,
+                        .type = recover_thrown_type(call.address),
+                        .tail = call.tail });
+    }
+  }
+  return sites;
+}
+
+frame_outcome
+throw_path_finder::match_catch(const lsda_info& p_lsda,
+                               std::int32_t p_filter,
+                               std::uint32_t p_type) const
+{
+  // Exception specifications, only reachable from code built before C++17
+  if (p_filter < 0 || p_lsda.type_table_base == nullptr) {
+    return frame_outcome::dynamic;
+  }
+
+  // Type table entries are 4 byte absolute or pc relative pointers on ARM
+  auto as_byte = [](personality_encoding p_encoding) {
+    return static_cast<std::uint8_t>(p_encoding);
+  };
+  const auto encoding = as_byte(p_lsda.type_encoding);
+  constexpr std::uint8_t indirect = 0x80;
+  const auto format = encoding & 0x0F;
+  const auto application = encoding & 0x70;
+  const bool pc_relative = application == as_byte(personality_encoding::pcrel);
+  if ((format != as_byte(personality_encoding::absptr) &&
+       format != as_byte(personality_encoding::udata4) &&
+       format != as_byte(personality_encoding::sdata4)) ||
+      (application != 0 && not pc_relative)) {
+    return frame_outcome::dynamic;
+  }
+
+  const auto entry = m_image.to_target(p_lsda.type_table_base) -
+                     (static_cast<std::uint32_t>(p_filter) * 4);
+  std::uint32_t catch_type = 0;
+  if (not read_word(entry, catch_type)) {
+    return frame_outcome::dynamic;
+  }
+  if (catch_type == 0) {
+    return frame_outcome::handler; // catch (...)
+  }
+  if (pc_relative) {
+    catch_type += entry;
+  }
+  if ((encoding & indirect) && not read_word(catch_type, catch_type)) {
+    return frame_outcome::dynamic;
+  }
+  if (p_type == 0) {
+    return frame_outcome::dynamic;
+  }
+
+  // A catch clause takes the thrown type and its public bases. Classes with
+  // one base are followed, anything else the runtime has to compare.
+  auto type = p_type;
+  for (std::size_t i = 0; i < max_base_classes; i++) {
+    if (type == catch_type) {
+      return frame_outcome::handler;
+    }
+    std::uint32_t vtable = 0;
+    if (not read_word(type, vtable)) {
+      return frame_outcome::dynamic;
+    }
+    if (vtable == m_vtables.class_type ||
+        vtable == m_vtables.fundamental_type) {
+      return frame_outcome::pass;
+    }
+    if (vtable != m_vtables.si_class_type ||
+        not read_word(type + 8, type)) {
+      return frame_outcome::dynamic;
+    }
+  }
+  return frame_outcome::dynamic;
+}
+
+frame_plan
+throw_path_finder::plan_frame(std::size_t p_node,
+                              std::uint32_t p_return_address,
+                              std::uint32_t p_type) const
+{
+  frame_plan plan{ .node = p_node, .return_address = p_return_address };
+  // The personality routine looks up the call instruction, not the return
+  // address, which can already belong to the next call site or function
+  const auto call = p_return_address - 1;
+
+  const auto entry = std::ranges::upper_bound(
+    m_index, call, {}, [this](const arm_index_entry& p_entry) {
+      return m_image.to_target(get_function(p_entry));
+    });
+  if (entry == m_index.begin()) {
+    return plan;
+  }
+  const exception_info info(*std::prev(entry), m_gcc_personality);
+  plan.entry = info.index_entry;
+
+  switch (info.rank) {
+    case metadata_rank::inlined_personality:
+    case metadata_rank::table_personality:
+      plan.outcome = frame_outcome::unwind;
+      return plan;
+    case metadata_rank::table_gcc_lsda:
+      break;
+    case metadata_rank::inlined_noexcept:
+    case metadata_rank::no_entry:
+      return plan;
+    case metadata_rank::unknown:
+    default:
+      plan.outcome = frame_outcome::dynamic;
+      return plan;
+  }
+
+  const auto lsda = generate_lsda_info(info);
+  if (not lsda.valid) {
+    plan.outcome = frame_outcome::dynamic;
+    return plan;
+  }
+
+  // Call sites are sorted, the landing pad base is the start of the function
+  const auto start = m_image.to_target(info.function_address);
+  const auto offset = call - start;
+  bool covered = false;
+  call_site_record site{};
+  for_each_call_site(lsda, [&](const call_site_record& p_site) {
+    if (not covered && p_site.start <= offset &&
+        offset - p_site.start < p_site.length) {
+      covered = true;
+      site = p_site;
+    }
+  });
+
+  if (not covered) {
+    return plan; // terminate
+  }
+  if (site.landing_pad == 0) {
+    plan.outcome = frame_outcome::pass;
+    return plan;
+  }
+  plan.landing_pad = (start + site.landing_pad) | 1;
+  if (site.action == 0) {
+    plan.outcome = frame_outcome::cleanup;
+    return plan;
+  }
+
+  // Walk the action chain like the personality routine: the first catch
+  // clause taking the exception wins, filter 0 marks a cleanup
+  plan.typed = true;
+  const auto* action_table = lsda.call_site_table + lsda.call_site.size;
+  const auto* record = action_table + site.action - 1;
+  bool cleanup = false;
+  for (std::uint32_t i = 0; i < lsda.total_size; i++) {
+    const auto filter = read_leb128(&record);
+    const auto* next_field = record;
+    const auto next = read_leb128(&record);
+
+    if (filter == 0) {
+      cleanup = true;
+    } else {
+      const auto outcome = match_catch(lsda, filter, p_type);
+      if (outcome != frame_outcome::pass) {
+        plan.outcome = outcome;
+        plan.landing_pad = 0;
+        return plan;
+      }
+    }
+    if (next == 0) {
+      break;
+    }
+    record = next_field + next;
+  }
+
+  plan.outcome = cleanup ? frame_outcome::cleanup : frame_outcome::pass;
+  if (not cleanup) {
+    plan.landing_pad = 0;
+  }
+  return plan;
+}
+
+void
+throw_path_finder::finish(path_state& p_state, path_end p_end) const
+{
+  auto& search = *p_state.search;
+  if (search.paths.size() >= max_paths) {
+    search.truncated = true;
+    return;
+  }
+  p_state.path.end = p_end;
+  search.paths.push_back(p_state.path);
+}
+
+void
+throw_path_finder::follow_frame(path_state& p_state,
+                                std::size_t p_node,
+                                std::uint32_t p_return_address) const
+{
+  if (p_state.path.frames.size() >= max_frames) {
+    finish(p_state, path_end::too_deep);
+    return;
+  }
+
+  const auto plan = plan_frame(p_node, p_return_address, p_state.type);
+  p_state.path.frames.push_back(plan);
+  switch (plan.outcome) {
+    case frame_outcome::handler:
+      finish(p_state, path_end::handler);
+      break;
+    case frame_outcome::dynamic:
+      finish(p_state, path_end::dynamic);
+      break;
+    case frame_outcome::terminate:
+      finish(p_state, path_end::terminate);
+      break;
+    case frame_outcome::unwind:
+    case frame_outcome::pass:
+    case frame_outcome::cleanup:
+      follow_callers(p_state, p_node);
+      break;
+  }
+  p_state.path.frames.pop_back();
+}
+
+void
+throw_path_finder::follow_callers(path_state& p_state, std::size_t p_node) const
+{
+  if (p_state.search->truncated) {
+    return;
+  }
+  if (std::ranges::find(p_state.active, p_node) != p_state.active.end()) {
+    finish(p_state, path_end::recursive);
+    return;
+  }
+  const auto& callers = m_callers[p_node];
+  if (callers.empty()) {
+    finish(p_state, path_end::open);
+    return;
+  }
+
+  p_state.active.push_back(p_node);
+  for (const auto& caller : callers) {
+    if (caller.tail) {
+      // The tail caller's frame was replaced by p_node's
+      follow_callers(p_state, caller.node);
+    } else {
+      // bl is 4 bytes, the call returns right after it
+      follow_frame(p_state, caller.node, caller.address + 4);
+    }
+  }
+  p_state.active.pop_back();
+}
+
+throw_path_search
+throw_path_finder::find_paths(const throw_site& p_site) const
+{
+  throw_path_search search;
+  path_state state{ .search = &search, .type = p_site.type };
+  if (p_site.tail) {
+    follow_callers(state, p_site.node);
+  } else {
+    follow_frame(state, p_site.node, p_site.address + 4);
+  }
+  return search;
+}
+
+std::string
+throw_path_finder::type_name(std::uint32_t p_type) const
+{
+  if (p_type == 0) {
+    return {};
+  }
+  for (const auto& symbol : m_image.symbols()) {
+    const auto name = m_image.symbol_name(symbol);
+    if (symbol.st_value == p_type && name.starts_with("_ZTI")) {
+      return function_name(name);
+    }
+  }
+  return {};
+}
+
+const char*
+to_string(frame_outcome p_outcome)
+{
+  switch (p_outcome) {
+    case frame_outcome::unwind:
+      return "unwind";
+    case frame_outcome::pass:
+      return "pass";
+    case frame_outcome::cleanup:
+      return "cleanup";
+    case frame_outcome::handler:
+      return "handler";
+    case frame_outcome::dynamic:
+      return "dynamic";
+    case frame_outcome::terminate:
+    default:
+      return "terminate";
+  }
+}
+
+const char*
+to_string(path_end p_end)
+{
+  switch (p_end) {
+    case path_end::handler:
+      return "handler";
+    case path_end::terminate:
+      return "terminate";
+    case path_end::dynamic:
+      return "dynamic";
+    case path_end::open:
+      return "open";
+    case path_end::recursive:
+      return "recursive";
+    case path_end::too_deep:
+    default:
+      return "too_deep";
+  }
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "call_graph.hpp"
+#include "elf_image.hpp"
+#include "exception_metadata.hpp"
+
+// The frames a throw passes through on its way to a handler, from the direct
+// calls to __cxa_throw in an image up its call graph. Every frame is decided
+// the way __gxx_personality_v0 would decide it, from the exception index entry
+// and LSDA covering its return address and the type of the exception.
+
+/// A direct call to __cxa_throw
+struct throw_site
+{
+  /// Node of the function making the call
+  std::size_t node = 0;
+  /// Address of the call
+  std::uint32_t address = 0;
+  /// std::type_info of the exception, 0 if it could not be recovered
+  std::uint32_t type = 0;
+  /// The call is a tail call, the throwing function's frame is already gone
+  bool tail = false;
+};
+
+enum class frame_outcome : std::uint8_t
+{
+  /// Unwound without asking __gxx_personality_v0, a compact model entry
+  unwind,
+  /// __gxx_personality_v0 unwinds through the frame
+  pass,
+  /// __gxx_personality_v0 runs a cleanup landing pad, then unwinding resumes
+  cleanup,
+  /// A catch clause of the frame takes the exception
+  handler,
+  /// The answer depends on more than the type and return address, such as an
+  /// exception specification or a class hierarchy that was not followed
+  dynamic,
+  /// No call site covers the return address or the frame cannot be unwound
+  terminate,
+};
+
+/// How one frame handles the exception
+struct frame_plan
+{
+  std::size_t node = 0;
+  /// Return address into the frame, Thumb bit cleared
+  std::uint32_t return_address = 0;
+  /// Index entry covering return_address, nullptr if there is none
+  const arm_index_entry* entry = nullptr;
+  frame_outcome outcome = frame_outcome::terminate;
+  /// The outcome depends on the type of the exception
+  bool typed = false;
+  /// Cleanup landing pad with the Thumb bit set, for frame_outcome::cleanup
+  std::uint32_t landing_pad = 0;
+};
+
+enum class path_end : std::uint8_t
+{
+  /// The last frame handles the exception
+  handler,
+  /// The last frame calls std::terminate
+  terminate,
+  /// The last frame needs the personality routine to decide
+  dynamic,
+  /// The last function has no known callers, it is only reached through
+  /// pointers or is where the program starts
+  open,
+  /// The last function is already on the path
+  recursive,
+  /// The path is longer than max_frames
+  too_deep,
+};
+
+struct throw_path
+{
+  /// Frames in the order they are unwound
+  std::vector<frame_plan> frames;
+  path_end end = path_end::open;
+};
+
+struct throw_path_search
+{
+  std::vector<throw_path> paths;
+  /// max_paths was reached, further paths were not followed
+  bool truncated = false;
+};
+
+class throw_path_finder
+{
+public:
+  /// Stop a path after this many frames
+  static constexpr std::size_t max_frames = 32;
+  /// Stop following a throw site after this many paths
+  static constexpr std::size_t max_paths = 256;
+
+  /**
+   * @param p_image - image p_graph was built from
+   * @param p_graph - call graph of p_image, must outlive the finder
+   * @throws std::runtime_error - if p_image has no exception index
+   */
+  throw_path_finder(const elf_image& p_image, const call_graph& p_graph);
+
+  /**
+   * @return std::vector<throw_site> - every direct call to __cxa_throw, with
+   * the type of the exception when the load of its std::type_info into r1 is
+   * found right before the call
+   */
+  std::vector<throw_site>
+  find_throw_sites() const;
+
+  /**
+   * Decide a frame like __gxx_personality_v0 would
+   *
+   * @param p_node - function owning the frame
+   * @param p_return_address - return address into the function
+   * @param p_type - std::type_info of the exception, 0 if unknown
+   */
+  frame_plan
+  plan_frame(std::size_t p_node,
+             std::uint32_t p_return_address,
+             std::uint32_t p_type) const;
+
+  /**
+   * Follow p_site through the callers of each frame until a frame ends the
+   * unwind or the callers run out
+   */
+  throw_path_search
+  find_paths(const throw_site& p_site) const;
+
+  /**
+   * @return std::string - demangled name of the std::type_info at p_type,
+   * empty if p_type is not one
+   */
+  std::string
+  type_name(std::uint32_t p_type) const;
+
+private:
+  struct caller
+  {
+    std::size_t node = 0;
+    std::uint32_t address = 0;
+    bool tail = false;
+  };
+
+  /// Vtables of the std::type_info classes, the address their objects store
+  struct type_info_vtables
+  {
+    std::uint32_t class_type = 0;
+    std::uint32_t si_class_type = 0;
+    std::uint32_t fundamental_type = 0;
+  };
+
+  struct path_state
+  {
+    throw_path_search* search = nullptr;
+    std::uint32_t type = 0;
+    throw_path path{};
+    std::vector<std::size_t> active{};
+  };
+
+  bool
+  read_word(std::uint32_t p_address, std::uint32_t& p_value) const;
+
+  bool
+  is_type_info(std::uint32_t p_address) const;
+
+  std::uint32_t
+  recover_thrown_type(std::uint32_t p_call) const;
+
+  frame_outcome
+  match_catch(const lsda_info& p_lsda,
+              std::int32_t p_filter,
+              std::uint32_t p_type) const;
+
+  void
+  follow_frame(path_state& p_state,
+               std::size_t p_node,
+               std::uint32_t p_return_address) const;
+
+  void
+  follow_callers(path_state& p_state, std::size_t p_node) const;
+
+  void
+  finish(path_state& p_state, path_end p_end) const;
+
+  const elf_image& m_image;
+  const call_graph& m_graph;
+  std::span<const arm_index_entry> m_index;
+  const void* m_gcc_personality = nullptr;
+  type_info_vtables m_vtables{};
+  /// Sorted addresses of every std::type_info object
+  std::vector<std::uint32_t> m_type_infos;
+  /// Direct callers of every node
+  std::vector<std::vector<caller>> m_callers;
+};
+
+/// @return const char* - name of p_outcome for reports
+const char*
+to_string(frame_outcome p_outcome);
+
+/// @return const char* - name of p_end for reports
+const char*
+to_string(path_end p_end);
@@ -0,0 +1,719 @@
+/**
+ * @file throw_wcet.cpp
+ * @brief Estimated worst case latency of every throw in an image, from the
+ * throw to the catch block
+ *
+ * Every direct call to __cxa_throw is followed up the call graph the way
+ * unwind_planner follows it, and every path it can take is priced with a cost
+ * model of the unwinder, in instructions:
+ *
+ *   - raising the exception, once
+ *   - per frame and per phase, both the search and the cleanup phase: the
+ *     unwinder's loop, the bisection of the exception index, each unwind
+ *     instruction and restored register, and for frames with an LSDA the
+ *     personality routine with every call site record it reads before the one
+ *     covering the return address and every action record of that call site
+ *   - per cleanup landing pad: installing it and resuming the unwind, plus
+ *     the instructions of the pad and everything it calls, see
+ *     instruction_bounds.hpp
+ *   - entering the handler, once
+ *
+ * The coefficients are in cost_model. The defaults are typical counts for
+ * libgcc and libsupc++, not bounds taken from the image: the unwinder, the
+ * bisection and the personality routine all loop, and instruction_bounds only
+ * bounds code without loops. Only the landing pads are bounded, so every total
+ * is an estimate until the coefficients are calibrated for the runtime the
+ * image links. With --measured, the coefficients are scaled until the
+ * estimate of every measured throw covers it, and written back out for
+ * --model.
+ *
+ * Cycles are only reported for a --cycles-per-instruction given by the user.
+ * It has to be the cost of the slowest instruction on the path with its
+ * memory accesses, not an average: on a Cortex-M3 UDIV takes up to 12 cycles,
+ * LDM and POP one per register, and every flash wait state adds to each fetch
+ * and load.
+ *
+ * Outputs:
+ *
+ *   - throw_wcet_estimate.csv   the estimate from every throw site to every
+ *                               handler it can reach, the worst path of each
+ *   - throw_wcet_validation.csv with --measured, each throw path measured by
+ *                               bench.elf next to the estimate of its exhibit
+ *   - throw_wcet_model.csv      with --measured, the coefficients scaled to
+ *                               cover every measurement
+ *
+ * Exits with 2 when a measurement is above its estimate.
+ *
+ * Usage:
+ *
+ *     throw_wcet app.elf [report_directory] [--model <throw_wcet_model.csv>]
+ *                [--cycles-per-instruction <cycles>]
+ *                [--measured <throw_latency.csv>]
+ *
+ */
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <bit>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "call_graph.hpp"
+#include "csv_file.hpp"
+#include "elf_image.hpp"
+#include "exception_tables.hpp"
+#include "instruction_bounds.hpp"
+#include "symbol_names.hpp"
+#include "throw_paths.hpp"
+#include "unwind_instructions.hpp"
+
+namespace {
+/**
+ * Instructions charged for each step of a throw through libgcc and libsupc++
+ * on a Cortex-M. The defaults are estimates, a different runtime or a loop the
+ * model does not see, such as the heap search of __cxa_allocate_exception, can
+ * take longer. Calibrate them with --measured.
+ */
+struct cost_model
+{
+  /// __cxa_allocate_exception, __cxa_throw and _Unwind_RaiseException up to
+  /// the first frame
+  std::uint32_t raise = 400;
+  /// The unwinder around one frame: get_eit_entry, the personality call and
+  /// the checks of its answer
+  std::uint32_t frame = 80;
+  /// One step of the bisection over the exception index
+  std::uint32_t index_step = 12;
+  /// One unwind instruction in __gnu_unwind_execute
+  std::uint32_t unwind_opcode = 20;
+  /// One core register restored by a pop
+  std::uint32_t restored_register = 3;
+  /// __gxx_personality_v0 up to its call site table, the LSDA header
+  std::uint32_t personality = 120;
+  /// One call site record, four encoded values and the range check
+  std::uint32_t call_site = 30;
+  /// One action record, two sleb128 values and a type comparison
+  std::uint32_t action = 40;
+  /// __cxa_begin_cleanup, __cxa_end_cleanup and _Unwind_Resume back into the
+  /// cleanup phase, around the pad itself
+  std::uint32_t cleanup = 250;
+  /// Installing the handler frame and __cxa_begin_catch
+  std::uint32_t catch_entry = 150;
+};
+
+/// A coefficient as named in throw_wcet_model.csv
+struct coefficient
+{
+  std::string_view name;
+  std::uint32_t cost_model::* member = nullptr;
+};
+
+constexpr coefficient coefficients[] = {
+  { "raise", &cost_model::raise },
+  { "frame", &cost_model::frame },
+  { "index_step", &cost_model::index_step },
+  { "unwind_opcode", &cost_model::unwind_opcode },
+  { "restored_register", &cost_model::restored_register },
+  { "personality", &cost_model::personality },
+  { "call_site", &cost_model::call_site },
+  { "action", &cost_model::action },
+  { "cleanup", &cost_model::cleanup },
+  { "catch_entry", &cost_model::catch_entry },
+};
+
+struct options
+{
+  std::filesystem::path elf;
+  std::filesystem::path report = ".";
+  std::optional<std::filesystem::path> model;
+  /// Cycles of the slowest instruction, no cycles are reported without it
+  std::optional<std::uint32_t> cycles_per_instruction;
+  std::optional<std::filesystem::path> measured;
+};
+
+/// Instructions of a path, split by where their bound comes from
+struct path_cost
+{
+  /// Charged with the coefficients of the cost model
+  std::uint64_t unwinder = 0;
+  /// Bounded from the instructions of the image
+  std::uint64_t landing_pads = 0;
+
+  std::uint64_t
+  total() const
+  {
+    return unwinder + landing_pads;
+  }
+};
+
+/// Estimates the paths of a throw_path_finder with a cost_model
+class path_costs
+{
+public:
+  path_costs(const elf_image& p_image,
+             const call_graph& p_graph,
+             const cost_model& p_model)
+    : m_image(p_image)
+    , m_model(p_model)
+    , m_index(find_exception_index(p_image))
+    , m_gcc_personality(find_gcc_personality(p_image))
+    , m_bounds(p_image, p_graph)
+  {
+    const auto steps = std::bit_width(m_index.size());
+    m_index_search = steps * m_model.index_step;
+
+    for (const auto& entry : m_index) {
+      const exception_info info(entry, m_gcc_personality);
+      m_worst_frame = std::max(m_worst_frame, frame(info, std::nullopt));
+    }
+  }
+
+  /**
+   * @return std::optional<path_cost> - estimated instructions from the throw
+   * to the catch block, or to std::terminate or the last frame the path shows,
+   * std::nullopt if a landing pad on the way is unbounded
+   */
+  std::optional<path_cost>
+  path(const throw_path& p_path)
+  {
+    path_cost cost{ .unwinder = m_model.raise };
+    for (const auto& plan : p_path.frames) {
+      if (plan.entry == nullptr) {
+        cost.unwinder += 2 * (m_model.frame + m_index_search);
+        continue;
+      }
+      const exception_info info(*plan.entry, m_gcc_personality);
+      cost.unwinder += 2 * frame(info, plan.return_address);
+
+      if (plan.outcome == frame_outcome::cleanup) {
+        const auto pad = m_bounds.from(plan.node, plan.landing_pad);
+        if (not pad) {
+          return std::nullopt;
+        }
+        cost.unwinder += m_model.cleanup;
+        cost.landing_pads += *pad;
+      }
+    }
+    if (p_path.end == path_end::handler) {
+      cost.unwinder += m_model.catch_entry;
+    }
+    return cost;
+  }
+
+  /**
+   * @return std::uint64_t - both phases of the costliest frame in the image
+   * and entering its handler, for the frame that catches a throw reaching
+   * code the call graph does not show
+   */
+  std::uint64_t
+  unknown_handler() const
+  {
+    return (2 * m_worst_frame) + m_model.catch_entry;
+  }
+
+private:
+  /**
+   * @param p_return_address - return address into the frame, std::nullopt to
+   * price the worst one
+   * @return std::uint32_t - one phase of the frame
+   */
+  std::uint32_t
+  frame(const exception_info& p_info,
+        std::optional<std::uint32_t> p_return_address) const
+  {
+    std::uint32_t cost = m_model.frame + m_index_search;
+    const auto unwind = decode_unwind_instructions(p_info);
+    cost += (unwind.opcode_count * m_model.unwind_opcode) +
+            (core_register_count(unwind) * m_model.restored_register);
+    if (p_info.rank == metadata_rank::table_gcc_lsda) {
+      cost += m_model.personality + lsda_scan(p_info, p_return_address);
+    }
+    return cost;
+  }
+
+  /// @return std::uint32_t - call site and action records read for the frame
+  std::uint32_t
+  lsda_scan(const exception_info& p_info,
+            std::optional<std::uint32_t> p_return_address) const
+  {
+    const auto lsda = generate_lsda_info(p_info);
+    const auto worst = (lsda.call_site.count * m_model.call_site) +
+                       (lsda.action_table.count * m_model.action);
+    if (not lsda.valid || not p_return_address) {
+      return worst;
+    }
+
+    // The personality routine reads records until one covers the call or
+    // starts after it, like throw_path_finder::plan_frame
+    const auto offset =
+      (*p_return_address - 1) - m_image.to_target(p_info.function_address);
+    std::uint32_t records = 0;
+    bool done = false;
+    call_site_record site{};
+    for_each_call_site(lsda, [&](const call_site_record& p_site) {
+      if (done) {
+        return;
+      }
+      records++;
+      if (p_site.start > offset) {
+        done = true;
+      } else if (offset - p_site.start < p_site.length) {
+        done = true;
+        site = p_site;
+      }
+    });
+
+    std::uint32_t actions = 0;
+    if (site.action != 0) {
+      const auto* record =
+        lsda.call_site_table + lsda.call_site.size + site.action - 1;
+      while (actions < lsda.action_table.count) {
+        actions++;
+        read_leb128(&record);
+        const auto* next_field = record;
+        const auto next = read_leb128(&record);
+        if (next == 0) {
+          break;
+        }
+        record = next_field + next;
+      }
+    }
+    return (records * m_model.call_site) + (actions * m_model.action);
+  }
+
+  const elf_image& m_image;
+  const cost_model& m_model;
+  std::span<const arm_index_entry> m_index;
+  const void* m_gcc_personality = nullptr;
+  instruction_bounds m_bounds;
+  std::uint32_t m_index_search = 0;
+  std::uint32_t m_worst_frame = 0;
+};
+
+/// Worst path from one throw site to one handler
+struct handler_estimate
+{
+  std::size_t paths = 0;
+  std::size_t frames = 0;
+  std::size_t cleanup_pads = 0;
+  std::uint64_t instructions = 0;
+  /// False once a path is unbounded
+  bool bounded = true;
+};
+
+/// A path estimated for the validation against bench.elf
+struct priced_path
+{
+  std::string throw_function;
+  std::vector<std::string> functions;
+  path_end end = path_end::open;
+  std::optional<path_cost> cost;
+};
+
+/// Outcome of comparing the estimates with throw_latency.csv
+struct validation
+{
+  /// Measurements above their estimate
+  std::size_t exceeded = 0;
+  /// Measurements in instructions with a bounded estimate
+  std::size_t calibrated_rows = 0;
+  /// Smallest factor on the coefficients that covers every measurement
+  double scale = 0.0;
+};
+
+/// @return bool - if p_end is where the throw really stops
+bool
+is_complete(path_end p_end)
+{
+  return p_end == path_end::handler || p_end == path_end::terminate;
+}
+
+std::vector<std::string_view>
+split_row(std::string_view p_line)
+{
+  std::vector<std::string_view> columns;
+  while (true) {
+    const auto comma = p_line.find(',');
+    columns.push_back(p_line.substr(0, comma));
+    if (comma == std::string_view::npos) {
+      return columns;
+    }
+    p_line.remove_prefix(comma + 1);
+  }
+}
+
+/**
+ * @param p_path - csv file with a coefficient,instructions header, any
+ * coefficient it leaves out keeps its default
+ * @throws std::runtime_error - if the file cannot be read or names an unknown
+ * coefficient
+ */
+cost_model
+read_model(const std::filesystem::path& p_path)
+{
+  std::ifstream file(p_path);
+  std::string line;
+  if (not file || not std::getline(file, line)) {
+    throw std::runtime_error("unable to read " + p_path.string());
+  }
+
+  cost_model model;
+  while (std::getline(file, line)) {
+    const auto row = split_row(line);
+    if (row.size() < 2) {
+      continue;
+    }
+    const auto match =
+      std::ranges::find(coefficients, row[0], &coefficient::name);
+    if (match == std::end(coefficients)) {
+      throw std::runtime_error(p_path.string() +
+                               " has an unknown coefficient " +
+                               std::string(row[0]));
+    }
+    model.*(match->member) = std::strtoul(row[1].data(), nullptr, 10);
+  }
+  return model;
+}
+
+/// Write p_model, every coefficient multiplied by p_scale and rounded up
+void
+write_model(const std::filesystem::path& p_path,
+            const cost_model& p_model,
+            double p_scale)
+{
+  auto file = open_csv(p_path, "coefficient,instructions\n");
+  for (const auto& [name, coefficient] : coefficients) {
+    const auto scaled = std::ceil(p_model.*coefficient * p_scale);
+    std::fprintf(file.get(),
+                 "%.*s,%" PRIu32 "\n",
+                 static_cast<int>(name.size()),
+                 name.data(),
+                 static_cast<std::uint32_t>(scaled));
+  }
+}
+
+/// @return bool - if p_function is p_name or a member named p_name
+bool
+names_function(std::string_view p_function, std::string_view p_name)
+{
+  return p_function == p_name ||
+         (p_function.ends_with(p_name) &&
+          p_function.substr(0, p_function.size() - p_name.size())
+            .ends_with("::"));
+}
+
+/**
+ * Compare the throw paths of throw_latency.csv with the estimates of the paths
+ * from the throw sites of their trigger through their exhibit, and work out
+ * how far the coefficients of the model have to be scaled to cover them
+ */
+validation
+validate(const options& p_options,
+         std::span<const priced_path> p_paths,
+         std::uint64_t p_unknown_handler)
+{
+  std::ifstream measured(*p_options.measured);
+  std::string line;
+  if (not measured || not std::getline(measured, line)) {
+    throw std::runtime_error("unable to read " + p_options.measured->string());
+  }
+
+  const auto header = split_row(line);
+  auto column = [&header](std::string_view p_name) {
+    const auto match = std::ranges::find(header, p_name);
+    if (match == header.end()) {
+      throw std::runtime_error("throw_latency.csv has no " +
+                               std::string(p_name) + " column");
+    }
+    return static_cast<std::size_t>(match - header.begin());
+  };
+  const auto function_column = column("function");
+  const auto trigger_column = column("trigger");
+  const auto happy_column = column("happy_path");
+  const auto throw_column = column("throw_path");
+  const auto outcome_column = column("throw_outcome");
+  const auto unit_column = column("unit");
+
+  auto report =
+    open_csv(p_options.report / "throw_wcet_validation.csv",
+             "function,trigger,throw_outcome,happy_path,throw_path,estimate,"
+             "unit,status\n");
+
+  validation result;
+  while (std::getline(measured, line)) {
+    const auto row = split_row(line);
+    if (row.size() < header.size() || row[throw_column].empty()) {
+      continue;
+    }
+    const auto function = row[function_column];
+    const auto trigger = row[trigger_column];
+    const auto happy = std::strtoull(row[happy_column].data(), nullptr, 10);
+    const auto thrown = std::strtoull(row[throw_column].data(), nullptr, 10);
+    const bool cycles = row[unit_column] == "cycles";
+
+    bool found = false;
+    bool bounded = true;
+    std::uint64_t estimate = 0;
+    // Scale of the coefficients at which some path covers the measurement
+    std::optional<double> covering_scale;
+    for (const auto& path : p_paths) {
+      if (not names_function(path.throw_function, trigger) ||
+          std::ranges::find(path.functions, function) ==
+            path.functions.end()) {
+        continue;
+      }
+      found = true;
+      auto cost = path.cost;
+      if (cost && path.end == path_end::open) {
+        // Exhibits are called through pointers, the catching frame is not
+        // in the call graph
+        cost->unwinder += p_unknown_handler;
+      } else if (not is_complete(path.end)) {
+        cost.reset();
+      }
+      bounded = bounded && cost.has_value();
+      if (not cost) {
+        continue;
+      }
+      estimate = std::max(estimate, cost->total());
+
+      // The exhibit runs its own code before the throw, at most its happy path
+      const auto fixed = happy + cost->landing_pads;
+      const auto needed =
+        thrown > fixed ? static_cast<double>(thrown - fixed) : 0.0;
+      const auto scale = cost->unwinder == 0
+                           ? 1.0
+                           : needed / static_cast<double>(cost->unwinder);
+      covering_scale = std::min(covering_scale.value_or(scale), scale);
+    }
+
+    std::string estimate_column;
+    const char* status = "no_path";
+    if (found && bounded && cycles && not p_options.cycles_per_instruction) {
+      status = "no_cycles_per_instruction";
+    } else if (found && bounded) {
+      auto limit = estimate;
+      if (cycles) {
+        limit *= *p_options.cycles_per_instruction;
+      }
+      limit += happy;
+      estimate_column = std::to_string(limit);
+      status = thrown <= limit ? "within" : "exceeded";
+      result.exceeded += thrown <= limit ? 0 : 1;
+      if (not cycles && covering_scale) {
+        // Dividing cycles by the slowest instruction would undercount, only
+        // instruction counts calibrate the model
+        result.calibrated_rows++;
+        result.scale = std::max(result.scale, *covering_scale);
+      }
+    } else if (found) {
+      status = "unbounded";
+    }
+
+    std::fprintf(report.get(),
+                 "%s,%s,%s,%llu,%llu,%s,%s,%s\n",
+                 csv_field(function).c_str(),
+                 csv_field(trigger).c_str(),
+                 csv_field(row[outcome_column]).c_str(),
+                 happy,
+                 thrown,
+                 estimate_column.c_str(),
+                 cycles ? "cycles" : "instructions",
+                 status);
+  }
+  return result;
+}
+
+/// @return bool - false if a measurement is above its estimate
+bool
+analyze(const options& p_options)
+{
+  const elf_image image(p_options.elf.c_str());
+  image.require_uniform_layout();
+
+  const auto model =
+    p_options.model ? read_model(*p_options.model) : cost_model{};
+  const auto graph = build_call_graph(image);
+  const throw_path_finder finder(image, graph);
+  path_costs costs(image, graph, model);
+  const auto sites = finder.find_throw_sites();
+
+  std::filesystem::create_directories(p_options.report);
+  auto report =
+    open_csv(p_options.report / "throw_wcet_estimate.csv",
+             "throw_function,throw_address,exception_type,handler_function,"
+             "outcome,paths,frames,cleanup_pads,estimated_instructions,"
+             "estimated_cycles\n");
+
+  auto name_of = [&graph](std::size_t p_node) {
+    return function_name(graph.nodes[p_node].symbol);
+  };
+
+  std::vector<priced_path> priced;
+  std::size_t rows = 0;
+  std::size_t unbounded = 0;
+  for (const auto& site : sites) {
+    const auto search = finder.find_paths(site);
+    if (search.truncated) {
+      std::fprintf(stderr,
+                   "%s: more than %zu paths, the rest are not estimated\n",
+                   name_of(site.node).c_str(),
+                   throw_path_finder::max_paths);
+    }
+
+    // The worst path to each handler, paths ending elsewhere by how they end
+    std::map<std::tuple<std::string, path_end>, handler_estimate> handlers;
+    for (const auto& path : search.paths) {
+      const auto cost = costs.path(path);
+      std::size_t cleanups = 0;
+      priced_path entry{ .throw_function = name_of(site.node),
+                         .end = path.end,
+                         .cost = cost };
+      for (const auto& frame : path.frames) {
+        entry.functions.push_back(name_of(frame.node));
+        cleanups += frame.outcome == frame_outcome::cleanup ? 1 : 0;
+      }
+
+      const auto handler =
+        path.end == path_end::handler ? entry.functions.back() : std::string();
+      auto& worst = handlers[{ handler, path.end }];
+      worst.paths++;
+      worst.frames = std::max(worst.frames, path.frames.size());
+      worst.cleanup_pads = std::max(worst.cleanup_pads, cleanups);
+      worst.bounded = worst.bounded && cost.has_value();
+      worst.instructions =
+        std::max(worst.instructions, cost ? cost->total() : 0);
+      priced.push_back(std::move(entry));
+    }
+
+    for (const auto& [key, worst] : handlers) {
+      const auto& [handler, end] = key;
+      std::string instructions;
+      std::string cycles;
+      if (worst.bounded) {
+        instructions = std::to_string(worst.instructions);
+        if (p_options.cycles_per_instruction) {
+          cycles = std::to_string(worst.instructions *
+                                  *p_options.cycles_per_instruction);
+        }
+      }
+
+      std::fprintf(report.get(),
+                   "%s,0x%" PRIx32 ",%s,%s,%s,%zu,%zu,%zu,%s,%s\n",
+                   csv_field(name_of(site.node)).c_str(),
+                   site.address,
+                   csv_field(finder.type_name(site.type)).c_str(),
+                   csv_field(handler).c_str(),
+                   to_string(end),
+                   worst.paths,
+                   worst.frames,
+                   worst.cleanup_pads,
+                   instructions.c_str(),
+                   cycles.c_str());
+      rows++;
+      unbounded += worst.bounded && is_complete(end) ? 0 : 1;
+    }
+  }
+
+  std::printf("%zu throw sites, %zu handler estimates of which %zu are not "
+              "complete\n",
+              sites.size(),
+              rows,
+              unbounded);
+  if (not p_options.measured) {
+    return true;
+  }
+
+  const auto checked = validate(p_options, priced, costs.unknown_handler());
+  std::printf("%zu measurements over their estimate\n", checked.exceeded);
+  if (checked.calibrated_rows != 0) {
+    write_model(
+      p_options.report / "throw_wcet_model.csv", model, checked.scale);
+    std::printf("%zu measurements in instructions are covered with the "
+                "coefficients scaled by %.2f, written to throw_wcet_model.csv "
+                "for --model\n",
+                checked.calibrated_rows,
+                checked.scale);
+  }
+  return checked.exceeded == 0;
+}
+
+/// @return std::optional<options> - std::nullopt if p_argv is not valid
+std::optional<options>
+parse(std::span<char*> p_arguments)
+{
+  options parsed;
+  std::vector<std::string_view> positional;
+  for (std::size_t i = 0; i < p_arguments.size(); i++) {
+    const std::string_view argument = p_arguments[i];
+    if (not argument.starts_with("--")) {
+      positional.push_back(argument);
+      continue;
+    }
+    if (i + 1 == p_arguments.size()) {
+      return std::nullopt;
+    }
+    const char* value = p_arguments[++i];
+    char* end = nullptr;
+    if (argument == "--cycles-per-instruction") {
+      parsed.cycles_per_instruction = std::strtoul(value, &end, 10);
+    } else if (argument == "--model") {
+      parsed.model = value;
+      continue;
+    } else if (argument == "--measured") {
+      parsed.measured = value;
+      continue;
+    } else {
+      return std::nullopt;
+    }
+    if (end == value || *end != '\0') {
+      return std::nullopt;
+    }
+  }
+
+  if (positional.empty() || positional.size() > 2) {
+    return std::nullopt;
+  }
+  parsed.elf = positional[0];
+  if (positional.size() == 2) {
+    parsed.report = positional[1];
+  }
+  return parsed;
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  const auto parsed = parse(std::span(p_argv + 1, p_argv + p_argc));
+  if (not parsed) {
+    std::fprintf(stderr,
+                 "usage: %s <app.elf> [report_directory] "
+                 "[--model <throw_wcet_model.csv>] "
+                 "[--cycles-per-instruction <cycles>] "
+                 "[--measured <throw_latency.csv>]\n",
+                 p_argv[0]);
+    return 1;
+  }
+
+  try {
+    return analyze(*parsed) ? 0 : 2;
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", parsed->elf.c_str(), p_error.what());
+    return 1;
+  }
+}
@@ -0,0 +1,253 @@
+/**
+ * @file unwind_planner.cpp
+ * @brief Precompute the personality routine's answers for known throw sites
+ *
+ * Every direct call to __cxa_throw is followed up the call graph of the image.
+ * For each frame on the way, the exception index entry and LSDA covering its
+ * return address decide what __gxx_personality_v0 will do with the exception:
+ * unwind through the frame, run one of its cleanup landing pads, catch it, or
+ * terminate. Those answers only depend on the return address and the type of
+ * the exception, so they are written into the unwind_plan_table of a copy of
+ * the image, built with -DNOEXCEPT_UNWIND_PLAN=ON, where src/unwind_plan.cpp
+ * replays them without decoding the LSDA.
+ *
+ * Frames that catch the exception are left to the personality routine, it
+ * hands their landing pad from the search phase to the cleanup phase. So are
+ * frames whose answer depends on more than the type, and every frame of a
+ * path the call graph does not show, such as calls through pointers.
+ *
+ * Outputs:
+ *
+ *   - unwind_plans.csv every path from a throw site: the frames it unwinds,
+ *                      the cleanup landing pads it runs in order and the
+ *                      frame that ends it
+ *   - the planned image, addresses unchanged
+ *
+ * Usage:
+ *
+ *     unwind_planner app.elf planned.elf [report_directory]
+ *
+ */
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "call_graph.hpp"
+#include "csv_file.hpp"
+#include "elf_image.hpp"
+#include "symbol_names.hpp"
+#include "throw_paths.hpp"
+#include "unwind_plan.hpp"
+
+namespace {
+static_assert(sizeof(unwind_plan::entry) == 12 &&
+                sizeof(unwind_plan::table_header) == 12,
+              "the table layout must match the 32-bit target");
+
+/// @return bool - if the frame's answer can be replayed from the table
+bool
+is_plannable(const frame_plan& p_frame)
+{
+  return p_frame.outcome == frame_outcome::pass ||
+         p_frame.outcome == frame_outcome::cleanup;
+}
+
+unwind_plan::entry
+to_entry(const frame_plan& p_frame, std::uint32_t p_type)
+{
+  return {
+    .return_address = p_frame.return_address,
+    .type = p_frame.typed ? p_type : 0,
+    .landing_pad =
+      p_frame.outcome == frame_outcome::cleanup ? p_frame.landing_pad : 0,
+  };
+}
+
+void
+write_path(std::FILE* p_csv,
+           const call_graph& p_graph,
+           const throw_site& p_site,
+           const std::string& p_type,
+           const throw_path& p_path)
+{
+  std::string path;
+  std::string cleanups;
+  std::size_t cleanup_count = 0;
+  for (const auto& frame : p_path.frames) {
+    if (not path.empty()) {
+      path += " > ";
+    }
+    path += function_name(p_graph.nodes[frame.node].symbol);
+    if (frame.outcome == frame_outcome::cleanup) {
+      char address[16];
+      std::snprintf(address,
+                    sizeof(address),
+                    "%s0x%" PRIx32,
+                    cleanups.empty() ? "" : " ",
+                    frame.landing_pad & ~1U);
+      cleanups += address;
+      cleanup_count++;
+    }
+  }
+
+  std::string handler;
+  std::uint32_t handler_address = 0;
+  if (p_path.end == path_end::handler) {
+    const auto& frame = p_path.frames.back();
+    handler = function_name(p_graph.nodes[frame.node].symbol);
+    handler_address = frame.return_address;
+  }
+
+  std::fprintf(p_csv,
+               "%s,0x%" PRIx32 ",%s,%s,%zu,%zu,%s,%s,%s,0x%" PRIx32 "\n",
+               csv_field(function_name(p_graph.nodes[p_site.node].symbol))
+                 .c_str(),
+               p_site.address,
+               csv_field(p_type).c_str(),
+               csv_field(path).c_str(),
+               p_path.frames.size(),
+               cleanup_count,
+               cleanups.c_str(),
+               to_string(p_path.end),
+               csv_field(handler).c_str(),
+               handler_address);
+}
+
+/**
+ * Write p_entries into the unwind_plan_table of a copy of p_input
+ *
+ * @throws std::runtime_error - if the image has no table or it is too small
+ */
+void
+write_planned_copy(const elf_image& p_image,
+                   std::span<const unwind_plan::entry> p_entries,
+                   const std::filesystem::path& p_input,
+                   const std::filesystem::path& p_output)
+{
+  const auto* symbol = p_image.find_symbol("unwind_plan_table");
+  const auto* table = symbol ? p_image.to_host(symbol->st_value) : nullptr;
+  if (table == nullptr ||
+      not p_image.contains(table, sizeof(unwind_plan::table_header))) {
+    throw std::runtime_error(
+      "no unwind_plan_table, link with -DNOEXCEPT_UNWIND_PLAN=ON");
+  }
+
+  unwind_plan::table_header header{};
+  std::memcpy(&header, table, sizeof(header));
+  if (header.magic != unwind_plan::table_magic ||
+      not p_image.contains(table,
+                           sizeof(header) +
+                             (header.capacity * sizeof(unwind_plan::entry)))) {
+    throw std::runtime_error("unwind_plan_table is not an unwind plan table");
+  }
+  if (p_entries.size() > header.capacity) {
+    throw std::runtime_error(
+      "the plan has " + std::to_string(p_entries.size()) +
+      " frames, raise NOEXCEPT_UNWIND_PLAN_CAPACITY from " +
+      std::to_string(header.capacity));
+  }
+
+  header.count = p_entries.size();
+  const image_patch patches[] = {
+    { .location = table, .bytes = std::as_bytes(std::span(&header, 1)) },
+    { .location = table + sizeof(header),
+      .bytes = std::as_bytes(p_entries) },
+  };
+  write_patched_copy(p_image, patches, p_input, p_output);
+}
+
+void
+plan(const std::filesystem::path& p_input,
+     const std::filesystem::path& p_output,
+     const std::filesystem::path& p_report)
+{
+  const elf_image image(p_input.c_str());
+  image.require_uniform_layout();
+
+  const auto graph = build_call_graph(image);
+  const throw_path_finder finder(image, graph);
+  const auto sites = finder.find_throw_sites();
+
+  std::filesystem::create_directories(p_report);
+  auto report =
+    open_csv(p_report / "unwind_plans.csv",
+             "throw_function,throw_address,exception_type,path,frames,"
+             "cleanup_pads,cleanup_addresses,outcome,handler_function,"
+             "handler_address\n");
+
+  std::vector<unwind_plan::entry> entries;
+  std::size_t path_count = 0;
+  std::size_t handled = 0;
+  std::size_t untyped = 0;
+  for (const auto& site : sites) {
+    const auto type = finder.type_name(site.type);
+    untyped += site.type == 0 ? 1 : 0;
+
+    const auto search = finder.find_paths(site);
+    if (search.truncated) {
+      std::fprintf(stderr,
+                   "%s: more than %zu paths, the rest are not planned\n",
+                   function_name(graph.nodes[site.node].symbol).c_str(),
+                   throw_path_finder::max_paths);
+    }
+    for (const auto& path : search.paths) {
+      write_path(report.get(), graph, site, type, path);
+      path_count++;
+      handled += path.end == path_end::handler ? 1 : 0;
+      for (const auto& frame : path.frames) {
+        if (is_plannable(frame)) {
+          entries.push_back(to_entry(frame, site.type));
+        }
+      }
+    }
+  }
+
+  // Paths share frames, the runtime looks frames up by return address
+  auto key = [](const unwind_plan::entry& p_entry) {
+    return std::tuple(
+      p_entry.return_address, p_entry.type, p_entry.landing_pad);
+  };
+  std::ranges::sort(entries, {}, key);
+  const auto duplicates = std::ranges::unique(entries, {}, key);
+  entries.erase(duplicates.begin(), duplicates.end());
+
+  write_planned_copy(image, entries, p_input, p_output);
+
+  std::printf("%zu throw sites (%zu of unknown type), %zu paths of which %zu "
+              "reach a handler, %zu frames planned\n",
+              sites.size(),
+              untyped,
+              path_count,
+              handled,
+              entries.size());
+}
+} // namespace
+
+int
+main(int p_argc, char** p_argv)
+{
+  if (p_argc < 3 || p_argc > 4) {
+    std::fprintf(stderr,
+                 "usage: %s <input.elf> <output.elf> [report_directory]\n",
+                 p_argv[0]);
+    return 1;
+  }
+
+  try {
+    plan(p_argv[1], p_argv[2], p_argc == 4 ? p_argv[3] : ".");
+  } catch (const std::exception& p_error) {
+    std::fprintf(stderr, "%s: %s\n", p_argv[1], p_error.what());
+    return 1;
+  }
+
+  return 0;
+}
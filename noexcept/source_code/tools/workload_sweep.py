@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Build workload.elf at growing function counts and chart its metadata.
+
+For every function count, tools/generate_workload.py writes the workload,
+conan builds workload.elf and exception_analyzer measures it. Images that fit
+in the flash of the QEMU machine are also run to time a throw through the
+workload. The output directory receives:
+
+    <functions>/                  exception_analyzer output
+    <functions>/workload_latency.csv  throw latency, when the image was run
+    summary.csv                   one row per function count: .text,
+                                  .ARM.exidx and .ARM.extab bytes, the throw
+                                  latency and the metadata bytes per function
+
+Example, 10k to 100k functions, a quarter of them noexcept:
+
+    tools/workload_sweep.py --functions 10000 30000 100000 \\
+        --workload-options "--noexcept-ratio 0.25" \\
+        --analyzer build/tools/exception_analyzer
+"""
+
+import argparse
+import csv
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+SOURCE_DIR = Path(__file__).resolve().parent.parent
+
+# Flash of the netduino2 machine, larger images cannot be run in QEMU
+QEMU_FLASH_BYTES = 1024 * 1024
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--functions", nargs="+", type=int, required=True,
+                        help="function counts to generate")
+    parser.add_argument("--workload-options", default="",
+                        help="further tools/generate_workload.py arguments")
+    parser.add_argument("--gcc", default="12.3",
+                        help="GCC release, needs profiles/gcc-<version>")
+    parser.add_argument("--arch", default="cortex-m3",
+                        help="conan arch setting")
+    parser.add_argument("--optimization", default="build_type",
+                        choices=["build_type", "Os", "O2", "O3"])
+    parser.add_argument("--analyzer", type=Path, required=True,
+                        help="path to the exception_analyzer executable")
+    parser.add_argument("--build-dir", type=Path,
+                        default=SOURCE_DIR / "build" / "workload")
+    parser.add_argument("--output", type=Path,
+                        default=SOURCE_DIR / "csv" / "workload")
+    parser.add_argument("--no-run", action="store_true",
+                        help="only build and analyze, never start QEMU")
+    return parser.parse_args()
+
+
+def build(arguments, functions, build_dir):
+    """Build workload.elf and return its path, None if the build failed"""
+    command = [
+        "conan", "build", str(SOURCE_DIR), "--build=missing",
+        "--output-folder", str(build_dir),
+        "-pr", str(SOURCE_DIR / "baremetal.profile"),
+        "-pr", str(SOURCE_DIR / "profiles" / f"gcc-{arguments.gcc}"),
+        "-s", f"arch={arguments.arch}",
+        "-o", f"&:optimization={arguments.optimization}",
+        "-o", f"&:workload_functions={functions}",
+        "-o", f"&:workload_options={arguments.workload_options}",
+    ]
+    print(f"==> {functions} functions", flush=True)
+    if subprocess.run(command).returncode != 0:
+        return None
+    images = sorted(build_dir.rglob("workload.elf"))
+    return images[0] if images else None
+
+
+def read_csv(path):
+    with open(path, newline="") as file:
+        return list(csv.DictReader(file))
+
+
+def run(image, output):
+    """Run image in QEMU and copy its workload_latency.csv to output"""
+    results = SOURCE_DIR / "csv" / "qemu" / "workload_latency.csv"
+    results.unlink(missing_ok=True)
+    command = ["cmake", "--build", str(image.parent),
+               "--target", "run_workload"]
+    if subprocess.run(command).returncode != 0 or not results.exists():
+        return None
+    shutil.copy(results, output / "workload_latency.csv")
+    return read_csv(results)[0]
+
+
+def summary_row(functions, image, arguments):
+    row = {"functions": functions, "status": "ok"}
+    if image is None:
+        row["status"] = "no_image"
+        return row
+
+    output = arguments.output / str(functions)
+    subprocess.run([str(arguments.analyzer), str(image), str(output)],
+                   check=True)
+    sections = {entry["section"]: int(entry["size"])
+                for entry in read_csv(output / "exception_sections.csv")}
+    text = sections.get("text", 0)
+    exidx = sections.get("exidx", 0)
+    extab = sections.get("extab", 0)
+    row.update({
+        "text": text,
+        "exidx": exidx,
+        "extab": extab,
+        "exidx_per_function": f"{exidx / functions:.2f}",
+        "extab_per_function": f"{extab / functions:.2f}",
+        "metadata_share": f"{(exidx + extab) / max(text, 1):.4f}",
+    })
+
+    if arguments.no_run:
+        return row
+    if text + exidx + extab > QEMU_FLASH_BYTES:
+        row["status"] = "too_large_to_run"
+        return row
+    latency = run(image, output)
+    if latency is None:
+        row["status"] = "run_failed"
+        return row
+    row.update({
+        "throw_depth": latency["throw_depth"],
+        "happy_path": latency["happy_path"],
+        "throw_path": latency["throw_path"],
+        "unit": latency["unit"],
+    })
+    return row
+
+
+def main():
+    arguments = parse_arguments()
+    arguments.output.mkdir(parents=True, exist_ok=True)
+
+    rows = []
+    for functions in sorted(arguments.functions):
+        image = build(arguments, functions,
+                      arguments.build_dir / str(functions))
+        rows.append(summary_row(functions, image, arguments))
+
+    fields = ["functions", "status", "text", "exidx", "extab",
+              "exidx_per_function", "extab_per_function", "metadata_share",
+              "throw_depth", "happy_path", "throw_path", "unit"]
+    summary_path = arguments.output / "summary.csv"
+    with open(summary_path, "w", newline="") as file:
+        writer = csv.DictWriter(file, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(rows)
+
+    print(f"summary: {summary_path}")
+    return 0 if all(row["status"] != "no_image" for row in rows) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())